@@ -0,0 +1,225 @@
+/*
+** Host stand-in for the cFE and OSAL APIs used by the Security App
+**
+** Declares the subset of cFE 6 (SB, EVS, ES, TBL, FS, PSP timebase) and
+** OSAL (semaphores, task delay, files) calls the app makes, with the same
+** names and signatures, so the app sources build unchanged as a Linux
+** executable. cfe_host.c implements them on pthreads: the Software Bus is an
+** in-process queue per pipe, child tasks are threads, and tables load from
+** the images the table sources register through CFE_TBL_FILEDEF. Status
+** values are this stub's own; compare against the names only.
+**
+** Hooks for the program driving the app are in cfe_host.h.
+*/
+#ifndef CFE_H
+#define CFE_H
+
+#include "common_types.h"
+
+/* The app, like most cFS apps, gets the C string functions through cfe.h */
+#include <stdio.h>
+#include <string.h>
+
+/*
+** OSAL
+*/
+#define OS_MAX_API_NAME             20
+#define OS_MAX_PATH_LEN             64
+
+#define OS_SUCCESS                  0
+#define OS_ERROR                    (-1)
+#define OS_INVALID_POINTER          (-2)
+#define OS_SEM_FAILURE              (-6)
+#define OS_SEM_TIMEOUT              (-7)
+#define OS_ERR_NO_FREE_IDS          (-35)
+#define OS_FS_ERROR                 (-1)
+
+#define OS_READ_ONLY                0
+#define OS_WRITE_ONLY               1
+#define OS_READ_WRITE               2
+
+#define OS_SEEK_SET                 0
+#define OS_SEEK_CUR                 1
+#define OS_SEEK_END                 2
+
+int32 OS_BinSemCreate(uint32 *sem_id, const char *sem_name, uint32 sem_initial_value, uint32 options);
+int32 OS_BinSemGive(uint32 sem_id);
+int32 OS_BinSemTake(uint32 sem_id);
+int32 OS_BinSemTimedWait(uint32 sem_id, uint32 msecs);
+int32 OS_CountSemCreate(uint32 *sem_id, const char *sem_name, uint32 sem_initial_value, uint32 options);
+int32 OS_CountSemGive(uint32 sem_id);
+int32 OS_CountSemTake(uint32 sem_id);
+int32 OS_CountSemTimedWait(uint32 sem_id, uint32 msecs);
+int32 OS_TaskDelay(uint32 millisecond);
+
+int32 OS_open(const char *path, int32 access, uint32 mode);
+int32 OS_creat(const char *path, int32 access);
+int32 OS_close(int32 filedes);
+int32 OS_read(int32 filedes, void *buffer, uint32 nbytes);
+int32 OS_write(int32 filedes, const void *buffer, uint32 nbytes);
+int32 OS_lseek(int32 filedes, int32 offset, uint32 whence);
+int32 OS_remove(const char *path);
+
+/*
+** cFE status codes
+*/
+#define CFE_SUCCESS                 ((int32)0)
+#define CFE_ES_ERR_APP_REGISTER     ((int32)0xC4000017)
+#define CFE_ES_ERR_CHILD_TASK_CREATE ((int32)0xC4000018)
+#define CFE_ES_CDS_ALREADY_EXISTS   ((int32)0x4400000D)
+#define CFE_ES_CDS_INVALID_SIZE     ((int32)0xC4000023)
+#define CFE_ES_CDS_INVALID          ((int32)0xC4000026)
+#define CFE_EVS_APP_FILTER_OVERLOAD ((int32)0xC2000001)
+#define CFE_SB_TIME_OUT             ((int32)0xCA000001)
+#define CFE_SB_NO_MESSAGE           ((int32)0xCA000002)
+#define CFE_SB_BAD_ARGUMENT         ((int32)0xCA000003)
+#define CFE_SB_MAX_PIPES_MET        ((int32)0xCA000004)
+#define CFE_SB_MAX_DESTS_MET        ((int32)0xCA00000B)
+#define CFE_SB_BUF_ALOC_ERR         ((int32)0xCA00000D)
+#define CFE_TBL_INFO_UPDATED        ((int32)0x4C000004)
+#define CFE_TBL_ERR_INVALID_HANDLE  ((int32)0xCC000001)
+#define CFE_TBL_ERR_REGISTRY_FULL   ((int32)0xCC000005)
+#define CFE_TBL_ERR_FILE_NOT_FOUND  ((int32)0xCC00000A)
+#define CFE_TBL_ERR_INVALID_SIZE    ((int32)0xCC00000B)
+#define CFE_TBL_ERR_VALIDATION      ((int32)0xCC000022)
+
+/*
+** Executive services
+*/
+#define CFE_ES_RunStatus_APP_RUN    1
+#define CFE_ES_RunStatus_APP_EXIT   2
+#define CFE_ES_RunStatus_APP_ERROR  3
+
+typedef void (*CFE_ES_ChildTaskMainFuncPtr_t)(void);
+typedef uint32 CFE_ES_CDSHandle_t;
+
+int32 CFE_ES_RegisterApp(void);
+bool  CFE_ES_RunLoop(uint32 *RunStatus);
+void  CFE_ES_ExitApp(uint32 ExitStatus);
+int32 CFE_ES_RegisterChildTask(void);
+void  CFE_ES_ExitChildTask(void);
+int32 CFE_ES_CreateChildTask(uint32 *TaskIdPtr, const char *TaskName, CFE_ES_ChildTaskMainFuncPtr_t FunctionPtr,
+                             uint32 *StackPtr, uint32 StackSize, uint32 Priority, uint32 Flags);
+int32 CFE_ES_WriteToSysLog(const char *SpecStringPtr, ...);
+
+/* Critical data store: blocks live for the life of the process, so they outlast an app restart */
+int32 CFE_ES_RegisterCDS(CFE_ES_CDSHandle_t *HandlePtr, int32 BlockSize, const char *Name);
+int32 CFE_ES_CopyToCDS(CFE_ES_CDSHandle_t Handle, void *DataToCopy);
+int32 CFE_ES_RestoreFromCDS(void *RestoreToMemory, CFE_ES_CDSHandle_t Handle);
+
+/*
+** Event services
+*/
+#define CFE_EVS_DEBUG               1
+#define CFE_EVS_INFORMATION         2
+#define CFE_EVS_ERROR               3
+#define CFE_EVS_CRITICAL            4
+
+#define CFE_EVS_EventFilter_BINARY  0
+#define CFE_EVS_NO_FILTER           0x0000
+#define CFE_EVS_FIRST_ONE_STOP      0xFFFF
+
+typedef struct
+{
+    uint16  EventID;
+    uint16  Mask;
+
+} CFE_EVS_BinFilter_t;
+
+int32 CFE_EVS_Register(void *Filters, uint16 NumEventFilters, uint16 FilterScheme);
+int32 CFE_EVS_SendEvent(uint16 EventID, uint16 EventType, const char *Spec, ...);
+
+/*
+** Software Bus
+**
+** Messages carry a CCSDS primary header (stream ID, sequence, length) and a
+** command (function code, checksum) or telemetry (time) secondary header.
+*/
+#define CFE_SB_CMD_HDR_SIZE         8
+#define CFE_SB_TLM_HDR_SIZE         12
+#define CFE_SB_MAX_SB_MSG_SIZE      32768
+
+#define CFE_SB_POLL                 0
+#define CFE_SB_PEND_FOREVER         (-1)
+
+typedef uint16 CFE_SB_MsgId_t;
+typedef uint32 CFE_SB_PipeId_t;
+
+typedef union
+{
+    uint8   Byte[CFE_SB_CMD_HDR_SIZE];
+    uint16  Word[CFE_SB_CMD_HDR_SIZE / 2];
+
+} CFE_SB_Msg_t;
+
+typedef CFE_SB_Msg_t *CFE_SB_MsgPtr_t;
+typedef void *CFE_SB_ZeroCopyHandle_t;
+
+int32 CFE_SB_CreatePipe(CFE_SB_PipeId_t *PipeIdPtr, uint16 Depth, const char *PipeName);
+int32 CFE_SB_Subscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId);
+int32 CFE_SB_Unsubscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId);
+int32 CFE_SB_RcvMsg(CFE_SB_MsgPtr_t *BufPtr, CFE_SB_PipeId_t PipeId, int32 TimeOut);
+int32 CFE_SB_SendMsg(CFE_SB_MsgPtr_t MsgPtr);
+CFE_SB_MsgPtr_t CFE_SB_ZeroCopyGetPtr(uint16 MsgSize, CFE_SB_ZeroCopyHandle_t *BufferHandle);
+int32 CFE_SB_ZeroCopySend(CFE_SB_MsgPtr_t MsgPtr, CFE_SB_ZeroCopyHandle_t BufferHandle);
+int32 CFE_SB_ZeroCopyReleasePtr(CFE_SB_MsgPtr_t Ptr2Release, CFE_SB_ZeroCopyHandle_t BufferHandle);
+
+void CFE_SB_InitMsg(void *MsgPtr, CFE_SB_MsgId_t MsgId, uint16 Length, bool Clear);
+CFE_SB_MsgId_t CFE_SB_GetMsgId(CFE_SB_MsgPtr_t MsgPtr);
+void CFE_SB_SetMsgId(CFE_SB_MsgPtr_t MsgPtr, CFE_SB_MsgId_t MsgId);
+uint16 CFE_SB_GetCmdCode(CFE_SB_MsgPtr_t MsgPtr);
+int32 CFE_SB_SetCmdCode(CFE_SB_MsgPtr_t MsgPtr, uint16 CmdCode);
+uint16 CFE_SB_GetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr);
+void CFE_SB_SetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr, uint16 TotalLength);
+void CFE_SB_TimeStampMsg(CFE_SB_MsgPtr_t MsgPtr);
+
+/*
+** Table services
+*/
+#define CFE_TBL_OPT_DEFAULT         0x0000
+
+typedef int16 CFE_TBL_Handle_t;
+typedef int32 (*CFE_TBL_CallbackFuncPtr_t)(void *TblPtr);
+
+typedef enum
+{
+    CFE_TBL_SRC_FILE = 0,
+    CFE_TBL_SRC_ADDRESS
+
+} CFE_TBL_SrcEnum_t;
+
+int32 CFE_TBL_Register(CFE_TBL_Handle_t *TblHandlePtr, const char *Name, uint32 Size, uint16 TblOptionFlags,
+                       CFE_TBL_CallbackFuncPtr_t TblValidationFuncPtr);
+int32 CFE_TBL_Load(CFE_TBL_Handle_t TblHandle, CFE_TBL_SrcEnum_t SrcType, const void *SrcDataPtr);
+int32 CFE_TBL_GetAddress(void **TblPtr, CFE_TBL_Handle_t TblHandle);
+int32 CFE_TBL_ReleaseAddress(CFE_TBL_Handle_t TblHandle);
+int32 CFE_TBL_Manage(CFE_TBL_Handle_t TblHandle);
+
+/*
+** File services
+*/
+#define CFE_FS_FILE_CONTENT_ID      0x63464531  /* 'cFE1' */
+
+typedef struct
+{
+    uint32  ContentType;
+    uint32  SubType;
+    uint32  Length;
+    uint32  SpacecraftID;
+    uint32  ProcessorID;
+    uint32  ApplicationID;
+    uint32  TimeSeconds;
+    uint32  TimeSubSeconds;
+    char    Description[32];
+
+} CFE_FS_Header_t;
+
+int32 CFE_FS_WriteHeader(int32 FileDes, CFE_FS_Header_t *Hdr);
+
+/*
+** Platform timebase: nanoseconds of CLOCK_MONOTONIC
+*/
+void CFE_PSP_Get_Timebase(uint32 *Tbu, uint32 *Tbl);
+uint32 CFE_PSP_GetTimerTicksPerSecond(void);
+
+#endif /* CFE_H */
@@ -0,0 +1,1037 @@
+/*
+** Host implementation of the cFE and OSAL calls declared in cfe.h
+**
+** Everything runs in one process. The Software Bus keeps a bounded FIFO of
+** message copies per pipe; a send to a full pipe drops the copy and counts
+** it, as cFE does. A buffer returned by CFE_SB_RcvMsg stays valid until the
+** next receive on the same pipe. Child tasks are detached pthreads (task
+** priorities and stack sizes are ignored) and semaphores are mutex and
+** condition variable pairs. One lock guards all SB and table state, which is
+** plenty for a single app.
+*/
+#define _GNU_SOURCE
+#include "cfe.h"
+#include "cfe_host.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HOST_MAX_PIPES      8
+#define HOST_MAX_ROUTES     64
+#define HOST_MAX_SEMS       64
+#define HOST_MAX_TABLES     8
+#define HOST_MAX_TBL_FILES  8
+#define HOST_MAX_FILTERS    32
+#define HOST_MAX_TASKS      32
+#define HOST_MAX_CDS        4
+
+typedef struct {
+    int              used;
+    char             name[OS_MAX_API_NAME];
+    uint16           depth;
+    uint16           head;
+    uint16           count;
+    CFE_SB_MsgPtr_t *queue;
+    CFE_SB_MsgPtr_t  current;           /* Handed out by the last receive */
+    pthread_cond_t   nonempty;
+    cfe_host_pipe_stats_t stats;
+} host_pipe_t;
+
+typedef struct {
+    CFE_SB_MsgId_t   msg_id;
+    CFE_SB_PipeId_t  pipe_id;
+} host_route_t;
+
+typedef struct {
+    int              used;
+    int              binary;
+    uint32           value;
+    pthread_mutex_t  lock;
+    pthread_cond_t   posted;
+} host_sem_t;
+
+typedef struct {
+    int              used;
+    char             name[OS_MAX_API_NAME];
+    uint32           size;
+    void            *data;
+    int              updated;           /* Loaded since the last CFE_TBL_GetAddress */
+    CFE_TBL_CallbackFuncPtr_t validate;
+} host_tbl_t;
+
+typedef struct {
+    char             name[OS_MAX_PATH_LEN];
+    const void      *image;
+    uint32           size;
+} host_tbl_file_t;
+
+typedef struct {
+    char             name[OS_MAX_API_NAME];
+    int32            size;
+    void            *data;
+} host_cds_t;
+
+typedef struct {
+    CFE_ES_ChildTaskMainFuncPtr_t entry;
+    char             name[16];
+} host_task_t;
+
+static pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static host_pipe_t     host_pipes[HOST_MAX_PIPES];
+static host_route_t    host_routes[HOST_MAX_ROUTES];
+static int             host_route_count;
+static cfe_host_sink_t host_sink;
+static void           *host_sink_arg;
+
+static host_sem_t      host_sems[HOST_MAX_SEMS];
+static pthread_mutex_t host_sem_alloc = PTHREAD_MUTEX_INITIALIZER;
+
+static host_tbl_t      host_tables[HOST_MAX_TABLES];
+static host_tbl_file_t host_tbl_files[HOST_MAX_TBL_FILES];
+
+static CFE_EVS_BinFilter_t host_filters[HOST_MAX_FILTERS];
+static uint16          host_filter_counts[HOST_MAX_FILTERS];
+static int             host_filter_count;
+static uint32          host_event_counts[CFE_EVS_CRITICAL + 1];
+static int             host_verbose;
+
+static host_task_t     host_tasks[HOST_MAX_TASKS];
+static uint32          host_task_count;
+static volatile int    host_stopping;
+
+static host_cds_t      host_cds[HOST_MAX_CDS];
+
+static uint64 host_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64)ts.tv_sec * 1000000000ULL + (uint64)ts.tv_nsec;
+}
+
+/* Absolute CLOCK_MONOTONIC deadline msecs from now, for condition waits */
+static void host_deadline(struct timespec *ts, uint32 msecs)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += msecs / 1000;
+    ts->tv_nsec += (long)(msecs % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/*
+** Hooks
+*/
+void cfe_host_set_sink(cfe_host_sink_t sink, void *arg)
+{
+    pthread_mutex_lock(&host_lock);
+    host_sink = sink;
+    host_sink_arg = arg;
+    pthread_mutex_unlock(&host_lock);
+}
+
+void cfe_host_set_verbose(int verbose)
+{
+    host_verbose = verbose;
+}
+
+uint32 cfe_host_event_count(uint16 event_type)
+{
+    return (event_type <= CFE_EVS_CRITICAL) ? __atomic_load_n(&host_event_counts[event_type], __ATOMIC_RELAXED) : 0;
+}
+
+int cfe_host_pipe_stats(const char *pipe_name, cfe_host_pipe_stats_t *stats)
+{
+    int i;
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < HOST_MAX_PIPES; i++) {
+        if (host_pipes[i].used && strcmp(host_pipes[i].name, pipe_name) == 0) {
+            *stats = host_pipes[i].stats;
+            stats->queued = host_pipes[i].count;
+            pthread_mutex_unlock(&host_lock);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+
+    return -1;
+}
+
+void cfe_host_stop(void)
+{
+    host_stopping = 1;
+}
+
+void cfe_host_tbl_file(const char *file_name, const void *image, uint32 size)
+{
+    int i;
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < HOST_MAX_TBL_FILES; i++) {
+        if (host_tbl_files[i].image == NULL || strcmp(host_tbl_files[i].name, file_name) == 0) {
+            snprintf(host_tbl_files[i].name, sizeof(host_tbl_files[i].name), "%s", file_name);
+            host_tbl_files[i].image = image;
+            host_tbl_files[i].size = size;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+}
+
+/*
+** OSAL semaphores and delay
+*/
+static int32 host_sem_create(uint32 *sem_id, uint32 initial, int binary)
+{
+    uint32 i;
+
+    pthread_mutex_lock(&host_sem_alloc);
+    for (i = 0; i < HOST_MAX_SEMS; i++) {
+        if (!host_sems[i].used) {
+            host_sems[i].used = 1;
+            host_sems[i].binary = binary;
+            host_sems[i].value = (binary && initial > 1) ? 1 : initial;
+            pthread_mutex_init(&host_sems[i].lock, NULL);
+            host_cond_init(&host_sems[i].posted);
+            *sem_id = i;
+            pthread_mutex_unlock(&host_sem_alloc);
+            return OS_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&host_sem_alloc);
+
+    return OS_ERR_NO_FREE_IDS;
+}
+
+static int32 host_sem_give(uint32 sem_id)
+{
+    host_sem_t *sem;
+
+    if (sem_id >= HOST_MAX_SEMS || !host_sems[sem_id].used) {
+        return OS_ERROR;
+    }
+    sem = &host_sems[sem_id];
+
+    pthread_mutex_lock(&sem->lock);
+    if (!sem->binary || sem->value == 0) {
+        sem->value++;
+    }
+    pthread_cond_signal(&sem->posted);
+    pthread_mutex_unlock(&sem->lock);
+
+    return OS_SUCCESS;
+}
+
+/* msecs < 0 waits forever */
+static int32 host_sem_take(uint32 sem_id, int32 msecs)
+{
+    host_sem_t *sem;
+    struct timespec deadline;
+    int rc = 0;
+
+    if (sem_id >= HOST_MAX_SEMS || !host_sems[sem_id].used) {
+        return OS_ERROR;
+    }
+    sem = &host_sems[sem_id];
+
+    if (msecs >= 0) {
+        host_deadline(&deadline, (uint32)msecs);
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->value == 0 && rc != ETIMEDOUT) {
+        rc = (msecs < 0) ? pthread_cond_wait(&sem->posted, &sem->lock)
+                         : pthread_cond_timedwait(&sem->posted, &sem->lock, &deadline);
+    }
+    if (sem->value == 0) {
+        pthread_mutex_unlock(&sem->lock);
+        return OS_SEM_TIMEOUT;
+    }
+    sem->value--;
+    pthread_mutex_unlock(&sem->lock);
+
+    return OS_SUCCESS;
+}
+
+int32 OS_BinSemCreate(uint32 *sem_id, const char *sem_name, uint32 sem_initial_value, uint32 options)
+{
+    return host_sem_create(sem_id, sem_initial_value, 1);
+}
+
+int32 OS_BinSemGive(uint32 sem_id)
+{
+    return host_sem_give(sem_id);
+}
+
+int32 OS_BinSemTake(uint32 sem_id)
+{
+    return host_sem_take(sem_id, -1);
+}
+
+int32 OS_BinSemTimedWait(uint32 sem_id, uint32 msecs)
+{
+    return host_sem_take(sem_id, (int32)msecs);
+}
+
+int32 OS_CountSemCreate(uint32 *sem_id, const char *sem_name, uint32 sem_initial_value, uint32 options)
+{
+    return host_sem_create(sem_id, sem_initial_value, 0);
+}
+
+int32 OS_CountSemGive(uint32 sem_id)
+{
+    return host_sem_give(sem_id);
+}
+
+int32 OS_CountSemTake(uint32 sem_id)
+{
+    return host_sem_take(sem_id, -1);
+}
+
+int32 OS_CountSemTimedWait(uint32 sem_id, uint32 msecs)
+{
+    return host_sem_take(sem_id, (int32)msecs);
+}
+
+int32 OS_TaskDelay(uint32 millisecond)
+{
+    struct timespec ts = { millisecond / 1000, (long)(millisecond % 1000) * 1000000L };
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+
+    return OS_SUCCESS;
+}
+
+/*
+** OSAL files map straight onto POSIX descriptors
+*/
+static int host_open_flags(int32 access)
+{
+    switch (access) {
+    case OS_WRITE_ONLY:
+        return O_WRONLY;
+    case OS_READ_WRITE:
+        return O_RDWR;
+    default:
+        return O_RDONLY;
+    }
+}
+
+int32 OS_open(const char *path, int32 access, uint32 mode)
+{
+    int fd = open(path, host_open_flags(access));
+
+    return (fd < 0) ? OS_FS_ERROR : fd;
+}
+
+int32 OS_creat(const char *path, int32 access)
+{
+    int fd = open(path, host_open_flags(access) | O_CREAT | O_TRUNC, 0644);
+
+    return (fd < 0) ? OS_FS_ERROR : fd;
+}
+
+int32 OS_close(int32 filedes)
+{
+    return (close(filedes) == 0) ? OS_SUCCESS : OS_FS_ERROR;
+}
+
+int32 OS_read(int32 filedes, void *buffer, uint32 nbytes)
+{
+    ssize_t n = read(filedes, buffer, nbytes);
+
+    return (n < 0) ? OS_FS_ERROR : (int32)n;
+}
+
+int32 OS_write(int32 filedes, const void *buffer, uint32 nbytes)
+{
+    ssize_t n = write(filedes, buffer, nbytes);
+
+    return (n < 0) ? OS_FS_ERROR : (int32)n;
+}
+
+int32 OS_lseek(int32 filedes, int32 offset, uint32 whence)
+{
+    static const int whences[] = { SEEK_SET, SEEK_CUR, SEEK_END };
+    off_t pos;
+
+    if (whence > OS_SEEK_END) {
+        return OS_FS_ERROR;
+    }
+    pos = lseek(filedes, offset, whences[whence]);
+
+    return (pos < 0) ? OS_FS_ERROR : (int32)pos;
+}
+
+int32 OS_remove(const char *path)
+{
+    return (remove(path) == 0) ? OS_SUCCESS : OS_FS_ERROR;
+}
+
+/*
+** Executive services
+*/
+int32 CFE_ES_RegisterApp(void)
+{
+    return CFE_SUCCESS;
+}
+
+bool CFE_ES_RunLoop(uint32 *RunStatus)
+{
+    if (host_stopping && *RunStatus == CFE_ES_RunStatus_APP_RUN) {
+        *RunStatus = CFE_ES_RunStatus_APP_EXIT;
+    }
+
+    return *RunStatus == CFE_ES_RunStatus_APP_RUN;
+}
+
+/* On target this never returns; here the app's main function returns after it */
+void CFE_ES_ExitApp(uint32 ExitStatus)
+{
+    if (ExitStatus != CFE_ES_RunStatus_APP_EXIT) {
+        fprintf(stderr, "cfe_host: app exited with run status %u\n", (unsigned int)ExitStatus);
+    }
+}
+
+int32 CFE_ES_RegisterChildTask(void)
+{
+    return CFE_SUCCESS;
+}
+
+void CFE_ES_ExitChildTask(void)
+{
+    pthread_exit(NULL);
+}
+
+static void *host_task_main(void *arg)
+{
+    host_task_t *task = arg;
+
+    pthread_setname_np(pthread_self(), task->name);
+    task->entry();
+
+    return NULL;
+}
+
+int32 CFE_ES_CreateChildTask(uint32 *TaskIdPtr, const char *TaskName, CFE_ES_ChildTaskMainFuncPtr_t FunctionPtr,
+                             uint32 *StackPtr, uint32 StackSize, uint32 Priority, uint32 Flags)
+{
+    host_task_t *task;
+    pthread_t thread;
+    uint32 id = __atomic_fetch_add(&host_task_count, 1, __ATOMIC_RELAXED);
+
+    if (id >= HOST_MAX_TASKS) {
+        return CFE_ES_ERR_CHILD_TASK_CREATE;
+    }
+    task = &host_tasks[id];
+    task->entry = FunctionPtr;
+    snprintf(task->name, sizeof(task->name), "%s", TaskName);
+
+    if (pthread_create(&thread, NULL, host_task_main, task) != 0) {
+        return CFE_ES_ERR_CHILD_TASK_CREATE;
+    }
+    pthread_detach(thread);
+    *TaskIdPtr = id;
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_ES_WriteToSysLog(const char *SpecStringPtr, ...)
+{
+    va_list ap;
+
+    va_start(ap, SpecStringPtr);
+    vfprintf(stderr, SpecStringPtr, ap);
+    va_end(ap);
+
+    return CFE_SUCCESS;
+}
+
+/* A block registered again with the same name and size is kept, as after a processor reset */
+int32 CFE_ES_RegisterCDS(CFE_ES_CDSHandle_t *HandlePtr, int32 BlockSize, const char *Name)
+{
+    host_cds_t *cds;
+    int32 status = CFE_ES_CDS_INVALID;
+    uint32 i;
+
+    if (BlockSize <= 0) {
+        return CFE_ES_CDS_INVALID_SIZE;
+    }
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < HOST_MAX_CDS; i++) {
+        cds = &host_cds[i];
+        if (cds->data != NULL && strncmp(cds->name, Name, sizeof(cds->name)) == 0) {
+            status = (cds->size == BlockSize) ? CFE_ES_CDS_ALREADY_EXISTS : CFE_ES_CDS_INVALID_SIZE;
+            break;
+        }
+        if (cds->data == NULL) {
+            cds->data = calloc(1, BlockSize);
+            if (cds->data != NULL) {
+                snprintf(cds->name, sizeof(cds->name), "%s", Name);
+                cds->size = BlockSize;
+                status = CFE_SUCCESS;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+
+    if (status == CFE_SUCCESS || status == CFE_ES_CDS_ALREADY_EXISTS) {
+        *HandlePtr = i;
+    }
+
+    return status;
+}
+
+int32 CFE_ES_CopyToCDS(CFE_ES_CDSHandle_t Handle, void *DataToCopy)
+{
+    if (Handle >= HOST_MAX_CDS || host_cds[Handle].data == NULL) {
+        return CFE_ES_CDS_INVALID;
+    }
+    memcpy(host_cds[Handle].data, DataToCopy, host_cds[Handle].size);
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_ES_RestoreFromCDS(void *RestoreToMemory, CFE_ES_CDSHandle_t Handle)
+{
+    if (Handle >= HOST_MAX_CDS || host_cds[Handle].data == NULL) {
+        return CFE_ES_CDS_INVALID;
+    }
+    memcpy(RestoreToMemory, host_cds[Handle].data, host_cds[Handle].size);
+
+    return CFE_SUCCESS;
+}
+
+/*
+** Event services, with the binary filter scheme: an event is sent while
+** (times seen & Mask) is zero
+*/
+int32 CFE_EVS_Register(void *Filters, uint16 NumEventFilters, uint16 FilterScheme)
+{
+    if (NumEventFilters > HOST_MAX_FILTERS) {
+        return CFE_EVS_APP_FILTER_OVERLOAD;
+    }
+
+    memcpy(host_filters, Filters, NumEventFilters * sizeof(CFE_EVS_BinFilter_t));
+    memset(host_filter_counts, 0, sizeof(host_filter_counts));
+    host_filter_count = NumEventFilters;
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_EVS_SendEvent(uint16 EventID, uint16 EventType, const char *Spec, ...)
+{
+    static const char *type_names[] = { "?", "DEBUG", "INFO", "ERROR", "CRIT" };
+    va_list ap;
+    int send = 1;
+    int i;
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < host_filter_count; i++) {
+        if (host_filters[i].EventID == EventID) {
+            send = (host_filter_counts[i] & host_filters[i].Mask) == 0;
+            if (host_filter_counts[i] < 0xFFFF) {
+                host_filter_counts[i]++;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+
+    if (!send) {
+        return CFE_SUCCESS;
+    }
+    if (EventType <= CFE_EVS_CRITICAL) {
+        __atomic_fetch_add(&host_event_counts[EventType], 1, __ATOMIC_RELAXED);
+    }
+
+    if (host_verbose) {
+        va_start(ap, Spec);
+        fprintf(stderr, "EVS %-5s %3u: ", type_names[EventType <= CFE_EVS_CRITICAL ? EventType : 0],
+                (unsigned int)EventID);
+        vfprintf(stderr, Spec, ap);
+        fputc('\n', stderr);
+        va_end(ap);
+    }
+
+    return CFE_SUCCESS;
+}
+
+/*
+** Software Bus message headers
+*/
+void CFE_SB_InitMsg(void *MsgPtr, CFE_SB_MsgId_t MsgId, uint16 Length, bool Clear)
+{
+    uint8 *hdr = MsgPtr;
+
+    if (Clear) {
+        memset(hdr, 0, Length);
+    } else {
+        memset(hdr, 0, CFE_SB_CMD_HDR_SIZE);
+    }
+    CFE_SB_SetMsgId(MsgPtr, MsgId);
+    hdr[2] = 0xC0;                      /* Unsegmented */
+    CFE_SB_SetTotalMsgLength(MsgPtr, Length);
+}
+
+CFE_SB_MsgId_t CFE_SB_GetMsgId(CFE_SB_MsgPtr_t MsgPtr)
+{
+    return (CFE_SB_MsgId_t)((MsgPtr->Byte[0] << 8) | MsgPtr->Byte[1]);
+}
+
+void CFE_SB_SetMsgId(CFE_SB_MsgPtr_t MsgPtr, CFE_SB_MsgId_t MsgId)
+{
+    MsgPtr->Byte[0] = (uint8)(MsgId >> 8);
+    MsgPtr->Byte[1] = (uint8)MsgId;
+}
+
+uint16 CFE_SB_GetCmdCode(CFE_SB_MsgPtr_t MsgPtr)
+{
+    return MsgPtr->Byte[6] & 0x7F;
+}
+
+int32 CFE_SB_SetCmdCode(CFE_SB_MsgPtr_t MsgPtr, uint16 CmdCode)
+{
+    MsgPtr->Byte[6] = (uint8)(CmdCode & 0x7F);
+
+    return CFE_SUCCESS;
+}
+
+uint16 CFE_SB_GetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr)
+{
+    return (uint16)(((MsgPtr->Byte[4] << 8) | MsgPtr->Byte[5]) + 7);
+}
+
+void CFE_SB_SetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr, uint16 TotalLength)
+{
+    uint16 field = (uint16)(TotalLength - 7);
+
+    MsgPtr->Byte[4] = (uint8)(field >> 8);
+    MsgPtr->Byte[5] = (uint8)field;
+}
+
+void CFE_SB_TimeStampMsg(CFE_SB_MsgPtr_t MsgPtr)
+{
+    uint8 *hdr = MsgPtr->Byte;
+    uint64 now = host_now_ns();
+    uint32 seconds = (uint32)(now / 1000000000ULL);
+    uint16 subseconds = (uint16)(((now % 1000000000ULL) << 16) / 1000000000ULL);
+
+    hdr[6] = (uint8)(seconds >> 24);
+    hdr[7] = (uint8)(seconds >> 16);
+    hdr[8] = (uint8)(seconds >> 8);
+    hdr[9] = (uint8)seconds;
+    hdr[10] = (uint8)(subseconds >> 8);
+    hdr[11] = (uint8)subseconds;
+}
+
+/*
+** Software Bus pipes and routing
+*/
+static CFE_SB_MsgPtr_t host_msg_alloc(uint16 size)
+{
+    void *buf;
+
+    /* Packets place their payloads on 16-byte boundaries */
+    if (posix_memalign(&buf, 16, size) != 0) {
+        return NULL;
+    }
+
+    return buf;
+}
+
+int32 CFE_SB_CreatePipe(CFE_SB_PipeId_t *PipeIdPtr, uint16 Depth, const char *PipeName)
+{
+    host_pipe_t *pipe;
+    int i;
+
+    if (PipeIdPtr == NULL || Depth == 0) {
+        return CFE_SB_BAD_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < HOST_MAX_PIPES && host_pipes[i].used; i++) {
+    }
+    if (i == HOST_MAX_PIPES) {
+        pthread_mutex_unlock(&host_lock);
+        return CFE_SB_MAX_PIPES_MET;
+    }
+
+    pipe = &host_pipes[i];
+    memset(pipe, 0, sizeof(*pipe));
+    pipe->queue = calloc(Depth, sizeof(CFE_SB_MsgPtr_t));
+    if (pipe->queue == NULL) {
+        pthread_mutex_unlock(&host_lock);
+        return CFE_SB_BUF_ALOC_ERR;
+    }
+    pipe->used = 1;
+    pipe->depth = Depth;
+    pipe->stats.depth = Depth;
+    snprintf(pipe->name, sizeof(pipe->name), "%s", PipeName);
+    host_cond_init(&pipe->nonempty);
+    *PipeIdPtr = i;
+    pthread_mutex_unlock(&host_lock);
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_SB_Subscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId)
+{
+    int i;
+
+    if (PipeId >= HOST_MAX_PIPES || !host_pipes[PipeId].used) {
+        return CFE_SB_BAD_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < host_route_count; i++) {
+        if (host_routes[i].msg_id == MsgId && host_routes[i].pipe_id == PipeId) {
+            pthread_mutex_unlock(&host_lock);
+            return CFE_SUCCESS;
+        }
+    }
+    if (host_route_count == HOST_MAX_ROUTES) {
+        pthread_mutex_unlock(&host_lock);
+        return CFE_SB_MAX_DESTS_MET;
+    }
+    host_routes[host_route_count].msg_id = MsgId;
+    host_routes[host_route_count].pipe_id = PipeId;
+    host_route_count++;
+    pthread_mutex_unlock(&host_lock);
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_SB_Unsubscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId)
+{
+    int i;
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < host_route_count; i++) {
+        if (host_routes[i].msg_id == MsgId && host_routes[i].pipe_id == PipeId) {
+            host_routes[i] = host_routes[--host_route_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&host_lock);
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_SB_RcvMsg(CFE_SB_MsgPtr_t *BufPtr, CFE_SB_PipeId_t PipeId, int32 TimeOut)
+{
+    host_pipe_t *pipe;
+    struct timespec deadline;
+    int rc = 0;
+
+    if (BufPtr == NULL || PipeId >= HOST_MAX_PIPES || !host_pipes[PipeId].used) {
+        return CFE_SB_BAD_ARGUMENT;
+    }
+    pipe = &host_pipes[PipeId];
+
+    if (TimeOut > 0) {
+        host_deadline(&deadline, (uint32)TimeOut);
+    }
+
+    pthread_mutex_lock(&host_lock);
+    free(pipe->current);
+    pipe->current = NULL;
+
+    while (pipe->count == 0 && TimeOut != CFE_SB_POLL && rc != ETIMEDOUT) {
+        rc = (TimeOut == CFE_SB_PEND_FOREVER) ? pthread_cond_wait(&pipe->nonempty, &host_lock)
+                                              : pthread_cond_timedwait(&pipe->nonempty, &host_lock, &deadline);
+    }
+    if (pipe->count == 0) {
+        pthread_mutex_unlock(&host_lock);
+        return (TimeOut == CFE_SB_POLL) ? CFE_SB_NO_MESSAGE : CFE_SB_TIME_OUT;
+    }
+
+    pipe->current = pipe->queue[pipe->head];
+    pipe->head = (uint16)((pipe->head + 1) % pipe->depth);
+    pipe->count--;
+    *BufPtr = pipe->current;
+    pthread_mutex_unlock(&host_lock);
+
+    return CFE_SUCCESS;
+}
+
+/* Copy a message to every subscribed pipe; returns 0 if nothing subscribes */
+static int host_route(CFE_SB_MsgPtr_t msg, uint16 length)
+{
+    CFE_SB_MsgId_t msg_id = CFE_SB_GetMsgId(msg);
+    CFE_SB_MsgPtr_t copy;
+    host_pipe_t *pipe;
+    int routed = 0;
+    int i;
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < host_route_count; i++) {
+        if (host_routes[i].msg_id != msg_id) {
+            continue;
+        }
+        routed = 1;
+        pipe = &host_pipes[host_routes[i].pipe_id];
+
+        if (pipe->count == pipe->depth || (copy = host_msg_alloc(length)) == NULL) {
+            pipe->stats.dropped++;
+            continue;
+        }
+        memcpy(copy, msg, length);
+        pipe->queue[(pipe->head + pipe->count) % pipe->depth] = copy;
+        pipe->count++;
+        pipe->stats.received++;
+        if (pipe->count > pipe->stats.high_water) {
+            pipe->stats.high_water = pipe->count;
+        }
+        pthread_cond_signal(&pipe->nonempty);
+    }
+    pthread_mutex_unlock(&host_lock);
+
+    return routed;
+}
+
+int32 CFE_SB_SendMsg(CFE_SB_MsgPtr_t MsgPtr)
+{
+    uint16 length = CFE_SB_GetTotalMsgLength(MsgPtr);
+    cfe_host_sink_t sink = host_sink;
+
+    if (length < CFE_SB_CMD_HDR_SIZE || length > CFE_SB_MAX_SB_MSG_SIZE) {
+        return CFE_SB_BAD_ARGUMENT;
+    }
+
+    if (!host_route(MsgPtr, length) && sink != NULL) {
+        sink(MsgPtr, host_sink_arg);
+    }
+
+    return CFE_SUCCESS;
+}
+
+CFE_SB_MsgPtr_t CFE_SB_ZeroCopyGetPtr(uint16 MsgSize, CFE_SB_ZeroCopyHandle_t *BufferHandle)
+{
+    CFE_SB_MsgPtr_t msg = host_msg_alloc(MsgSize);
+
+    *BufferHandle = msg;
+
+    return msg;
+}
+
+int32 CFE_SB_ZeroCopySend(CFE_SB_MsgPtr_t MsgPtr, CFE_SB_ZeroCopyHandle_t BufferHandle)
+{
+    int32 status = CFE_SB_SendMsg(MsgPtr);
+
+    free(BufferHandle);
+
+    return status;
+}
+
+int32 CFE_SB_ZeroCopyReleasePtr(CFE_SB_MsgPtr_t Ptr2Release, CFE_SB_ZeroCopyHandle_t BufferHandle)
+{
+    free(BufferHandle);
+
+    return CFE_SUCCESS;
+}
+
+/*
+** Table services: one buffer per table, loads validated on a copy first
+*/
+int32 CFE_TBL_Register(CFE_TBL_Handle_t *TblHandlePtr, const char *Name, uint32 Size, uint16 TblOptionFlags,
+                       CFE_TBL_CallbackFuncPtr_t TblValidationFuncPtr)
+{
+    host_tbl_t *tbl;
+    int i;
+
+    pthread_mutex_lock(&host_lock);
+    for (i = 0; i < HOST_MAX_TABLES && host_tables[i].used; i++) {
+    }
+    if (i == HOST_MAX_TABLES) {
+        pthread_mutex_unlock(&host_lock);
+        return CFE_TBL_ERR_REGISTRY_FULL;
+    }
+
+    tbl = &host_tables[i];
+    tbl->data = calloc(1, Size);
+    if (tbl->data == NULL) {
+        pthread_mutex_unlock(&host_lock);
+        return CFE_TBL_ERR_INVALID_SIZE;
+    }
+    tbl->used = 1;
+    tbl->size = Size;
+    tbl->updated = 0;
+    tbl->validate = TblValidationFuncPtr;
+    snprintf(tbl->name, sizeof(tbl->name), "%s", Name);
+    *TblHandlePtr = (CFE_TBL_Handle_t)i;
+    pthread_mutex_unlock(&host_lock);
+
+    return CFE_SUCCESS;
+}
+
+static host_tbl_t *host_tbl_get(CFE_TBL_Handle_t TblHandle)
+{
+    if (TblHandle < 0 || TblHandle >= HOST_MAX_TABLES || !host_tables[TblHandle].used) {
+        return NULL;
+    }
+
+    return &host_tables[TblHandle];
+}
+
+/* Image registered for a file, matched on the name after the last '/' */
+static const host_tbl_file_t *host_tbl_file_find(const char *path)
+{
+    const char *base = strrchr(path, '/');
+    int i;
+
+    base = (base != NULL) ? base + 1 : path;
+    for (i = 0; i < HOST_MAX_TBL_FILES && host_tbl_files[i].image != NULL; i++) {
+        if (strcmp(host_tbl_files[i].name, base) == 0) {
+            return &host_tbl_files[i];
+        }
+    }
+
+    return NULL;
+}
+
+int32 CFE_TBL_Load(CFE_TBL_Handle_t TblHandle, CFE_TBL_SrcEnum_t SrcType, const void *SrcDataPtr)
+{
+    host_tbl_t *tbl = host_tbl_get(TblHandle);
+    const host_tbl_file_t *file;
+    const void *image = SrcDataPtr;
+    void *staged;
+
+    if (tbl == NULL) {
+        return CFE_TBL_ERR_INVALID_HANDLE;
+    }
+
+    if (SrcType == CFE_TBL_SRC_FILE) {
+        pthread_mutex_lock(&host_lock);
+        file = host_tbl_file_find(SrcDataPtr);
+        pthread_mutex_unlock(&host_lock);
+        if (file == NULL) {
+            return CFE_TBL_ERR_FILE_NOT_FOUND;
+        }
+        if (file->size != tbl->size) {
+            return CFE_TBL_ERR_INVALID_SIZE;
+        }
+        image = file->image;
+    }
+
+    staged = malloc(tbl->size);
+    if (staged == NULL) {
+        return CFE_TBL_ERR_INVALID_SIZE;
+    }
+    memcpy(staged, image, tbl->size);
+    if (tbl->validate != NULL && tbl->validate(staged) != CFE_SUCCESS) {
+        free(staged);
+        return CFE_TBL_ERR_VALIDATION;
+    }
+
+    pthread_mutex_lock(&host_lock);
+    memcpy(tbl->data, staged, tbl->size);
+    tbl->updated = 1;
+    pthread_mutex_unlock(&host_lock);
+    free(staged);
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_TBL_GetAddress(void **TblPtr, CFE_TBL_Handle_t TblHandle)
+{
+    host_tbl_t *tbl = host_tbl_get(TblHandle);
+    int32 status = CFE_SUCCESS;
+
+    if (tbl == NULL) {
+        return CFE_TBL_ERR_INVALID_HANDLE;
+    }
+
+    pthread_mutex_lock(&host_lock);
+    *TblPtr = tbl->data;
+    if (tbl->updated) {
+        tbl->updated = 0;
+        status = CFE_TBL_INFO_UPDATED;
+    }
+    pthread_mutex_unlock(&host_lock);
+
+    return status;
+}
+
+int32 CFE_TBL_ReleaseAddress(CFE_TBL_Handle_t TblHandle)
+{
+    return (host_tbl_get(TblHandle) != NULL) ? CFE_SUCCESS : CFE_TBL_ERR_INVALID_HANDLE;
+}
+
+/* Loads apply at once here, so there is never anything pending to manage */
+int32 CFE_TBL_Manage(CFE_TBL_Handle_t TblHandle)
+{
+    return (host_tbl_get(TblHandle) != NULL) ? CFE_SUCCESS : CFE_TBL_ERR_INVALID_HANDLE;
+}
+
+/*
+** File services: the standard 64-byte header, big-endian
+*/
+static void host_put32(uint8 *p, uint32 value)
+{
+    p[0] = (uint8)(value >> 24);
+    p[1] = (uint8)(value >> 16);
+    p[2] = (uint8)(value >> 8);
+    p[3] = (uint8)value;
+}
+
+int32 CFE_FS_WriteHeader(int32 FileDes, CFE_FS_Header_t *Hdr)
+{
+    uint8 buf[sizeof(CFE_FS_Header_t)];
+    uint64 now = host_now_ns();
+
+    Hdr->ContentType = CFE_FS_FILE_CONTENT_ID;
+    Hdr->TimeSeconds = (uint32)(now / 1000000000ULL);
+    Hdr->TimeSubSeconds = (uint32)(((now % 1000000000ULL) << 32) / 1000000000ULL);
+
+    host_put32(&buf[0], Hdr->ContentType);
+    host_put32(&buf[4], Hdr->SubType);
+    host_put32(&buf[8], Hdr->Length);
+    host_put32(&buf[12], Hdr->SpacecraftID);
+    host_put32(&buf[16], Hdr->ProcessorID);
+    host_put32(&buf[20], Hdr->ApplicationID);
+    host_put32(&buf[24], Hdr->TimeSeconds);
+    host_put32(&buf[28], Hdr->TimeSubSeconds);
+    memcpy(&buf[32], Hdr->Description, sizeof(Hdr->Description));
+
+    return OS_write(FileDes, buf, sizeof(buf));
+}
+
+/*
+** Platform timebase
+*/
+void CFE_PSP_Get_Timebase(uint32 *Tbu, uint32 *Tbl)
+{
+    uint64 now = host_now_ns();
+
+    *Tbu = (uint32)(now >> 32);
+    *Tbl = (uint32)now;
+}
+
+uint32 CFE_PSP_GetTimerTicksPerSecond(void)
+{
+    return 1000000000U;
+}
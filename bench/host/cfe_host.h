@@ -0,0 +1,42 @@
+/*
+** Hooks into the host cFE stub for the program driving the app
+**
+** The driver sends commands with CFE_SB_SendMsg like any other app. A
+** message no pipe subscribes to (the app's telemetry and crypto output) is
+** handed to the sink instead, on the sending thread, and is only valid for
+** the duration of the call.
+*/
+#ifndef CFE_HOST_H
+#define CFE_HOST_H
+
+#include "cfe.h"
+
+typedef void (*cfe_host_sink_t)(CFE_SB_MsgPtr_t msg, void *arg);
+
+typedef struct {
+    uint16 depth;
+    uint16 queued;
+    uint16 high_water;
+    uint32 received;        /* Messages queued on the pipe */
+    uint32 dropped;         /* Messages lost because the pipe was full */
+} cfe_host_pipe_stats_t;
+
+/* Receive every message nothing subscribes to */
+void cfe_host_set_sink(cfe_host_sink_t sink, void *arg);
+
+/* 0: count events only, 1: also print them to stderr */
+void cfe_host_set_verbose(int verbose);
+
+/* Events sent so far of one CFE_EVS_* type */
+uint32 cfe_host_event_count(uint16 event_type);
+
+/* Statistics of the pipe created with this name; -1 if there is none */
+int cfe_host_pipe_stats(const char *pipe_name, cfe_host_pipe_stats_t *stats);
+
+/* Make CFE_ES_RunLoop return false, so the app's main loop exits */
+void cfe_host_stop(void);
+
+/* Register or replace the image loaded for a table file name (cfe_tbl_filedef.h) */
+void cfe_host_tbl_file(const char *file_name, const void *image, uint32 size);
+
+#endif /* CFE_HOST_H */
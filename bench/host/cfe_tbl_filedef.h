@@ -0,0 +1,21 @@
+/*
+** Host stand-in for cfe_tbl_filedef.h
+**
+** On target CFE_TBL_FILEDEF tags a table source for the elf2cfetbl tool. On
+** the host it registers the initialized object as the image of its table
+** file, so CFE_TBL_Load of that file name (any directory) copies it in.
+*/
+#ifndef CFE_TBL_FILEDEF_H
+#define CFE_TBL_FILEDEF_H
+
+#include "cfe.h"
+
+void cfe_host_tbl_file(const char *file_name, const void *image, uint32 size);
+
+#define CFE_TBL_FILEDEF(ObjName, TblName, Desc, Filename)                       \
+    static void __attribute__((constructor)) cfe_host_tbl_filedef_##ObjName(void) \
+    {                                                                           \
+        cfe_host_tbl_file(#Filename, &ObjName, sizeof(ObjName));                \
+    }
+
+#endif /* CFE_TBL_FILEDEF_H */
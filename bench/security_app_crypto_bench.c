@@ -0,0 +1,501 @@
+/*
+** Security App crypto microbenchmark
+**
+** Runs SECURITY_APP_Encrypt and SECURITY_APP_Decrypt for every cipher suite
+** over a range of payload sizes and reports ops/s, MB/s, cycles/byte and
+** p50/p99 latency, as a text table or as JSON. Each call is timed on its own
+** and the cost of the timer itself is subtracted. The IV ring is refilled
+** off the clock, as the refill task does on target.
+**
+** AES256-CBC also gets an "enc-mb" row: SECURITY_APP_EncryptMulti with
+** SECURITY_APP_MULTI_BUFFERS messages per call, as batch encrypt commands
+** run. Its ops/s count messages, and its latencies are per call.
+**
+** Build on a Linux host (no cFS needed):
+**   cmake -S bench -B build && cmake --build build
+**
+** Usage:
+**   security_app_crypto_bench [--json] [--cpu N] [--iterations N] [--max-size N] [--legacy]
+**
+** --legacy adds a comparison against the original open/setkey/close path.
+*/
+#define _GNU_SOURCE
+#include "security_app_crypto.h"
+#include <getopt.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gcrypt.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS 20000
+#define BENCH_DEFAULT_MAX_SIZE   16384
+#define BENCH_MIN_SIZE           16
+#define BENCH_BLOCK_SIZE         16
+#define BENCH_KEY_ID             0
+
+static const unsigned char bench_key[32] = {
+    0x4d, 0x79, 0x53, 0x65, 0x63, 0x72, 0x65, 0x74,
+    0x41, 0x45, 0x53, 0x32, 0x35, 0x36, 0x45, 0x6e,
+    0x63, 0x72, 0x79, 0x70, 0x74, 0x69, 0x6f, 0x6e,
+    0x4b, 0x65, 0x79, 0x32, 0x30, 0x32, 0x35, 0x21
+};
+
+/* Stands in for the record header the app authenticates with every message */
+static const uint8_t bench_aad[8] = { 0x30, 0x20, 0x00, 0x40, 0x00, 0x00, 0x00, 0x01 };
+
+static const char *suite_names[SECURITY_APP_SUITE_COUNT] = {
+    "AES256-CBC", "AES256-CTR", "AES256-GCM", "CHACHA20-POLY1305", "AES256-GMAC", "POLY1305"
+};
+
+typedef struct {
+    const char *suite;
+    const char *provider;
+    const char *op;
+    size_t      bytes;
+    double      ops_per_sec;
+    double      mb_per_sec;
+    double      cycles_per_byte;
+    double      p50_ns;
+    double      p99_ns;
+} bench_result_t;
+
+static struct {
+    int    json;
+    int    cpu;
+    int    legacy;
+    int    iterations;
+    size_t max_size;
+} opts = { 0, -1, 0, BENCH_DEFAULT_ITERATIONS, BENCH_DEFAULT_MAX_SIZE };
+
+static uint8_t *plaintext;
+static uint8_t *ciphertext;
+static uint8_t *multi_ciphertext;
+static uint8_t *decrypted;
+static double  *samples;
+static double   timer_overhead_ns;
+
+/* Reference copy of the original per-message path */
+static int32_t legacy_encrypt(const uint8_t *input, size_t input_len,
+                              uint8_t *iv, uint8_t *output, size_t *output_len)
+{
+    gcry_cipher_hd_t cipher_handle;
+    size_t padded_len = ((input_len + BENCH_BLOCK_SIZE - 1) / BENCH_BLOCK_SIZE) * BENCH_BLOCK_SIZE;
+    uint8_t *padded;
+
+    if (gcry_cipher_open(&cipher_handle, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC, 0)) {
+        return -2;
+    }
+    if (gcry_cipher_setkey(cipher_handle, bench_key, sizeof(bench_key))) {
+        gcry_cipher_close(cipher_handle);
+        return -3;
+    }
+    gcry_randomize(iv, BENCH_BLOCK_SIZE, GCRY_STRONG_RANDOM);
+    if (gcry_cipher_setiv(cipher_handle, iv, BENCH_BLOCK_SIZE)) {
+        gcry_cipher_close(cipher_handle);
+        return -4;
+    }
+    padded = malloc(padded_len);
+    if (padded == NULL) {
+        gcry_cipher_close(cipher_handle);
+        return -5;
+    }
+    memcpy(padded, input, input_len);
+    memset(padded + input_len, 0, padded_len - input_len);
+    if (gcry_cipher_encrypt(cipher_handle, output, padded_len, padded, padded_len)) {
+        free(padded);
+        gcry_cipher_close(cipher_handle);
+        return -6;
+    }
+    free(padded);
+    *output_len = padded_len;
+    gcry_cipher_close(cipher_handle);
+    return 0;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double pct)
+{
+    int index = (int)(pct / 100.0 * (count - 1) + 0.5);
+
+    return sorted[index];
+}
+
+/* Median cost of an empty timed region, subtracted from every sample */
+static void calibrate_timer(void)
+{
+    int i;
+
+    for (i = 0; i < opts.iterations; i++) {
+        double start = now_ns();
+        samples[i] = now_ns() - start;
+    }
+    qsort(samples, opts.iterations, sizeof(double), compare_double);
+    timer_overhead_ns = percentile(samples, opts.iterations, 50);
+}
+
+/* Time every call of one suite/direction/size and summarize */
+static void bench_case(uint8_t suite, int decrypt, size_t len, bench_result_t *result)
+{
+    /* Encrypts drain the IV ring; top it up before it reaches low water */
+    const int refill_every = SECURITY_APP_NONCE_POOL_DEPTH - SECURITY_APP_NONCE_LOW_WATER;
+    uint8_t iv[SECURITY_APP_IV_SIZE];
+    size_t ct_len;
+    size_t out_len;
+    double total_ns = 0;
+    uint64_t total_cycles = 0;
+    int i;
+
+    SECURITY_APP_NonceRefill();
+    if (SECURITY_APP_Encrypt(SECURITY_APP_MAIN_CHANNEL, BENCH_KEY_ID, suite, bench_aad, sizeof(bench_aad),
+                             plaintext, len, iv, ciphertext, &ct_len) != 0) {
+        fprintf(stderr, "%s encrypt failed at %zu bytes\n", suite_names[suite], len);
+        exit(1);
+    }
+
+    for (i = 0; i < opts.iterations; i++) {
+        double start;
+        uint64_t start_cycles;
+        int32_t status;
+
+        if (!decrypt && i % refill_every == 0) {
+            SECURITY_APP_NonceRefill();
+        }
+
+        start_cycles = now_cycles();
+        start = now_ns();
+        status = decrypt ?
+            SECURITY_APP_Decrypt(SECURITY_APP_MAIN_CHANNEL, BENCH_KEY_ID, suite, bench_aad, sizeof(bench_aad),
+                                 ciphertext, ct_len, iv, decrypted, &out_len, len) :
+            SECURITY_APP_Encrypt(SECURITY_APP_MAIN_CHANNEL, BENCH_KEY_ID, suite, bench_aad, sizeof(bench_aad),
+                                 plaintext, len, iv, ciphertext, &out_len);
+        samples[i] = now_ns() - start - timer_overhead_ns;
+        total_cycles += now_cycles() - start_cycles;
+
+        if (status != 0) {
+            fprintf(stderr, "%s %s failed at %zu bytes: %d\n", suite_names[suite],
+                    decrypt ? "decrypt" : "encrypt", len, (int)status);
+            exit(1);
+        }
+        if (samples[i] < 0) {
+            samples[i] = 0;
+        }
+        total_ns += samples[i];
+    }
+
+    qsort(samples, opts.iterations, sizeof(double), compare_double);
+
+    result->suite = suite_names[suite];
+    result->provider = SECURITY_APP_CryptoProviderName(suite);
+    result->op = decrypt ? "decrypt" : "encrypt";
+    result->bytes = len;
+    result->ops_per_sec = opts.iterations / (total_ns / 1e9);
+    result->mb_per_sec = result->ops_per_sec * len / 1e6;
+    result->cycles_per_byte = BENCH_HAVE_TSC ? (double)total_cycles / opts.iterations / len : 0;
+    result->p50_ns = percentile(samples, opts.iterations, 50);
+    result->p99_ns = percentile(samples, opts.iterations, 99);
+}
+
+/* Time multi-buffer CBC encryption of SECURITY_APP_MULTI_BUFFERS messages per call */
+static void bench_multi(size_t len, bench_result_t *result)
+{
+    const int refill_every = (SECURITY_APP_NONCE_POOL_DEPTH - SECURITY_APP_NONCE_LOW_WATER) /
+                             SECURITY_APP_MULTI_BUFFERS;
+    security_app_crypto_job_t jobs[SECURITY_APP_MULTI_BUFFERS];
+    uint8_t iv[SECURITY_APP_MULTI_BUFFERS][SECURITY_APP_IV_SIZE];
+    double total_ns = 0;
+    uint64_t total_cycles = 0;
+    int i;
+    int j;
+
+    for (j = 0; j < SECURITY_APP_MULTI_BUFFERS; j++) {
+        jobs[j].aad = bench_aad;
+        jobs[j].aad_len = sizeof(bench_aad);
+        jobs[j].plaintext = plaintext;
+        jobs[j].plaintext_len = len;
+        jobs[j].iv = iv[j];
+        jobs[j].ciphertext = multi_ciphertext + j * (opts.max_size + BENCH_BLOCK_SIZE);
+    }
+
+    for (i = 0; i < opts.iterations; i++) {
+        double start;
+        uint64_t start_cycles;
+        int32_t failed;
+
+        if (i % (refill_every > 0 ? refill_every : 1) == 0) {
+            SECURITY_APP_NonceRefill();
+        }
+
+        start_cycles = now_cycles();
+        start = now_ns();
+        failed = SECURITY_APP_EncryptMulti(SECURITY_APP_MAIN_CHANNEL, BENCH_KEY_ID, SECURITY_APP_SUITE_AES256_CBC,
+                                           jobs, SECURITY_APP_MULTI_BUFFERS);
+        samples[i] = now_ns() - start - timer_overhead_ns;
+        total_cycles += now_cycles() - start_cycles;
+
+        if (failed != 0) {
+            fprintf(stderr, "%s multi-buffer encrypt failed at %zu bytes: %d\n",
+                    suite_names[SECURITY_APP_SUITE_AES256_CBC], len, (int)jobs[0].status);
+            exit(1);
+        }
+        if (samples[i] < 0) {
+            samples[i] = 0;
+        }
+        total_ns += samples[i];
+    }
+
+    qsort(samples, opts.iterations, sizeof(double), compare_double);
+
+    result->suite = suite_names[SECURITY_APP_SUITE_AES256_CBC];
+    result->provider = SECURITY_APP_CryptoProviderName(SECURITY_APP_SUITE_AES256_CBC);
+    result->op = "enc-mb";
+    result->bytes = len;
+    result->ops_per_sec = (double)opts.iterations * SECURITY_APP_MULTI_BUFFERS / (total_ns / 1e9);
+    result->mb_per_sec = result->ops_per_sec * len / 1e6;
+    result->cycles_per_byte = BENCH_HAVE_TSC ?
+        (double)total_cycles / opts.iterations / (len * SECURITY_APP_MULTI_BUFFERS) : 0;
+    result->p50_ns = percentile(samples, opts.iterations, 50);
+    result->p99_ns = percentile(samples, opts.iterations, 99);
+}
+
+/* Mean ns per call of the legacy path and of the cached CBC path */
+static void bench_legacy(size_t len, double *legacy_ns, double *cached_ns)
+{
+    const int refill_every = SECURITY_APP_NONCE_POOL_DEPTH - SECURITY_APP_NONCE_LOW_WATER;
+    uint8_t iv[SECURITY_APP_IV_SIZE];
+    size_t out_len;
+    double start;
+    double total = 0;
+    int i;
+
+    start = now_ns();
+    for (i = 0; i < opts.iterations; i++) {
+        if (legacy_encrypt(plaintext, len, iv, ciphertext, &out_len) != 0) {
+            fprintf(stderr, "legacy encrypt failed at %zu bytes\n", len);
+            exit(1);
+        }
+    }
+    *legacy_ns = (now_ns() - start) / opts.iterations;
+
+    for (i = 0; i < opts.iterations; i++) {
+        if (i % refill_every == 0) {
+            SECURITY_APP_NonceRefill();
+        }
+        start = now_ns();
+        if (SECURITY_APP_Encrypt(SECURITY_APP_MAIN_CHANNEL, BENCH_KEY_ID, SECURITY_APP_SUITE_AES256_CBC,
+                                 NULL, 0, plaintext, len, iv, ciphertext, &out_len) != 0) {
+            fprintf(stderr, "cached encrypt failed at %zu bytes\n", len);
+            exit(1);
+        }
+        total += now_ns() - start;
+    }
+    *cached_ns = total / opts.iterations;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--json] [--cpu N] [--iterations N] [--max-size N] [--legacy]\n", prog);
+}
+
+static int parse_args(int argc, char **argv)
+{
+    static const struct option long_opts[] = {
+        { "json",       no_argument,       NULL, 'j' },
+        { "cpu",        required_argument, NULL, 'c' },
+        { "iterations", required_argument, NULL, 'n' },
+        { "max-size",   required_argument, NULL, 's' },
+        { "legacy",     no_argument,       NULL, 'l' },
+        { "help",       no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int c;
+
+    while ((c = getopt_long(argc, argv, "jc:n:s:lh", long_opts, NULL)) != -1) {
+        switch (c) {
+        case 'j':
+            opts.json = 1;
+            break;
+        case 'c':
+            opts.cpu = atoi(optarg);
+            break;
+        case 'n':
+            opts.iterations = atoi(optarg);
+            break;
+        case 's':
+            opts.max_size = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            opts.legacy = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (opts.iterations < 1 || opts.max_size < BENCH_MIN_SIZE) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int pin_cpu(int cpu)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_setaffinity");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void print_text(const bench_result_t *results, int count)
+{
+    int i;
+
+    printf("%-18s %-8s %-8s %8s %12s %10s %8s %10s %10s\n",
+           "suite", "provider", "op", "bytes", "ops/s", "MB/s", "cyc/B", "p50 ns", "p99 ns");
+    for (i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+
+        printf("%-18s %-8s %-8s %8zu %12.0f %10.1f %8.2f %10.1f %10.1f\n", r->suite, r->provider, r->op, r->bytes,
+               r->ops_per_sec, r->mb_per_sec, r->cycles_per_byte, r->p50_ns, r->p99_ns);
+    }
+}
+
+static void print_json(const bench_result_t *results, int count)
+{
+    int i;
+
+    printf("{\n");
+    printf("  \"iterations\": %d,\n", opts.iterations);
+    printf("  \"cpu\": %d,\n", opts.cpu);
+    printf("  \"timer_overhead_ns\": %.1f,\n", timer_overhead_ns);
+    printf("  \"cycle_counter\": %s,\n", BENCH_HAVE_TSC ? "true" : "false");
+    printf("  \"results\": [\n");
+    for (i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+
+        printf("    { \"suite\": \"%s\", \"provider\": \"%s\", \"op\": \"%s\", \"bytes\": %zu, "
+               "\"ops_per_sec\": %.1f, \"mb_per_sec\": %.2f, \"cycles_per_byte\": %.3f, \"p50_ns\": %.1f, "
+               "\"p99_ns\": %.1f }%s\n",
+               r->suite, r->provider, r->op, r->bytes, r->ops_per_sec, r->mb_per_sec, r->cycles_per_byte,
+               r->p50_ns, r->p99_ns, (i + 1 < count) ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+int main(int argc, char **argv)
+{
+    bench_result_t *results;
+    int count = 0;
+    int max_results;
+    uint8_t suite;
+    size_t len;
+
+    if (parse_args(argc, argv) != 0) {
+        return 2;
+    }
+    if (opts.cpu >= 0 && pin_cpu(opts.cpu) != 0) {
+        return 1;
+    }
+
+    plaintext = malloc(opts.max_size);
+    ciphertext = malloc(opts.max_size + SECURITY_APP_TAG_SIZE + BENCH_BLOCK_SIZE);
+    decrypted = malloc(opts.max_size + SECURITY_APP_TAG_SIZE + BENCH_BLOCK_SIZE);
+    multi_ciphertext = malloc(SECURITY_APP_MULTI_BUFFERS * (opts.max_size + BENCH_BLOCK_SIZE));
+    samples = malloc(opts.iterations * sizeof(double));
+    max_results = (2 * SECURITY_APP_SUITE_COUNT + 1) * 32;
+    results = malloc(max_results * sizeof(bench_result_t));
+    if (plaintext == NULL || ciphertext == NULL || decrypted == NULL || multi_ciphertext == NULL || samples == NULL || results == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    memset(plaintext, 0xA5, opts.max_size);
+
+    if (SECURITY_APP_InitCrypto() != 0) {
+        fprintf(stderr, "SECURITY_APP_InitCrypto failed\n");
+        return 1;
+    }
+    if (SECURITY_APP_LoadKey(BENCH_KEY_ID, bench_key) != 0) {
+        fprintf(stderr, "SECURITY_APP_LoadKey failed\n");
+        return 1;
+    }
+
+    calibrate_timer();
+
+    for (len = BENCH_MIN_SIZE; len <= opts.max_size && count < max_results; len *= 4) {
+        for (suite = 0; suite < SECURITY_APP_SUITE_COUNT; suite++) {
+            bench_case(suite, 0, len, &results[count++]);
+            bench_case(suite, 1, len, &results[count++]);
+            if (suite == SECURITY_APP_SUITE_AES256_CBC) {
+                bench_multi(len, &results[count++]);
+            }
+        }
+    }
+
+    if (opts.json) {
+        print_json(results, count);
+    } else {
+        print_text(results, count);
+    }
+
+    if (opts.legacy && !opts.json) {
+        printf("\n%8s %14s %14s %8s\n", "bytes", "legacy ns/op", "cached ns/op", "speedup");
+        for (len = BENCH_MIN_SIZE; len <= opts.max_size && len <= 1024; len *= 4) {
+            double legacy;
+            double cached;
+
+            bench_legacy(len, &legacy, &cached);
+            printf("%8zu %14.1f %14.1f %7.2fx\n", len, legacy, cached, legacy / cached);
+        }
+    }
+
+    SECURITY_APP_CleanupCrypto();
+    free(results);
+    free(samples);
+    free(multi_ciphertext);
+    free(decrypted);
+    free(ciphertext);
+    free(plaintext);
+
+    return 0;
+}
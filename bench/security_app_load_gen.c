@@ -0,0 +1,959 @@
+/*
+** Security App end-to-end load generator
+**
+** Runs the whole app (SECURITY_APP_Main, its child tasks and tables) on the
+** host cFE stub and pushes command traffic through the Software Bus at a set
+** rate and mix, then reports throughput, latency percentiles and drops as
+** seen from outside the app. This covers the full path: pipes, dispatch,
+** load shedding, workers and output, not just the cipher.
+**
+** Traffic is synthetic (--count messages at --rate, a --decrypt percentage,
+** payload sizes in [--min-size, --max-size], suites from --suite) or replayed
+** from a trace file with one message per line:
+**   <offset_us> <encrypt|decrypt> <suite> <size>
+** --record writes the traffic of a synthetic run in that format. Suites are
+** names (AES256-GCM) or numbers; authenticate-only suites are sent as sign
+** and verify commands. Records for the decrypt traffic are produced by the
+** app itself before the timed run, in the order they will be sent, so they
+** pass the anti-replay check.
+**
+** Each command in flight gets its own output message ID from a window of
+** --window IDs, which is how outputs are matched to commands. With the
+** window full a message is counted as not sent. At --rate 0 the generator
+** runs closed loop instead: it waits for an output whenever the window or
+** the data pipe is full, so nothing is dropped before the app sees it. A
+** message is lost if its output has not
+** arrived --timeout ms after it was sent. Pipe depths and other app
+** settings are build options, see SECURITY_APP_HOST_DEFINES in
+** CMakeLists.txt.
+**
+** Usage:
+**   security_app_load_gen [--count N] [--rate N] [--poisson] [--decrypt PCT]
+**                         [--min-size N] [--max-size N] [--suite LIST] [--window N]
+**                         [--timeout MS] [--hk-hz N] [--trace FILE] [--record FILE]
+**                         [--seed N] [--json] [--verbose]
+*/
+#define _GNU_SOURCE
+#include "cfe.h"
+#include "cfe_host.h"
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define GEN_TOKEN_MID_BASE   0x0900
+#define GEN_PREP_MID         (GEN_TOKEN_MID_BASE - 1)
+#define GEN_MAX_TOKENS       256
+#define GEN_DATA_PIPE_NAME   "SEC_APP_DATA_PIPE"
+#define GEN_KEY_ID           0
+#define GEN_PREP_TIMEOUT_MS  2000
+#define GEN_HK_RETRY_MS      100
+#define GEN_RECLAIM_NS       1000000ULL
+
+enum {
+    GEN_PENDING = 0,        /* Not sent yet, or in flight */
+    GEN_DELIVERED,
+    GEN_PIPE_FULL,          /* Dropped by the SB: data pipe full */
+    GEN_WINDOW_FULL,        /* Not sent: no output ID free */
+    GEN_LOST                /* No output within the timeout */
+};
+
+typedef struct {
+    uint64_t at_ns;         /* Offset from the start of the run */
+    uint8_t  decrypt;
+    uint8_t  suite;
+    uint16_t size;
+    uint8_t  state;         /* GEN_* */
+    uint32_t record;        /* Decrypts: index into gen.records */
+    uint64_t latency_ns;
+} gen_msg_t;
+
+typedef struct {
+    int      pending;
+    uint32_t msg;
+    uint64_t sent_ns;
+} gen_token_t;
+
+typedef struct {
+    uint16_t length;
+    uint8_t  data[SECURITY_APP_MAX_RECORD_LENGTH];
+} gen_record_t;
+
+static const char *suite_names[SECURITY_APP_SUITE_COUNT] = {
+    "AES256-CBC", "AES256-CTR", "AES256-GCM", "CHACHA20-POLY1305", "AES256-GMAC", "POLY1305"
+};
+
+static struct {
+    long        count;
+    double      rate;
+    int         poisson;
+    int         decrypt_pct;
+    int         min_size;
+    int         max_size;
+    uint8_t     suites[SECURITY_APP_SUITE_COUNT];
+    int         suite_count;
+    int         window;
+    int         timeout_ms;
+    int         hk_hz;
+    const char *trace;
+    const char *record;
+    unsigned    seed;
+    int         json;
+    int         verbose;
+} opts = {
+    10000, 2000, 0, 50, 64, 1024, { SECURITY_APP_SUITE_AES256_GCM }, 1,
+    SECURITY_APP_DATA_PIPE_DEPTH + SECURITY_APP_DEFER_DEPTH, 1000, 1, NULL, NULL, 1, 0, 0
+};
+
+/* State shared with the sink, which runs on the app's tasks */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    gen_msg_t      *msgs;
+    long            count;
+    gen_token_t     tokens[GEN_MAX_TOKENS];
+    uint16_t        free_tokens[GEN_MAX_TOKENS];
+    int             free_count;
+    int             in_flight;
+    uint64_t        last_delivery_ns;
+    uint32_t        late;               /* Outputs for messages already counted lost */
+    gen_record_t   *records;
+    long            record_count;
+    gen_record_t   *prep_record;        /* Set while waiting for a prep output */
+    SECURITY_APP_HkTlm_t hk;
+    uint32_t        hk_count;
+    uint8_t         congested;
+    uint32_t        congestion_onsets;
+} gen = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static volatile int ticker_running = 1;
+static uint8_t plaintext[SECURITY_APP_MAX_DATA_LENGTH];
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t t)
+{
+    struct timespec ts = { (time_t)(t / 1000000000ULL), (long)(t % 1000000000ULL) };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+/* Wait on gen.changed for up to ms; gen.lock must be held */
+static void wait_changed(int ms)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += (long)ms * 1000000L;
+    ts.tv_sec += ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait(&gen.changed, &gen.lock, &ts);
+}
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double rng_unit(void)
+{
+    return (rng_next() + 0.5) / 4294967296.0;
+}
+
+static int parse_suite(const char *text)
+{
+    char *end;
+    long n = strtol(text, &end, 0);
+    int i;
+
+    if (*end == '\0') {
+        return (n >= 0 && n < SECURITY_APP_SUITE_COUNT) ? (int)n : -1;
+    }
+    for (i = 0; i < SECURITY_APP_SUITE_COUNT; i++) {
+        if (strcasecmp(text, suite_names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+** Sink: every output and telemetry packet the app sends
+*/
+static void gen_sink(CFE_SB_MsgPtr_t msg, void *arg)
+{
+    CFE_SB_MsgId_t mid = CFE_SB_GetMsgId(msg);
+    uint16_t length = CFE_SB_GetTotalMsgLength(msg);
+    uint64_t now = now_ns();
+    gen_token_t *token;
+    gen_msg_t *m;
+
+    pthread_mutex_lock(&gen.lock);
+
+    if (mid >= GEN_TOKEN_MID_BASE && mid < GEN_TOKEN_MID_BASE + opts.window) {
+        token = &gen.tokens[mid - GEN_TOKEN_MID_BASE];
+        if (token->pending) {
+            m = &gen.msgs[token->msg];
+            m->state = GEN_DELIVERED;
+            m->latency_ns = now - token->sent_ns;
+            token->pending = 0;
+            gen.free_tokens[gen.free_count++] = (uint16_t)(mid - GEN_TOKEN_MID_BASE);
+            gen.in_flight--;
+            gen.last_delivery_ns = now;
+        } else {
+            gen.late++;
+        }
+    } else if (mid == GEN_PREP_MID && gen.prep_record != NULL) {
+        gen.prep_record->length = (uint16_t)(length - offsetof(SECURITY_APP_EncryptedTlm_t, Record));
+        memcpy(gen.prep_record->data, ((SECURITY_APP_EncryptedTlm_t *)msg)->Record, gen.prep_record->length);
+        gen.prep_record = NULL;
+    } else if (mid == SECURITY_APP_HK_TLM_MID) {
+        memcpy(&gen.hk, msg, sizeof(gen.hk));
+        gen.hk_count++;
+    } else if (mid == SECURITY_APP_LOAD_TLM_MID) {
+        uint8_t congested = ((SECURITY_APP_LoadTlm_t *)msg)->Congested;
+
+        gen.congestion_onsets += (congested && !gen.congested);
+        gen.congested = congested;
+    }
+
+    pthread_cond_broadcast(&gen.changed);
+    pthread_mutex_unlock(&gen.lock);
+}
+
+/*
+** Commands
+*/
+static void send_no_args(CFE_SB_MsgId_t mid, uint16_t cc)
+{
+    SECURITY_APP_NoArgsCmd_t cmd;
+
+    CFE_SB_InitMsg(&cmd, mid, sizeof(cmd), TRUE);
+    CFE_SB_SetCmdCode((CFE_SB_MsgPtr_t)&cmd, cc);
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+}
+
+/* Send message m's command with its output on target */
+static void send_msg(const gen_msg_t *m, CFE_SB_MsgId_t target)
+{
+    static union {
+        SECURITY_APP_EncryptCmd_t encrypt;
+        SECURITY_APP_DecryptCmd_t decrypt;
+    } cmd __attribute__((aligned(16)));
+    int auth_only = SECURITY_APP_SuiteAuthOnly(m->suite);
+    const gen_record_t *record;
+
+    if (m->decrypt) {
+        record = &gen.records[m->record];
+        CFE_SB_InitMsg(&cmd.decrypt, SECURITY_APP_DATA_CMD_MID,
+                       offsetof(SECURITY_APP_DecryptCmd_t, Record) + record->length, FALSE);
+        CFE_SB_SetCmdCode((CFE_SB_MsgPtr_t)&cmd, auth_only ? SECURITY_APP_VERIFY_CC : SECURITY_APP_DECRYPT_CC);
+        cmd.decrypt.DataLength = record->length;
+        cmd.decrypt.TargetMsgID = target;
+        memcpy(cmd.decrypt.Record, record->data, record->length);
+    } else {
+        CFE_SB_InitMsg(&cmd.encrypt, SECURITY_APP_DATA_CMD_MID,
+                       offsetof(SECURITY_APP_EncryptCmd_t, Data) + m->size, FALSE);
+        CFE_SB_SetCmdCode((CFE_SB_MsgPtr_t)&cmd, auth_only ? SECURITY_APP_SIGN_CC : SECURITY_APP_ENCRYPT_CC);
+        cmd.encrypt.DataLength = m->size;
+        cmd.encrypt.TargetMsgID = target;
+        cmd.encrypt.Suite = m->suite;
+        cmd.encrypt.KeyId = GEN_KEY_ID;
+        cmd.encrypt.Options = 0;
+        cmd.encrypt.Spare = 0;
+        memcpy(cmd.encrypt.Data, plaintext, m->size);
+    }
+
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+}
+
+/*
+** Request housekeeping and wait for it; 0 if it arrived. The request is
+** repeated until answered, since one sent before the app has subscribed
+** its command pipe is dropped by the bus.
+*/
+static int sync_hk(void)
+{
+    uint64_t deadline = now_ns() + GEN_PREP_TIMEOUT_MS * 1000000ULL;
+    uint64_t resend = 0;
+    uint32_t seen;
+    int answered;
+
+    pthread_mutex_lock(&gen.lock);
+    seen = gen.hk_count;
+    while (gen.hk_count == seen && now_ns() < deadline) {
+        if (now_ns() >= resend) {
+            pthread_mutex_unlock(&gen.lock);
+            send_no_args(SECURITY_APP_SEND_HK_MID, 0);
+            pthread_mutex_lock(&gen.lock);
+            resend = now_ns() + GEN_HK_RETRY_MS * 1000000ULL;
+        }
+        wait_changed(10);
+    }
+    answered = gen.hk_count != seen;
+    pthread_mutex_unlock(&gen.lock);
+
+    return answered ? 0 : -1;
+}
+
+/* Housekeeping requests, and scheduler wakeups in scheduled mode */
+static void *ticker_main(void *arg)
+{
+    uint64_t hk_period = opts.hk_hz > 0 ? 1000000000ULL / opts.hk_hz : 0;
+    uint64_t next_hk = now_ns() + hk_period;
+    uint64_t now;
+
+    while (ticker_running) {
+        OS_TaskDelay(SECURITY_APP_SCHEDULED_MODE ? 1 : 10);
+#if (SECURITY_APP_SCHEDULED_MODE == 1)
+        send_no_args(SECURITY_APP_WAKEUP_MID, 0);
+#endif
+        now = now_ns();
+        if (hk_period != 0 && now >= next_hk) {
+            send_no_args(SECURITY_APP_SEND_HK_MID, 0);
+            next_hk += hk_period;
+        }
+    }
+
+    return NULL;
+}
+
+static void *app_main(void *arg)
+{
+    SECURITY_APP_Main();
+    return NULL;
+}
+
+/*
+** Traffic
+*/
+static int load_trace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    char op[32];
+    char suite[32];
+    double offset_us;
+    int size;
+    int s;
+    long n = 0;
+    long cap = 1024;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    gen.msgs = malloc(cap * sizeof(gen_msg_t));
+
+    while (gen.msgs != NULL && fgets(line, sizeof(line), f) != NULL) {
+        char *p = line;
+
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '#' || *p == '\0') {
+            continue;
+        }
+        if (sscanf(p, "%lf %31s %31s %d", &offset_us, op, suite, &size) != 4 ||
+            (s = parse_suite(suite)) < 0 || size < 1 || size > SECURITY_APP_MAX_DATA_LENGTH ||
+            (strcmp(op, "encrypt") != 0 && strcmp(op, "decrypt") != 0)) {
+            fprintf(stderr, "%s: bad line: %s", path, line);
+            fclose(f);
+            return -1;
+        }
+        if (n == cap) {
+            cap *= 2;
+            gen.msgs = realloc(gen.msgs, cap * sizeof(gen_msg_t));
+            if (gen.msgs == NULL) {
+                break;
+            }
+        }
+        memset(&gen.msgs[n], 0, sizeof(gen_msg_t));
+        gen.msgs[n].at_ns = (uint64_t)(offset_us * 1000.0);
+        gen.msgs[n].decrypt = (strcmp(op, "decrypt") == 0);
+        gen.msgs[n].suite = (uint8_t)s;
+        gen.msgs[n].size = (uint16_t)size;
+        n++;
+    }
+    fclose(f);
+
+    if (gen.msgs == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    gen.count = n;
+
+    return 0;
+}
+
+static int make_traffic(void)
+{
+    double t = 0;
+    long i;
+
+    gen.msgs = calloc(opts.count, sizeof(gen_msg_t));
+    if (gen.msgs == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+    gen.count = opts.count;
+
+    for (i = 0; i < opts.count; i++) {
+        gen_msg_t *m = &gen.msgs[i];
+
+        m->at_ns = (uint64_t)t;
+        m->decrypt = (int)(rng_next() % 100) < opts.decrypt_pct;
+        m->suite = opts.suites[rng_next() % opts.suite_count];
+        m->size = (uint16_t)(opts.min_size + rng_next() % (opts.max_size - opts.min_size + 1));
+        if (opts.rate > 0) {
+            t += opts.poisson ? -log(rng_unit()) * 1e9 / opts.rate : 1e9 / opts.rate;
+        }
+    }
+
+    return 0;
+}
+
+static int write_trace(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    long i;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "# offset_us op suite size\n");
+    for (i = 0; i < gen.count; i++) {
+        const gen_msg_t *m = &gen.msgs[i];
+
+        fprintf(f, "%.3f %s %s %u\n", m->at_ns / 1000.0, m->decrypt ? "decrypt" : "encrypt",
+                suite_names[m->suite], m->size);
+    }
+
+    return fclose(f);
+}
+
+/* Have the app encrypt a record for every decrypt message, in send order */
+static int prepare_records(void)
+{
+    gen_msg_t plain;
+    uint64_t deadline;
+    long i;
+
+    for (i = 0; i < gen.count; i++) {
+        gen.record_count += gen.msgs[i].decrypt;
+    }
+    gen.records = malloc((gen.record_count ? gen.record_count : 1) * sizeof(gen_record_t));
+    if (gen.records == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    gen.record_count = 0;
+    for (i = 0; i < gen.count; i++) {
+        gen_msg_t *m = &gen.msgs[i];
+
+        if (!m->decrypt) {
+            continue;
+        }
+        plain = *m;
+        plain.decrypt = 0;
+        m->record = (uint32_t)gen.record_count;
+
+        pthread_mutex_lock(&gen.lock);
+        gen.prep_record = &gen.records[gen.record_count++];
+        pthread_mutex_unlock(&gen.lock);
+
+        send_msg(&plain, GEN_PREP_MID);
+
+        deadline = now_ns() + GEN_PREP_TIMEOUT_MS * 1000000ULL;
+        pthread_mutex_lock(&gen.lock);
+        while (gen.prep_record != NULL && now_ns() < deadline) {
+            wait_changed(10);
+        }
+        if (gen.prep_record != NULL) {
+            pthread_mutex_unlock(&gen.lock);
+            fprintf(stderr, "app did not return a record for decrypt traffic (see --verbose)\n");
+            return -1;
+        }
+        pthread_mutex_unlock(&gen.lock);
+    }
+
+    return 0;
+}
+
+/* Count messages in flight too long as lost and free their IDs; gen.lock held */
+static void reclaim_expired(uint64_t now)
+{
+    uint64_t timeout = (uint64_t)opts.timeout_ms * 1000000ULL;
+    int i;
+
+    for (i = 0; i < opts.window; i++) {
+        gen_token_t *token = &gen.tokens[i];
+
+        if (token->pending && now - token->sent_ns > timeout) {
+            gen.msgs[token->msg].state = GEN_LOST;
+            token->pending = 0;
+            gen.free_tokens[gen.free_count++] = (uint16_t)i;
+            gen.in_flight--;
+        }
+    }
+}
+
+/* Send the traffic on schedule; returns the time of the first send */
+static uint64_t run_traffic(uint64_t *last_send, uint64_t *max_lag)
+{
+    cfe_host_pipe_stats_t before;
+    cfe_host_pipe_stats_t after;
+    uint64_t start = now_ns();
+    uint64_t next_reclaim = start;
+    uint64_t now;
+    uint64_t due;
+    uint16_t id;
+    int closed_loop = (opts.rate == 0 && opts.trace == NULL);
+    long i = 0;
+
+    *max_lag = 0;
+
+    while (i < gen.count) {
+        gen_msg_t *m = &gen.msgs[i];
+
+        now = now_ns();
+        due = closed_loop ? now : start + m->at_ns;
+        if (now < due) {
+            sleep_until_ns(due);
+            continue;
+        }
+
+        pthread_mutex_lock(&gen.lock);
+        if (now >= next_reclaim) {
+            reclaim_expired(now);
+            next_reclaim = now + GEN_RECLAIM_NS;
+        }
+        if (gen.free_count == 0) {
+            if (closed_loop) {
+                /* Wait for an output instead of skipping the message */
+                wait_changed(1);
+                pthread_mutex_unlock(&gen.lock);
+                continue;
+            }
+            m->state = GEN_WINDOW_FULL;
+            pthread_mutex_unlock(&gen.lock);
+            i++;
+            continue;
+        }
+        id = gen.free_tokens[--gen.free_count];
+        gen.tokens[id].pending = 1;
+        gen.tokens[id].msg = (uint32_t)i;
+        gen.in_flight++;
+        pthread_mutex_unlock(&gen.lock);
+
+        if (now - due > *max_lag) {
+            *max_lag = now - due;
+        }
+
+        cfe_host_pipe_stats(GEN_DATA_PIPE_NAME, &before);
+        gen.tokens[id].sent_ns = now_ns();
+        send_msg(m, GEN_TOKEN_MID_BASE + id);
+        cfe_host_pipe_stats(GEN_DATA_PIPE_NAME, &after);
+        *last_send = now_ns();
+
+        if (after.dropped != before.dropped) {
+            pthread_mutex_lock(&gen.lock);
+            gen.tokens[id].pending = 0;
+            gen.free_tokens[gen.free_count++] = id;
+            gen.in_flight--;
+            if (closed_loop) {
+                /* Keep the pipe full rather than dropping: send it again after the next output */
+                wait_changed(1);
+                pthread_mutex_unlock(&gen.lock);
+                continue;
+            }
+            m->state = GEN_PIPE_FULL;
+            pthread_mutex_unlock(&gen.lock);
+        }
+        i++;
+    }
+
+    return start;
+}
+
+/* Wait for the outputs still in flight, then count the rest lost */
+static void drain(void)
+{
+    pthread_mutex_lock(&gen.lock);
+    while (gen.in_flight > 0) {
+        reclaim_expired(now_ns());
+        wait_changed(1);
+    }
+    pthread_mutex_unlock(&gen.lock);
+}
+
+/*
+** Report
+*/
+typedef struct {
+    const char *name;
+    long        sent;
+    long        delivered;
+    long        pipe_full;
+    long        window_full;
+    long        lost;
+    double      bytes;
+    double      min_us;
+    double      p50_us;
+    double      p90_us;
+    double      p99_us;
+    double      p999_us;
+    double      max_us;
+} gen_summary_t;
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint64_t *sorted, long count, double pct)
+{
+    long index = (long)(pct / 100.0 * (count - 1) + 0.5);
+
+    return count ? sorted[index] / 1000.0 : 0;
+}
+
+/* Summarize decrypt == 0, 1, or -1 for both */
+static void summarize(int decrypt, const char *name, uint64_t *scratch, gen_summary_t *s)
+{
+    long n = 0;
+    long i;
+
+    memset(s, 0, sizeof(*s));
+    s->name = name;
+
+    for (i = 0; i < gen.count; i++) {
+        const gen_msg_t *m = &gen.msgs[i];
+
+        if (decrypt >= 0 && m->decrypt != decrypt) {
+            continue;
+        }
+        switch (m->state) {
+        case GEN_DELIVERED:
+            s->delivered++;
+            s->bytes += m->size;
+            scratch[n++] = m->latency_ns;
+            break;
+        case GEN_PIPE_FULL:
+            s->pipe_full++;
+            break;
+        case GEN_WINDOW_FULL:
+            s->window_full++;
+            break;
+        default:
+            s->lost++;
+            break;
+        }
+    }
+    s->sent = s->delivered + s->pipe_full + s->lost;
+
+    qsort(scratch, n, sizeof(uint64_t), compare_u64);
+    s->min_us = n ? scratch[0] / 1000.0 : 0;
+    s->p50_us = percentile_us(scratch, n, 50);
+    s->p90_us = percentile_us(scratch, n, 90);
+    s->p99_us = percentile_us(scratch, n, 99);
+    s->p999_us = percentile_us(scratch, n, 99.9);
+    s->max_us = n ? scratch[n - 1] / 1000.0 : 0;
+}
+
+static void report(double elapsed_s, double offered_s, uint64_t max_lag, int hk_ok)
+{
+    static const char *names[3] = { "all", "encrypt", "decrypt" };
+    gen_summary_t sums[3];
+    cfe_host_pipe_stats_t pipe;
+    uint64_t *scratch = malloc((gen.count ? gen.count : 1) * sizeof(uint64_t));
+    const SECURITY_APP_HkTlm_t *hk = &gen.hk;
+    int i;
+
+    if (scratch == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return;
+    }
+    summarize(-1, names[0], scratch, &sums[0]);
+    summarize(0, names[1], scratch, &sums[1]);
+    summarize(1, names[2], scratch, &sums[2]);
+    free(scratch);
+    memset(&pipe, 0, sizeof(pipe));
+    cfe_host_pipe_stats(GEN_DATA_PIPE_NAME, &pipe);
+
+    if (opts.json) {
+        printf("{\n");
+        printf("  \"messages\": %ld,\n", gen.count);
+        printf("  \"window\": %d,\n", opts.window);
+        printf("  \"data_pipe_depth\": %u,\n", pipe.depth);
+        printf("  \"data_pipe_high_water\": %u,\n", pipe.high_water);
+        printf("  \"workers\": %d,\n", SECURITY_APP_NUM_WORKERS);
+        printf("  \"elapsed_s\": %.6f,\n", elapsed_s);
+        printf("  \"offered_per_sec\": %.1f,\n", offered_s > 0 ? sums[0].sent / offered_s : 0);
+        printf("  \"max_send_lag_us\": %.1f,\n", max_lag / 1000.0);
+        printf("  \"late_outputs\": %u,\n", gen.late);
+        printf("  \"congestion_onsets\": %u,\n", gen.congestion_onsets);
+        printf("  \"error_events\": %u,\n", cfe_host_event_count(CFE_EVS_ERROR));
+        if (hk_ok) {
+            printf("  \"app\": { \"encrypted\": %u, \"decrypted\": %u, \"encrypt_errors\": %u, "
+                   "\"decrypt_errors\": %u, \"replay_rejects\": %u, \"deferred\": %u, \"shed\": %u },\n",
+                   hk->EncryptionCount, hk->DecryptionCount, hk->EncryptionErrorCount,
+                   hk->DecryptionErrorCount, hk->ReplayRejectCount, hk->DeferCount, hk->ShedCount);
+        }
+        printf("  \"results\": [\n");
+        for (i = 0; i < 3; i++) {
+            const gen_summary_t *s = &sums[i];
+
+            printf("    { \"op\": \"%s\", \"sent\": %ld, \"delivered\": %ld, \"pipe_full\": %ld, "
+                   "\"window_full\": %ld, \"lost\": %ld, \"ops_per_sec\": %.1f, \"mb_per_sec\": %.3f, "
+                   "\"min_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, "
+                   "\"p999_us\": %.1f, \"max_us\": %.1f }%s\n",
+                   s->name, s->sent, s->delivered, s->pipe_full, s->window_full, s->lost,
+                   elapsed_s > 0 ? s->delivered / elapsed_s : 0, elapsed_s > 0 ? s->bytes / elapsed_s / 1e6 : 0,
+                   s->min_us, s->p50_us, s->p90_us, s->p99_us, s->p999_us, s->max_us, (i < 2) ? "," : "");
+        }
+        printf("  ]\n");
+        printf("}\n");
+        return;
+    }
+
+    printf("%ld messages in %.3f s (offered %.0f/s, max send lag %.1f us), window %d, "
+           "data pipe depth %u (high water %u), %d workers\n",
+           gen.count, elapsed_s, offered_s > 0 ? sums[0].sent / offered_s : 0, max_lag / 1000.0,
+           opts.window, pipe.depth, pipe.high_water, SECURITY_APP_NUM_WORKERS);
+    printf("\n%-8s %8s %9s %9s %9s %7s %10s %8s %9s %9s %9s %9s %9s %9s\n",
+           "op", "sent", "delivered", "pipe full", "window", "lost", "ops/s", "MB/s",
+           "min us", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    for (i = 0; i < 3; i++) {
+        const gen_summary_t *s = &sums[i];
+
+        printf("%-8s %8ld %9ld %9ld %9ld %7ld %10.0f %8.2f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+               s->name, s->sent, s->delivered, s->pipe_full, s->window_full, s->lost,
+               elapsed_s > 0 ? s->delivered / elapsed_s : 0, elapsed_s > 0 ? s->bytes / elapsed_s / 1e6 : 0,
+               s->min_us, s->p50_us, s->p90_us, s->p99_us, s->p999_us, s->max_us);
+    }
+
+    printf("\ncongestion onsets %u, error events %u, late outputs %u\n",
+           gen.congestion_onsets, cfe_host_event_count(CFE_EVS_ERROR), gen.late);
+    if (hk_ok) {
+        printf("app: %u encrypted, %u decrypted, %u/%u errors, %u replay rejects, %u deferred, %u shed\n",
+               hk->EncryptionCount, hk->DecryptionCount, hk->EncryptionErrorCount, hk->DecryptionErrorCount,
+               hk->ReplayRejectCount, hk->DeferCount, hk->ShedCount);
+    } else {
+        printf("app: no housekeeping received\n");
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--count N] [--rate N] [--poisson] [--decrypt PCT] [--min-size N] [--max-size N]\n"
+            "       [--suite LIST] [--window N] [--timeout MS] [--hk-hz N] [--trace FILE] [--record FILE]\n"
+            "       [--seed N] [--json] [--verbose]\n", prog);
+}
+
+static int parse_suites(char *list)
+{
+    char *save = NULL;
+    char *item;
+    int s;
+
+    opts.suite_count = 0;
+    for (item = strtok_r(list, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+        s = parse_suite(item);
+        if (s < 0 || opts.suite_count == SECURITY_APP_SUITE_COUNT) {
+            fprintf(stderr, "unknown suite %s\n", item);
+            return -1;
+        }
+        opts.suites[opts.suite_count++] = (uint8_t)s;
+    }
+
+    return opts.suite_count ? 0 : -1;
+}
+
+static int parse_args(int argc, char **argv)
+{
+    static const struct option long_opts[] = {
+        { "count",    required_argument, NULL, 'n' },
+        { "rate",     required_argument, NULL, 'r' },
+        { "poisson",  no_argument,       NULL, 'p' },
+        { "decrypt",  required_argument, NULL, 'd' },
+        { "min-size", required_argument, NULL, 'm' },
+        { "max-size", required_argument, NULL, 'M' },
+        { "suite",    required_argument, NULL, 's' },
+        { "window",   required_argument, NULL, 'w' },
+        { "timeout",  required_argument, NULL, 't' },
+        { "hk-hz",    required_argument, NULL, 'k' },
+        { "trace",    required_argument, NULL, 'T' },
+        { "record",   required_argument, NULL, 'R' },
+        { "seed",     required_argument, NULL, 'S' },
+        { "json",     no_argument,       NULL, 'j' },
+        { "verbose",  no_argument,       NULL, 'v' },
+        { "help",     no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int c;
+
+    while ((c = getopt_long(argc, argv, "n:r:pd:m:M:s:w:t:k:T:R:S:jvh", long_opts, NULL)) != -1) {
+        switch (c) {
+        case 'n':
+            opts.count = atol(optarg);
+            break;
+        case 'r':
+            opts.rate = atof(optarg);
+            break;
+        case 'p':
+            opts.poisson = 1;
+            break;
+        case 'd':
+            opts.decrypt_pct = atoi(optarg);
+            break;
+        case 'm':
+            opts.min_size = atoi(optarg);
+            break;
+        case 'M':
+            opts.max_size = atoi(optarg);
+            break;
+        case 's':
+            if (parse_suites(optarg) != 0) {
+                return -1;
+            }
+            break;
+        case 'w':
+            opts.window = atoi(optarg);
+            break;
+        case 't':
+            opts.timeout_ms = atoi(optarg);
+            break;
+        case 'k':
+            opts.hk_hz = atoi(optarg);
+            break;
+        case 'T':
+            opts.trace = optarg;
+            break;
+        case 'R':
+            opts.record = optarg;
+            break;
+        case 'S':
+            opts.seed = (unsigned)strtoul(optarg, NULL, 0);
+            break;
+        case 'j':
+            opts.json = 1;
+            break;
+        case 'v':
+            opts.verbose = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (opts.count < 1 || opts.rate < 0 || opts.decrypt_pct < 0 || opts.decrypt_pct > 100 ||
+        opts.min_size < 1 || opts.max_size > SECURITY_APP_MAX_DATA_LENGTH || opts.min_size > opts.max_size ||
+        opts.window < 1 || opts.window > GEN_MAX_TOKENS || opts.timeout_ms < 1 || opts.hk_hz < 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t app_thread;
+    pthread_t ticker_thread;
+    uint64_t start;
+    uint64_t last_send = 0;
+    uint64_t max_lag = 0;
+    uint64_t end;
+    int hk_ok;
+    int i;
+
+    if (parse_args(argc, argv) != 0) {
+        return 2;
+    }
+
+    rng_state = opts.seed ? opts.seed : 1;
+    for (i = 0; i < SECURITY_APP_MAX_DATA_LENGTH; i++) {
+        plaintext[i] = (uint8_t)rng_next();
+    }
+
+    if ((opts.trace != NULL ? load_trace(opts.trace) : make_traffic()) != 0) {
+        return 1;
+    }
+    if (opts.record != NULL && write_trace(opts.record) != 0) {
+        return 1;
+    }
+
+    for (i = 0; i < opts.window; i++) {
+        gen.free_tokens[gen.free_count++] = (uint16_t)(opts.window - 1 - i);
+    }
+
+    cfe_host_set_verbose(opts.verbose);
+    cfe_host_set_sink(gen_sink, NULL);
+    if (pthread_create(&app_thread, NULL, app_main, NULL) != 0) {
+        perror("pthread_create");
+        return 1;
+    }
+
+    /* The app is up once it answers housekeeping */
+    if (sync_hk() != 0) {
+        fprintf(stderr, "app did not start (see --verbose)\n");
+        return 1;
+    }
+    if (prepare_records() != 0) {
+        return 1;
+    }
+
+    /* Start the run from zeroed app counters */
+    send_no_args(SECURITY_APP_CMD_MID, SECURITY_APP_RESET_COUNTERS_CC);
+    sync_hk();
+    if (pthread_create(&ticker_thread, NULL, ticker_main, NULL) != 0) {
+        perror("pthread_create");
+        return 1;
+    }
+
+    start = run_traffic(&last_send, &max_lag);
+    drain();
+
+    ticker_running = 0;
+    pthread_join(ticker_thread, NULL);
+    hk_ok = (sync_hk() == 0);
+
+    cfe_host_stop();
+    send_no_args(SECURITY_APP_CMD_MID, SECURITY_APP_NOOP_CC);
+    pthread_join(app_thread, NULL);
+
+    end = gen.last_delivery_ns > last_send ? gen.last_delivery_ns : last_send;
+    report((end - start) / 1e9, (last_send - start) / 1e9, max_lag, hk_ok);
+
+    /* Child tasks never return; leaving main ends them */
+    return 0;
+}
@@ -0,0 +1,237 @@
+/*
+** Security App anti-replay check
+**
+** Runs the whole app on the host cFE stub and checks that a record whose
+** sequence number is not authenticated cannot move the replay window: a
+** CTR record with its sequence number pushed near 0xFFFFFFFF is decrypted,
+** and a genuine tagged record (GCM, or ChaCha20-Poly1305 without GCM) on the
+** same key must still be accepted after it. The same tagged record sent
+** again must then be dropped as a replay, and a flood of such replays must
+** not flood the event log.
+**
+** Needs AES-256-CTR and a tagged suite; exits 77, which CTest reports as
+** skipped, without them. Registered with CTest; exits 0 on success.
+*/
+#include "cfe.h"
+#include "cfe_host.h"
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_OUTPUT_MID     0x0A00
+#define TEST_OUTPUTS        8
+#define TEST_KEY_ID         0
+#define TEST_DATA_SIZE      100
+#define TEST_TIMEOUT_MS     2000
+#define TEST_ABSENT_MS      300
+#define TEST_FLOOD          20      /* Below the data pipe congestion watermark */
+#define TEST_REPLAY_EVENTS  16      /* Let through by SECURITY_APP_REPLAY_EVENT_MASK */
+#define TEST_SKIPPED        77
+
+/* Outputs by message ID offset from TEST_OUTPUT_MID; only valid while received is set */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    uint32_t        hk_count;
+    int             received[TEST_OUTPUTS];
+    uint16_t        length[TEST_OUTPUTS];
+    uint8_t         packet[TEST_OUTPUTS][sizeof(SECURITY_APP_DecryptCmd_t)] __attribute__((aligned(16)));
+} test = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static uint8_t plaintext[TEST_DATA_SIZE];
+
+static void test_sink(CFE_SB_MsgPtr_t msg, void *arg)
+{
+    CFE_SB_MsgId_t mid = CFE_SB_GetMsgId(msg);
+    uint16_t length = CFE_SB_GetTotalMsgLength(msg);
+
+    (void)arg;
+
+    pthread_mutex_lock(&test.lock);
+    if (mid == SECURITY_APP_HK_TLM_MID) {
+        test.hk_count++;
+    } else if (mid >= TEST_OUTPUT_MID && mid < TEST_OUTPUT_MID + TEST_OUTPUTS &&
+               length <= sizeof(test.packet[0])) {
+        memcpy(test.packet[mid - TEST_OUTPUT_MID], msg, length);
+        test.length[mid - TEST_OUTPUT_MID] = length;
+        test.received[mid - TEST_OUTPUT_MID] = 1;
+    }
+    pthread_cond_broadcast(&test.changed);
+    pthread_mutex_unlock(&test.lock);
+}
+
+static void *app_main(void *arg)
+{
+    (void)arg;
+    SECURITY_APP_Main();
+    return NULL;
+}
+
+static void deadline_after(struct timespec *ts, int ms)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_nsec += (long)ms * 1000000L;
+    ts->tv_sec += ts->tv_nsec / 1000000000L;
+    ts->tv_nsec %= 1000000000L;
+}
+
+/* Wait up to ms for output slot; 0 once it has arrived */
+static int wait_output(int slot, int ms)
+{
+    struct timespec deadline;
+    int received;
+
+    deadline_after(&deadline, ms);
+    pthread_mutex_lock(&test.lock);
+    while (!test.received[slot] &&
+           pthread_cond_timedwait(&test.changed, &test.lock, &deadline) == 0) {
+    }
+    received = test.received[slot];
+    pthread_mutex_unlock(&test.lock);
+
+    return received ? 0 : -1;
+}
+
+/* The app is up once it answers housekeeping; requests sent before it subscribes are lost */
+static int wait_started(void)
+{
+    SECURITY_APP_NoArgsCmd_t cmd;
+    struct timespec deadline;
+    int tries;
+    int started = 0;
+
+    for (tries = 0; tries < TEST_TIMEOUT_MS / 100 && !started; tries++) {
+        CFE_SB_InitMsg(&cmd, SECURITY_APP_SEND_HK_MID, sizeof(cmd), TRUE);
+        CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+
+        deadline_after(&deadline, 100);
+        pthread_mutex_lock(&test.lock);
+        while (test.hk_count == 0 &&
+               pthread_cond_timedwait(&test.changed, &test.lock, &deadline) == 0) {
+        }
+        started = test.hk_count != 0;
+        pthread_mutex_unlock(&test.lock);
+    }
+
+    return started ? 0 : -1;
+}
+
+static void send_encrypt(uint8_t suite, int slot)
+{
+    static SECURITY_APP_EncryptCmd_t cmd __attribute__((aligned(16)));
+
+    CFE_SB_InitMsg(&cmd, SECURITY_APP_DATA_CMD_MID, offsetof(SECURITY_APP_EncryptCmd_t, Data) + TEST_DATA_SIZE,
+                   TRUE);
+    CFE_SB_SetCmdCode((CFE_SB_MsgPtr_t)&cmd, SECURITY_APP_ENCRYPT_CC);
+    cmd.DataLength = TEST_DATA_SIZE;
+    cmd.TargetMsgID = TEST_OUTPUT_MID + slot;
+    cmd.Suite = suite;
+    cmd.KeyId = TEST_KEY_ID;
+    memcpy(cmd.Data, plaintext, TEST_DATA_SIZE);
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+}
+
+/* Send the record published in slot from back for decryption, with the output in slot to */
+static void send_decrypt(int from, int to, uint32_t sequence)
+{
+    static SECURITY_APP_DecryptCmd_t cmd __attribute__((aligned(16)));
+    const SECURITY_APP_EncryptedTlm_t *tlm = (const SECURITY_APP_EncryptedTlm_t *)test.packet[from];
+    uint16_t length = test.length[from] - offsetof(SECURITY_APP_EncryptedTlm_t, Record);
+
+    CFE_SB_InitMsg(&cmd, SECURITY_APP_DATA_CMD_MID, offsetof(SECURITY_APP_DecryptCmd_t, Record) + length, TRUE);
+    CFE_SB_SetCmdCode((CFE_SB_MsgPtr_t)&cmd, SECURITY_APP_DECRYPT_CC);
+    cmd.DataLength = length;
+    cmd.TargetMsgID = TEST_OUTPUT_MID + to;
+    memcpy(cmd.Record, tlm->Record, length);
+
+    /* Header bytes 4-7: big-endian sequence number, 0 to leave it as sent */
+    if (sequence != 0) {
+        cmd.Record[4] = (uint8_t)(sequence >> 24);
+        cmd.Record[5] = (uint8_t)(sequence >> 16);
+        cmd.Record[6] = (uint8_t)(sequence >> 8);
+        cmd.Record[7] = (uint8_t)sequence;
+    }
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+}
+
+static int check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+    return ok ? 0 : 1;
+}
+
+int main(void)
+{
+    const SECURITY_APP_DecryptedTlm_t *decrypted;
+    pthread_t app_thread;
+    uint32_t errors;
+    uint8_t suite;
+    int failures = 0;
+    int i;
+
+    for (i = 0; i < TEST_DATA_SIZE; i++) {
+        plaintext[i] = (uint8_t)(i * 13 + 5);
+    }
+
+    cfe_host_set_sink(test_sink, NULL);
+    if (pthread_create(&app_thread, NULL, app_main, NULL) != 0) {
+        perror("pthread_create");
+        return 1;
+    }
+    if (wait_started() != 0) {
+        fprintf(stderr, "app did not start\n");
+        return 1;
+    }
+
+    if (SECURITY_APP_CryptoProvider(SECURITY_APP_SUITE_AES256_GCM) != SECURITY_APP_PROVIDER_NONE) {
+        suite = SECURITY_APP_SUITE_AES256_GCM;
+    } else {
+        suite = SECURITY_APP_SUITE_CHACHA20_POLY1305;
+    }
+    if (SECURITY_APP_CryptoProvider(SECURITY_APP_SUITE_AES256_CTR) == SECURITY_APP_PROVIDER_NONE ||
+        SECURITY_APP_CryptoProvider(suite) == SECURITY_APP_PROVIDER_NONE) {
+        printf("skipped: no CTR or tagged suite available\n");
+        cfe_host_stop();
+        pthread_join(app_thread, NULL);
+        return TEST_SKIPPED;
+    }
+
+    /* A CTR record with a tampered sequence number still decrypts; it has no tag */
+    send_encrypt(SECURITY_APP_SUITE_AES256_CTR, 0);
+    failures += check(wait_output(0, TEST_TIMEOUT_MS) == 0, "CTR record encrypted");
+    send_decrypt(0, 1, 0xFFFFFFF0);
+    failures += check(wait_output(1, TEST_TIMEOUT_MS) == 0, "tampered CTR record decrypted");
+
+    /* It must not have moved the window for the key's genuine records */
+    send_encrypt(suite, 2);
+    failures += check(wait_output(2, TEST_TIMEOUT_MS) == 0, "tagged record encrypted");
+    send_decrypt(2, 3, 0);
+    failures += check(wait_output(3, TEST_TIMEOUT_MS) == 0, "tagged record after tampered CTR accepted");
+    decrypted = (const SECURITY_APP_DecryptedTlm_t *)test.packet[3];
+    failures += check(test.received[3] && decrypted->DataLength == TEST_DATA_SIZE &&
+                      memcmp(decrypted->Data, plaintext, TEST_DATA_SIZE) == 0, "tagged plaintext matches");
+
+    /* The window still works for tagged records */
+    send_decrypt(2, 4, 0);
+    failures += check(wait_output(4, TEST_ABSENT_MS) != 0, "replayed tagged record dropped");
+
+    /* Data commands are handled in order, so the flood is done once the next output arrives */
+    errors = cfe_host_event_count(CFE_EVS_ERROR);
+    for (i = 0; i < TEST_FLOOD; i++) {
+        send_decrypt(2, 4, 0);
+    }
+    send_encrypt(suite, 5);
+    failures += check(wait_output(5, TEST_TIMEOUT_MS) == 0, "record after replay flood encrypted");
+    failures += check(test.received[4] == 0, "replay flood dropped");
+    failures += check(cfe_host_event_count(CFE_EVS_ERROR) - errors < TEST_REPLAY_EVENTS, "replay events filtered");
+
+    cfe_host_stop();
+    pthread_join(app_thread, NULL);
+
+    printf("%d failure(s)\n", failures);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,285 @@
+/*
+** Security App stream session authentication check
+**
+** Runs the whole app on the host cFE stub, encrypts a three-segment product
+** in a stream session, then decrypts it twice: once with a forged tag, which
+** must yield nothing but an END packet flagged AUTH_FAIL, and once with the
+** genuine tag, which must release the whole plaintext flagged AUTH_OK.
+**
+** Needs a tagged counter-based suite (libgcrypt); exits 77, which CTest
+** reports as skipped, without one. Registered with CTest; exits 0 on success.
+*/
+#include "cfe.h"
+#include "cfe_host.h"
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_ENCRYPT_MID    0x0A00
+#define TEST_FORGED_MID     0x0A01
+#define TEST_GENUINE_MID    0x0A02
+#define TEST_KEY_ID         0
+#define TEST_SEGMENTS       3
+#define TEST_PACKETS        32
+#define TEST_TIMEOUT_MS     2000
+#define TEST_SKIPPED        77
+
+static const uint16_t segment_length[TEST_SEGMENTS] = { 128, 128, 40 };
+
+#define TEST_DATA_SIZE      (128 + 128 + 40)
+
+/* Every stream packet the app publishes, in order */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    uint32_t        hk_count;
+    int             count;
+    CFE_SB_MsgId_t  mid[TEST_PACKETS];
+    SECURITY_APP_StreamTlm_t packet[TEST_PACKETS] __attribute__((aligned(16)));
+} test = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static uint8_t plaintext[TEST_DATA_SIZE];
+static uint8_t ciphertext[TEST_DATA_SIZE];
+static uint8_t iv[16];
+static uint8_t tag[16];
+
+static void test_sink(CFE_SB_MsgPtr_t msg, void *arg)
+{
+    CFE_SB_MsgId_t mid = CFE_SB_GetMsgId(msg);
+    uint16_t length = CFE_SB_GetTotalMsgLength(msg);
+
+    (void)arg;
+
+    pthread_mutex_lock(&test.lock);
+    if (mid == SECURITY_APP_HK_TLM_MID) {
+        test.hk_count++;
+    } else if (mid >= TEST_ENCRYPT_MID && mid <= TEST_GENUINE_MID && test.count < TEST_PACKETS &&
+               length <= sizeof(test.packet[0])) {
+        memset(&test.packet[test.count], 0, sizeof(test.packet[0]));
+        memcpy(&test.packet[test.count], msg, length);
+        test.mid[test.count++] = mid;
+    }
+    pthread_cond_broadcast(&test.changed);
+    pthread_mutex_unlock(&test.lock);
+}
+
+static void *app_main(void *arg)
+{
+    (void)arg;
+    SECURITY_APP_Main();
+    return NULL;
+}
+
+static void deadline_after(struct timespec *ts, int ms)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_nsec += (long)ms * 1000000L;
+    ts->tv_sec += ts->tv_nsec / 1000000000L;
+    ts->tv_nsec %= 1000000000L;
+}
+
+/* The app is up once it answers housekeeping; requests sent before it subscribes are lost */
+static int wait_started(void)
+{
+    SECURITY_APP_NoArgsCmd_t cmd;
+    struct timespec deadline;
+    int tries;
+    int started = 0;
+
+    for (tries = 0; tries < TEST_TIMEOUT_MS / 100 && !started; tries++) {
+        CFE_SB_InitMsg(&cmd, SECURITY_APP_SEND_HK_MID, sizeof(cmd), TRUE);
+        CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+
+        deadline_after(&deadline, 100);
+        pthread_mutex_lock(&test.lock);
+        while (test.hk_count == 0 &&
+               pthread_cond_timedwait(&test.changed, &test.lock, &deadline) == 0) {
+        }
+        started = test.hk_count != 0;
+        pthread_mutex_unlock(&test.lock);
+    }
+
+    return started ? 0 : -1;
+}
+
+/* Wait for a packet on mid with all of flags set; its index, or -1 */
+static int wait_packet(CFE_SB_MsgId_t mid, uint8_t flags)
+{
+    struct timespec deadline;
+    int found = -1;
+    int i;
+
+    deadline_after(&deadline, TEST_TIMEOUT_MS);
+    pthread_mutex_lock(&test.lock);
+    for (;;) {
+        for (i = 0; i < test.count && found < 0; i++) {
+            if (test.mid[i] == mid && (test.packet[i].Flags & flags) == flags) {
+                found = i;
+            }
+        }
+        if (found >= 0 || pthread_cond_timedwait(&test.changed, &test.lock, &deadline) != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&test.lock);
+
+    return found;
+}
+
+/* Open a session publishing to mid; its session ID, or -1 */
+static int send_begin(uint8_t suite, uint8_t direction, CFE_SB_MsgId_t mid)
+{
+    SECURITY_APP_StreamBeginCmd_t cmd;
+    int begin;
+
+    CFE_SB_InitMsg(&cmd, SECURITY_APP_DATA_CMD_MID, sizeof(cmd), TRUE);
+    CFE_SB_SetCmdCode((CFE_SB_MsgPtr_t)&cmd, SECURITY_APP_STREAM_BEGIN_CC);
+    cmd.TargetMsgID = mid;
+    cmd.Suite = suite;
+    cmd.Direction = direction;
+    cmd.KeyId = TEST_KEY_ID;
+    memcpy(cmd.IV, iv, sizeof(cmd.IV));
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+
+    begin = wait_packet(mid, SECURITY_APP_STREAM_FLAG_BEGIN);
+    if (begin < 0) {
+        return -1;
+    }
+    if (direction == SECURITY_APP_STREAM_ENCRYPT) {
+        memcpy(iv, test.packet[begin].IV, sizeof(iv));
+    }
+
+    return test.packet[begin].SessionId;
+}
+
+/* Send every segment of data through a session, the last one as END with end_tag */
+static void send_segments(int session, const uint8_t *data, const uint8_t *end_tag)
+{
+    static SECURITY_APP_StreamDataCmd_t cmd __attribute__((aligned(16)));
+    uint16_t offset = 0;
+    int i;
+
+    for (i = 0; i < TEST_SEGMENTS; i++) {
+        CFE_SB_InitMsg(&cmd, SECURITY_APP_DATA_CMD_MID,
+                       offsetof(SECURITY_APP_StreamDataCmd_t, Data) + segment_length[i], TRUE);
+        CFE_SB_SetCmdCode((CFE_SB_MsgPtr_t)&cmd,
+                          (i == TEST_SEGMENTS - 1) ? SECURITY_APP_STREAM_END_CC : SECURITY_APP_STREAM_APPEND_CC);
+        cmd.SessionId = (uint8_t)session;
+        cmd.SegmentSeq = (uint16_t)i;
+        cmd.DataLength = segment_length[i];
+        if (end_tag != NULL) {
+            memcpy(cmd.Tag, end_tag, sizeof(cmd.Tag));
+        }
+        memcpy(cmd.Data, &data[offset], segment_length[i]);
+        offset += segment_length[i];
+        CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&cmd);
+    }
+}
+
+/* Concatenate the data of every packet on mid; number of data packets, total length in *length */
+static int collect(CFE_SB_MsgId_t mid, uint8_t *out, uint32_t *length)
+{
+    int packets = 0;
+    int i;
+
+    *length = 0;
+    pthread_mutex_lock(&test.lock);
+    for (i = 0; i < test.count; i++) {
+        if (test.mid[i] == mid && test.packet[i].DataLength > 0 &&
+            *length + test.packet[i].DataLength <= TEST_DATA_SIZE) {
+            memcpy(&out[*length], test.packet[i].Data, test.packet[i].DataLength);
+            *length += test.packet[i].DataLength;
+            packets++;
+        }
+    }
+    pthread_mutex_unlock(&test.lock);
+
+    return packets;
+}
+
+static int check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+    return ok ? 0 : 1;
+}
+
+int main(void)
+{
+    uint8_t forged[16];
+    uint8_t decrypted[TEST_DATA_SIZE];
+    pthread_t app_thread;
+    uint32_t length;
+    uint8_t suite;
+    int session;
+    int end;
+    int failures = 0;
+    int i;
+
+    for (i = 0; i < TEST_DATA_SIZE; i++) {
+        plaintext[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    cfe_host_set_sink(test_sink, NULL);
+    if (pthread_create(&app_thread, NULL, app_main, NULL) != 0) {
+        perror("pthread_create");
+        return 1;
+    }
+    if (wait_started() != 0) {
+        fprintf(stderr, "app did not start\n");
+        return 1;
+    }
+
+    if (SECURITY_APP_CryptoProvider(SECURITY_APP_SUITE_AES256_GCM) != SECURITY_APP_PROVIDER_NONE) {
+        suite = SECURITY_APP_SUITE_AES256_GCM;
+    } else if (SECURITY_APP_CryptoProvider(SECURITY_APP_SUITE_CHACHA20_POLY1305) != SECURITY_APP_PROVIDER_NONE) {
+        suite = SECURITY_APP_SUITE_CHACHA20_POLY1305;
+    } else {
+        printf("skipped: no tagged stream suite available\n");
+        cfe_host_stop();
+        pthread_join(app_thread, NULL);
+        return TEST_SKIPPED;
+    }
+
+    /* Encrypt the product to get a genuine ciphertext and tag */
+    session = send_begin(suite, SECURITY_APP_STREAM_ENCRYPT, TEST_ENCRYPT_MID);
+    failures += check(session >= 0, "encrypt session opened");
+    send_segments(session, plaintext, NULL);
+    end = wait_packet(TEST_ENCRYPT_MID, SECURITY_APP_STREAM_FLAG_END);
+    failures += check(end >= 0, "encrypt session closed");
+    if (end >= 0) {
+        memcpy(tag, test.packet[end].Tag, sizeof(tag));
+    }
+    failures += check(collect(TEST_ENCRYPT_MID, ciphertext, &length) == TEST_SEGMENTS &&
+                      length == TEST_DATA_SIZE, "ciphertext published per segment");
+
+    /* A forged tag must release no plaintext at all */
+    memcpy(forged, tag, sizeof(forged));
+    forged[0] ^= 0x01;
+    session = send_begin(suite, SECURITY_APP_STREAM_DECRYPT, TEST_FORGED_MID);
+    failures += check(session >= 0, "forged decrypt session opened");
+    send_segments(session, ciphertext, forged);
+    end = wait_packet(TEST_FORGED_MID, SECURITY_APP_STREAM_FLAG_END);
+    failures += check(end >= 0 && (test.packet[end].Flags & SECURITY_APP_STREAM_FLAG_AUTH_FAIL) &&
+                      test.packet[end].DataLength == 0, "forged stream flagged AUTH_FAIL");
+    failures += check(collect(TEST_FORGED_MID, decrypted, &length) == 0, "forged stream released no plaintext");
+
+    /* The genuine tag releases the whole product */
+    session = send_begin(suite, SECURITY_APP_STREAM_DECRYPT, TEST_GENUINE_MID);
+    failures += check(session >= 0, "genuine decrypt session opened");
+    send_segments(session, ciphertext, tag);
+    end = wait_packet(TEST_GENUINE_MID, SECURITY_APP_STREAM_FLAG_END | SECURITY_APP_STREAM_FLAG_AUTH_OK);
+    failures += check(end >= 0 && test.packet[end].TotalLength == TEST_DATA_SIZE, "genuine stream flagged AUTH_OK");
+    collect(TEST_GENUINE_MID, decrypted, &length);
+    failures += check(length == TEST_DATA_SIZE && memcmp(decrypted, plaintext, TEST_DATA_SIZE) == 0,
+                      "genuine plaintext matches");
+
+    cfe_host_stop();
+    pthread_join(app_thread, NULL);
+
+    printf("%d failure(s)\n", failures);
+
+    return failures ? 1 : 0;
+}
@@ -5,7 +5,10 @@
 ** Mission Configuration Parameters for the Security App
 */
 
-/** \brief Pipe depth for the command pipe */
-#define SECURITY_APP_PIPE_DEPTH    32
+/** \brief Pipe depth for the control pipe (HK and performance requests, control commands) */
+#define SECURITY_APP_CONTROL_PIPE_DEPTH    8
 
-#endif /* SECURITY_APP_MISSION_CFG_H */
\ No newline at end of file
+/** \brief Pipe depth for the data pipe (crypto commands and inline streams) */
+#define SECURITY_APP_DATA_PIPE_DEPTH       32
+
+#endif /* SECURITY_APP_MISSION_CFG_H */
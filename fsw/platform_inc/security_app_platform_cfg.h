@@ -8,10 +8,294 @@
 /** \brief Maximum number of SECURITY_APP housekeeping packets in downlink queue */
 #define SECURITY_APP_HK_TLM_MID    0x0000  /* To be set by mission configuration */
 
-/** \brief Command mid */
+/**
+** \brief Command mid
+**
+** Read from the control pipe. Takes the control commands only (no-op, reset
+** counters, accounting dump); crypto command codes sent here are refused
+** with an error event.
+*/
 #define SECURITY_APP_CMD_MID       0x0000  /* To be set by mission configuration */
 
+/**
+** \brief Bulk crypto command mid
+**
+** Read from the data pipe, behind anything on the control pipe. Encrypt,
+** decrypt, sign, verify, batch, stream and file commands must be sent here
+** so they never hold up housekeeping or control commands; it also takes the
+** control command codes.
+*/
+#define SECURITY_APP_DATA_CMD_MID  0x0000  /* To be set by mission configuration */
+
 /** \brief Send housekeeping message command */
 #define SECURITY_APP_SEND_HK_MID   0x0000  /* To be set by mission configuration */
 
+/** \brief Send performance telemetry command */
+#define SECURITY_APP_SEND_PERF_MID 0x0000  /* To be set by mission configuration */
+
+/** \brief Scheduler wakeup (used when SECURITY_APP_SCHEDULED_MODE is 1) */
+#define SECURITY_APP_WAKEUP_MID    0x0000  /* To be set by mission configuration */
+
+/** \brief Performance telemetry */
+#define SECURITY_APP_PERF_TLM_MID  0x0000  /* To be set by mission configuration */
+
+/** \brief Crypto statistics telemetry */
+#define SECURITY_APP_STATS_TLM_MID 0x0000  /* To be set by mission configuration */
+
+/** \brief Per-stream accounting telemetry */
+#define SECURITY_APP_ACCT_TLM_MID  0x0000  /* To be set by mission configuration */
+
+/** \brief Data pipe load and congestion telemetry */
+#define SECURITY_APP_LOAD_TLM_MID  0x0000  /* To be set by mission configuration */
+
+/**
+** \brief EVS binary filter mask for per-operation success events
+**
+** Applied to the encrypt and decrypt info events at registration. The
+** default (CFE_EVS_FIRST_ONE_STOP) lets only the first of each through; 0
+** passes every one. Ground can change it at runtime with the EVS set-filter
+** command. Throughput is reported by the statistics packet instead.
+*/
+#define SECURITY_APP_OP_EVENT_MASK      0xFFFF
+
+/**
+** \brief EVS binary filter mask for anti-replay drop events
+**
+** Applied to the replay error event at registration, so a peer replaying
+** or flooding old records cannot flood the event log. The default
+** (CFE_EVS_FIRST_16_STOP) lets the first 16 through; every drop is still
+** counted in housekeeping (ReplayRejectCount).
+*/
+#define SECURITY_APP_REPLAY_EVENT_MASK  0xFFF0
+
+/** \brief Housekeeping requests between statistics packets */
+#define SECURITY_APP_STATS_REPORT_CYCLES  10
+
+/**
+** \brief Zero-copy output mode
+**
+** When set to 1, encrypted and decrypted telemetry is built directly in a
+** Software Bus buffer (CFE_SB_ZeroCopyGetPtr) and published with
+** CFE_SB_ZeroCopySend. When set to 0, packets are built on the task stack
+** and copied into the SB by CFE_SB_SendMsg.
+*/
+#define SECURITY_APP_ZERO_COPY_OUTPUT   0
+
+/**
+** \brief Longest the main task blocks on the data pipe, in ms
+**
+** With both pipes empty the main task pends on the data pipe; this bounds
+** how long an idle app takes to notice a control message.
+*/
+#define SECURITY_APP_CONTROL_POLL_MS    10
+
+/**
+** \brief Scheduler-driven processing
+**
+** When set to 1, the data pipe is only read when SECURITY_APP_WAKEUP_MID
+** arrives. Each wakeup drains the pipes without blocking until the pipes are
+** empty or the cycle budget below is used up; anything still queued is
+** handled on the next wakeup. Between wakeups only control pipe traffic
+** (housekeeping and performance requests, control command codes) is
+** handled, since crypto commands are only accepted on
+** SECURITY_APP_DATA_CMD_MID. When set to 0, data is processed as soon as it
+** arrives.
+*/
+#define SECURITY_APP_SCHEDULED_MODE     0
+
+/** \brief Messages handled per scheduler wakeup */
+#define SECURITY_APP_CYCLE_OP_BUDGET    16
+
+/** \brief Message bytes handled per scheduler wakeup */
+#define SECURITY_APP_CYCLE_BYTE_BUDGET  16384
+
+/**
+** \brief Data pipe congestion watermark, percent of SECURITY_APP_DATA_PIPE_DEPTH
+**
+** Once the estimated backlog reaches this, normal priority data pipe traffic
+** is deferred and low priority traffic dropped until the pipe drains.
+*/
+#define SECURITY_APP_CONGESTION_WATERMARK  75
+
+/** \brief Priority of commands on SECURITY_APP_DATA_CMD_MID under congestion (SECURITY_APP_PRIO_*) */
+#define SECURITY_APP_DATA_CMD_PRIORITY  SECURITY_APP_PRIO_NORMAL
+
+/** \brief Messages the deferral queue can hold */
+#define SECURITY_APP_DEFER_DEPTH        16
+
+/**
+** \brief Largest message that can be deferred, in bytes
+**
+** Covers inline packets and single-record commands; larger normal priority
+** messages are dropped instead when the pipe is congested.
+*/
+#define SECURITY_APP_DEFER_MSG_SIZE     1280
+
+/** \brief Maximum number of concurrently open stream sessions */
+#define SECURITY_APP_MAX_STREAMS        4
+
+/**
+** \brief Largest product a decrypt stream session can carry, in bytes
+**
+** Decrypt sessions hold their plaintext until END has checked the tag, in
+** one buffer of this size per session. Longer products must be decrypted
+** with the file commands instead. Must be a multiple of 64.
+*/
+#define SECURITY_APP_STREAM_HOLD_SIZE   16384
+
+/**
+** \brief Number of crypto worker child tasks
+**
+** When non-zero, encrypt and decrypt jobs are handed from the main task to
+** this many worker tasks through lock-free rings, and a separate output task
+** publishes the results in command order. When zero, all crypto runs inline
+** on the main task.
+*/
+#define SECURITY_APP_NUM_WORKERS        0
+
+/** \brief Jobs each worker ring can hold in flight */
+#define SECURITY_APP_WORKER_QUEUE_DEPTH 8
+
+/** \brief Stack size of each worker task and of the output task */
+#define SECURITY_APP_WORKER_STACK_SIZE  16384
+
+/** \brief Priority of the crypto worker tasks */
+#define SECURITY_APP_WORKER_PRIORITY    80
+
+/** \brief Priority of the output task (should be at or above the workers) */
+#define SECURITY_APP_OUTPUT_PRIORITY    79
+
+/**
+** \brief Size of each of the file task's two I/O buffers
+**
+** The reader task fills one buffer while the file task encrypts and writes
+** the other. Must be a multiple of 64 bytes.
+*/
+#define SECURITY_APP_FILE_CHUNK_SIZE    32768
+
+/** \brief Priority of the file task and its reader task (below the crypto path) */
+#define SECURITY_APP_FILE_TASK_PRIORITY 110
+
+/** \brief Stack size of the file task and its reader task */
+#define SECURITY_APP_FILE_TASK_STACK_SIZE  8192
+
+/** \brief Name of the inline encryption table */
+#define SECURITY_APP_INLINE_TBL_NAME          "InlineTbl"
+
+/** \brief Default file loaded into the inline encryption table at startup */
+#define SECURITY_APP_INLINE_TBL_FILENAME      "/cf/security_app_inline_tbl.tbl"
+
+/** \brief Number of entries in the inline encryption table */
+#define SECURITY_APP_INLINE_TBL_MAX_ENTRIES   16
+
+/** \brief Number of key IDs */
+#define SECURITY_APP_MAX_KEYS           8
+
+/** \brief Name of the key table */
+#define SECURITY_APP_KEY_TBL_NAME       "KeyTbl"
+
+/** \brief Default file loaded into the key table at startup */
+#define SECURITY_APP_KEY_TBL_FILENAME   "/cf/security_app_key_tbl.tbl"
+
+/**
+** \brief Anti-replay window, in sequence numbers
+**
+** Each key ID accepts a decrypted record only if its sequence number has not
+** been accepted before and is less than this far behind the newest one
+** accepted. Must be a multiple of 32.
+*/
+#define SECURITY_APP_REPLAY_WINDOW      128
+
+/** \brief Name of the critical data store block holding outgoing sequence numbers */
+#define SECURITY_APP_REPLAY_CDS_NAME    "TxSeq"
+
+/**
+** \brief Outgoing sequence numbers reserved per critical data store write
+**
+** Each key's reservation is saved before any number in it is sent, and a
+** restart resumes after it, so up to this many numbers per key are skipped
+** on every restart. Larger values mean fewer CDS writes.
+*/
+#define SECURITY_APP_TX_SEQ_RESERVE     1024
+
+/**
+** \brief Target message IDs tracked by per-stream accounting
+**
+** Must be a power of two, and should be about twice the number of streams
+** in use so that probes stay short.
+*/
+#define SECURITY_APP_ACCT_TBL_SIZE      64
+
+/** \brief cFE file header subtype of per-stream accounting dump files */
+#define SECURITY_APP_ACCT_FILE_SUBTYPE  0x53414331
+
+/** \brief Pre-generated random IVs held per crypto channel */
+#define SECURITY_APP_NONCE_POOL_DEPTH   64
+
+/** \brief Ring level at which the refill task is woken */
+#define SECURITY_APP_NONCE_LOW_WATER    16
+
+/**
+** \brief Deterministic nonces for counter-based suites
+**
+** When set to 1, CTR, GCM and ChaCha20-Poly1305 use a salt | channel |
+** counter nonce instead of pool IVs. The salt and counter are kept in a
+** critical data store block so that no nonce repeats across restarts; when
+** the CDS cannot be used the app falls back to random pool IVs. CBC always
+** uses random pool IVs.
+*/
+#define SECURITY_APP_COUNTER_NONCES     1
+
+/** \brief Name of the critical data store block holding the counter nonces */
+#define SECURITY_APP_NONCE_CDS_NAME     "Nonces"
+
+/**
+** \brief Counter nonce values reserved per critical data store write
+**
+** Each channel's reservation is saved before any value in it is used, and
+** a restart resumes after it, so up to this many values per channel are
+** skipped on every restart.
+*/
+#define SECURITY_APP_NONCE_RESERVE      65536
+
+/** \brief Priority of the IV refill task (lowest of the app's tasks) */
+#define SECURITY_APP_NONCE_TASK_PRIORITY  120
+
+/** \brief Stack size of the IV refill task */
+#define SECURITY_APP_NONCE_TASK_STACK_SIZE  8192
+
+/** \brief Longest the refill task sleeps before topping up the rings anyway, in ms */
+#define SECURITY_APP_NONCE_REFILL_PERIOD_MS  1000
+
+/**
+** \brief Messages CBC-encrypted together by the multi-buffer kernel (1 to 8)
+**
+** Batch encrypt commands are worked off in groups of this many records.
+** Where the suite's provider has a multi-buffer kernel (AES-256 CBC on the
+** built-in AES-NI and VAES providers), the block chains of a group are
+** interleaved so the serial CBC chains of small messages keep the AES unit
+** busy. Output is identical to encrypting the records one by one.
+*/
+#define SECURITY_APP_MULTI_BUFFERS      8
+
+/**
+** \brief Build the libgcrypt crypto provider (every cipher suite)
+**
+** Normally set by the CMake option of the same name.
+*/
+#ifndef SECURITY_APP_WITH_GCRYPT
+#define SECURITY_APP_WITH_GCRYPT        1
+#endif
+
+/**
+** \brief Build the built-in AES-NI and VAES providers (AES-256 CBC and CTR, x86 only)
+**
+** Normally set by the CMake option of the same name. Each is only used on a
+** CPU that has the instructions, and wins over libgcrypt for the suites it
+** covers.
+*/
+#ifndef SECURITY_APP_WITH_AESNI
+#define SECURITY_APP_WITH_AESNI         1
+#endif
+
 #endif /* SECURITY_APP_PLATFORM_CFG_H */
\ No newline at end of file
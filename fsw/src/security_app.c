@@ -1,13 +1,157 @@
 #include "security_app.h"
+#include "security_app_acct.h"
+#include "security_app_compress.h"
 #include "security_app_crypto.h"
 #include "security_app_events.h"
+#include "security_app_load.h"
+#include "security_app_perf.h"
+#include "security_app_replay.h"
 #include "security_app_version.h"
+#include "security_app_wire.h"
+#include "security_app_worker.h"
+
+#include <stddef.h>
 
 /*
 ** global data
 */
 SECURITY_APP_Data_t SECURITY_APP_Data;
 
+/*
+** Staging buffers for compressed payloads, one per crypto channel; only the
+** channel's own task touches its buffer
+*/
+static uint8 SECURITY_APP_CodecBuf[SECURITY_APP_CRYPTO_CHANNELS][SECURITY_APP_MAX_PAYLOAD_LENGTH]
+    __attribute__((aligned(16)));
+
+/*
+** Per-operation success events are filtered at registration; throughput is
+** reported through the statistics packet instead. Replay drops are filtered
+** too and counted in housekeeping.
+*/
+static CFE_EVS_BinFilter_t SECURITY_APP_EventFilters[] =
+{
+    { SECURITY_APP_ENCRYPT_INF_EID, SECURITY_APP_OP_EVENT_MASK },
+    { SECURITY_APP_DECRYPT_INF_EID, SECURITY_APP_OP_EVENT_MASK },
+    { SECURITY_APP_REPLAY_ERR_EID, SECURITY_APP_REPLAY_EVENT_MASK },
+};
+
+/*
+** Take the next message from one pipe, blocking for up to Timeout once the
+** pipe is found empty (CFE_SB_POLL does not block)
+*/
+static int32 SECURITY_APP_ReceiveFrom(uint8 Pipe, CFE_SB_MsgPtr_t *Msg, int32 Timeout)
+{
+    CFE_SB_PipeId_t PipeId = (Pipe == SECURITY_APP_PIPE_CONTROL) ? SECURITY_APP_Data.ControlPipe
+                                                                  : SECURITY_APP_Data.DataPipe;
+    int32 status;
+
+    status = CFE_SB_RcvMsg(Msg, PipeId, CFE_SB_POLL);
+    if (status == CFE_SB_NO_MESSAGE)
+    {
+        SECURITY_APP_PerfRecordPipeEmpty(Pipe);
+        if (Pipe == SECURITY_APP_PIPE_DATA)
+        {
+            SECURITY_APP_LoadPipeEmpty();
+        }
+        if (Timeout != CFE_SB_POLL)
+        {
+            status = CFE_SB_RcvMsg(Msg, PipeId, Timeout);
+        }
+    }
+    if (status == CFE_SUCCESS)
+    {
+        SECURITY_APP_PerfRecordPipeMsg(Pipe);
+    }
+
+    return status;
+}
+
+/*
+** Take the next message, control pipe first. The data pipe is only read when
+** no control message is waiting, so HK requests and control commands never
+** queue behind bulk crypto. Data messages the load shedder defers or drops
+** are passed over; deferred ones come back once both pipes are empty. With
+** both pipes empty and nothing deferred the task blocks on the data pipe for
+** up to Timeout.
+*/
+static int32 SECURITY_APP_ReceiveMsg(CFE_SB_MsgPtr_t *Msg, int32 Timeout)
+{
+    int32 status;
+
+    for (;;)
+    {
+        status = SECURITY_APP_ReceiveFrom(SECURITY_APP_PIPE_CONTROL, Msg, CFE_SB_POLL);
+        if (status != CFE_SB_NO_MESSAGE)
+        {
+            return status;
+        }
+
+        status = SECURITY_APP_ReceiveFrom(SECURITY_APP_PIPE_DATA, Msg,
+                                          (SECURITY_APP_LoadDeferred() > 0) ? CFE_SB_POLL : Timeout);
+        if (status != CFE_SUCCESS || SECURITY_APP_LoadAdmit(*Msg))
+        {
+            break;
+        }
+    }
+
+    if ((status == CFE_SB_NO_MESSAGE || status == CFE_SB_TIME_OUT) && SECURITY_APP_LoadTakeDeferred(Msg))
+    {
+        status = CFE_SUCCESS;
+    }
+
+    return status;
+}
+
+/* Process one received message, timing it for performance telemetry */
+static void SECURITY_APP_HandleMsg(CFE_SB_MsgPtr_t Msg)
+{
+    uint64 Start = SECURITY_APP_PerfNow();
+
+    SECURITY_APP_ProcessCommandPacket(Msg);
+    SECURITY_APP_PerfRecordCommand(Start);
+}
+
+#if (SECURITY_APP_SCHEDULED_MODE == 1)
+/*
+** Handle one scheduler wakeup: drain both pipes, control first, without
+** blocking until they are empty or the cycle budget is used up. The budget
+** is checked before each message, so a cycle overruns it by at most one
+** message. Anything left stays queued for the next wakeup.
+*/
+static int32 SECURITY_APP_RunCycle(void)
+{
+    CFE_SB_MsgPtr_t Msg;
+    uint64 Start = SECURITY_APP_PerfNow();
+    uint16 Ops = 0;
+    uint32 Bytes = 0;
+    int32 status = CFE_SUCCESS;
+
+    while (Ops < SECURITY_APP_CYCLE_OP_BUDGET && Bytes < SECURITY_APP_CYCLE_BYTE_BUDGET)
+    {
+        status = SECURITY_APP_ReceiveMsg(&Msg, CFE_SB_POLL);
+        if (status != CFE_SUCCESS)
+        {
+            break;
+        }
+
+        /* A wakeup that queued while this cycle ran adds nothing */
+        if (CFE_SB_GetMsgId(Msg) == SECURITY_APP_WAKEUP_MID)
+        {
+            continue;
+        }
+
+        Ops++;
+        Bytes += CFE_SB_GetTotalMsgLength(Msg);
+        SECURITY_APP_HandleMsg(Msg);
+    }
+
+    SECURITY_APP_PerfRecordCycle(Ops, Bytes, status == CFE_SUCCESS, Start);
+
+    return (status == CFE_SB_NO_MESSAGE) ? CFE_SUCCESS : status;
+}
+#endif
+
 /* Application entry point and main process loop */
 void SECURITY_APP_Main(void)
 {
@@ -33,19 +177,32 @@ void SECURITY_APP_Main(void)
     */
     while (CFE_ES_RunLoop(&SECURITY_APP_Data.RunStatus) == TRUE)
     {
+#if (SECURITY_APP_SCHEDULED_MODE == 1)
         /*
-        ** Wait for message arrival
+        ** Control traffic is handled as it arrives; bulk data waits for
+        ** the next scheduler wakeup. The control pipe only carries
+        ** housekeeping, performance and wakeup requests and control command
+        ** codes (crypto codes on SECURITY_APP_CMD_MID are refused), so all
+        ** crypto work is charged to a cycle budget.
         */
-        status = CFE_SB_RcvMsg(&Msg, SECURITY_APP_Data.CmdPipe, CFE_SB_PEND_FOREVER);
-        
+        status = SECURITY_APP_ReceiveFrom(SECURITY_APP_PIPE_CONTROL, &Msg, CFE_SB_PEND_FOREVER);
+        if (status == CFE_SUCCESS && CFE_SB_GetMsgId(Msg) == SECURITY_APP_WAKEUP_MID)
+        {
+            status = SECURITY_APP_RunCycle();
+        }
+        else if (status == CFE_SUCCESS)
+        {
+            SECURITY_APP_HandleMsg(Msg);
+        }
+#else
+        status = SECURITY_APP_ReceiveMsg(&Msg, SECURITY_APP_CONTROL_POLL_MS);
         if (status == CFE_SUCCESS)
         {
-            /*
-            ** Process the received message
-            */
-            SECURITY_APP_ProcessCommandPacket(Msg);
+            SECURITY_APP_HandleMsg(Msg);
         }
-        else
+#endif
+        
+        if (status != CFE_SUCCESS && status != CFE_SB_TIME_OUT)
         {
             /*
             ** Exit on error
@@ -58,8 +215,9 @@ void SECURITY_APP_Main(void)
     }
 
     /*
-    ** Exit the application
+    ** Release the cipher contexts and exit the application
     */
+    SECURITY_APP_CleanupCrypto();
     CFE_ES_ExitApp(SECURITY_APP_Data.RunStatus);
 }
 
@@ -67,6 +225,7 @@ void SECURITY_APP_Main(void)
 int32 SECURITY_APP_Init(void)
 {
     int32 status;
+    uint8 Suite;
     
     /*
     ** Initialize app command execution counters
@@ -83,6 +242,13 @@ int32 SECURITY_APP_Init(void)
     SECURITY_APP_Data.HkTlm.DecryptionCount = 0;
     SECURITY_APP_Data.HkTlm.EncryptionErrorCount = 0;
     SECURITY_APP_Data.HkTlm.DecryptionErrorCount = 0;
+    memset(&SECURITY_APP_Data.Stats, 0, sizeof(SECURITY_APP_Data.Stats));
+    SECURITY_APP_Data.StatsCycles = 0;
+    
+    /*
+    ** No stream sessions are open at startup
+    */
+    memset(SECURITY_APP_Data.Streams, 0, sizeof(SECURITY_APP_Data.Streams));
     
     /*
     ** Initialize crypto subsystem
@@ -97,13 +263,17 @@ int32 SECURITY_APP_Init(void)
     /*
     ** Initialize app configuration data
     */
-    strncpy(SECURITY_APP_Data.PipeName, "SECURITY_APP_CMD_PIPE", sizeof(SECURITY_APP_Data.PipeName));
-    SECURITY_APP_Data.PipeDepth = SECURITY_APP_PIPE_DEPTH;
+    strncpy(SECURITY_APP_Data.ControlPipeName, "SEC_APP_CTL_PIPE", sizeof(SECURITY_APP_Data.ControlPipeName));
+    strncpy(SECURITY_APP_Data.DataPipeName, "SEC_APP_DATA_PIPE", sizeof(SECURITY_APP_Data.DataPipeName));
+    SECURITY_APP_Data.PipeDepth[SECURITY_APP_PIPE_CONTROL] = SECURITY_APP_CONTROL_PIPE_DEPTH;
+    SECURITY_APP_Data.PipeDepth[SECURITY_APP_PIPE_DATA] = SECURITY_APP_DATA_PIPE_DEPTH;
 
     /*
     ** Register for event services
     */
-    status = CFE_EVS_Register(NULL, 0, CFE_EVS_EventFilter_BINARY);
+    status = CFE_EVS_Register(SECURITY_APP_EventFilters,
+                              sizeof(SECURITY_APP_EventFilters) / sizeof(SECURITY_APP_EventFilters[0]),
+                              CFE_EVS_EventFilter_BINARY);
     if (status != CFE_SUCCESS)
     {
         CFE_ES_WriteToSysLog("Security App: Error Registering For Event Services, RC = 0x%08X\n", (unsigned int)status);
@@ -114,22 +284,43 @@ int32 SECURITY_APP_Init(void)
     ** Initialize housekeeping packet (clear user data area)
     */
     CFE_SB_InitMsg(&SECURITY_APP_Data.HkTlm, SECURITY_APP_HK_TLM_MID, sizeof(SECURITY_APP_HkTlm_t), TRUE);
+    CFE_SB_InitMsg(&SECURITY_APP_Data.StatsTlm, SECURITY_APP_STATS_TLM_MID, sizeof(SECURITY_APP_StatsTlm_t), TRUE);
+    for (Suite = 0; Suite < SECURITY_APP_SUITE_COUNT; Suite++)
+    {
+        SECURITY_APP_Data.HkTlm.CryptoProvider[Suite] = SECURITY_APP_CryptoProvider(Suite);
+    }
+    SECURITY_APP_Data.HkTlm.SelfTestFailMask = SECURITY_APP_CryptoSelfTestFailures();
+    SECURITY_APP_InitPerf();
+    SECURITY_APP_InitReplay();
+    SECURITY_APP_InitAcct();
+    SECURITY_APP_InitLoad();
 
     /*
-    ** Create Software Bus message pipe
+    ** Create the Software Bus pipes: control traffic is always read ahead of
+    ** bulk crypto traffic
     */
-    status = CFE_SB_CreatePipe(&SECURITY_APP_Data.CmdPipe, SECURITY_APP_Data.PipeDepth, SECURITY_APP_Data.PipeName);
+    status = CFE_SB_CreatePipe(&SECURITY_APP_Data.ControlPipe, SECURITY_APP_Data.PipeDepth[SECURITY_APP_PIPE_CONTROL],
+                               SECURITY_APP_Data.ControlPipeName);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_PIPE_ERR_EID, CFE_EVS_ERROR,
+                         "Error creating control pipe, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    status = CFE_SB_CreatePipe(&SECURITY_APP_Data.DataPipe, SECURITY_APP_Data.PipeDepth[SECURITY_APP_PIPE_DATA],
+                               SECURITY_APP_Data.DataPipeName);
     if (status != CFE_SUCCESS)
     {
         CFE_EVS_SendEvent(SECURITY_APP_PIPE_ERR_EID, CFE_EVS_ERROR,
-                         "Error creating command pipe, RC = 0x%08X", (unsigned int)status);
+                         "Error creating data pipe, RC = 0x%08X", (unsigned int)status);
         return status;
     }
     
     /*
     ** Subscribe to Housekeeping request commands
     */
-    status = CFE_SB_Subscribe(SECURITY_APP_SEND_HK_MID, SECURITY_APP_Data.CmdPipe);
+    status = CFE_SB_Subscribe(SECURITY_APP_SEND_HK_MID, SECURITY_APP_Data.ControlPipe);
     if (status != CFE_SUCCESS)
     {
         CFE_EVS_SendEvent(SECURITY_APP_PIPE_ERR_EID, CFE_EVS_ERROR,
@@ -137,10 +328,21 @@ int32 SECURITY_APP_Init(void)
         return status;
     }
 
+    /*
+    ** Subscribe to performance telemetry requests
+    */
+    status = CFE_SB_Subscribe(SECURITY_APP_SEND_PERF_MID, SECURITY_APP_Data.ControlPipe);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_PIPE_ERR_EID, CFE_EVS_ERROR,
+                         "Error subscribing to performance request, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
     /*
     ** Subscribe to Security App command packets
     */
-    status = CFE_SB_Subscribe(SECURITY_APP_CMD_MID, SECURITY_APP_Data.CmdPipe);
+    status = CFE_SB_Subscribe(SECURITY_APP_CMD_MID, SECURITY_APP_Data.ControlPipe);
     if (status != CFE_SUCCESS)
     {
         CFE_EVS_SendEvent(SECURITY_APP_PIPE_ERR_EID, CFE_EVS_ERROR,
@@ -148,6 +350,95 @@ int32 SECURITY_APP_Init(void)
         return status;
     }
 
+#if (SECURITY_APP_SCHEDULED_MODE == 1)
+    /*
+    ** Subscribe to the scheduler wakeup that paces bulk processing
+    */
+    status = CFE_SB_Subscribe(SECURITY_APP_WAKEUP_MID, SECURITY_APP_Data.ControlPipe);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_PIPE_ERR_EID, CFE_EVS_ERROR,
+                         "Error subscribing to scheduler wakeup, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+#endif
+
+    /*
+    ** Subscribe to bulk crypto command packets
+    */
+    status = CFE_SB_Subscribe(SECURITY_APP_DATA_CMD_MID, SECURITY_APP_Data.DataPipe);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_PIPE_ERR_EID, CFE_EVS_ERROR,
+                         "Error subscribing to data command packets, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    /*
+    ** Start the IV refill task
+    */
+    status = SECURITY_APP_InitNonceTask();
+    if (status != CFE_SUCCESS)
+    {
+        return status;
+    }
+
+    /*
+    ** Start the file task
+    */
+    status = SECURITY_APP_InitFileTask();
+    if (status != CFE_SUCCESS)
+    {
+        return status;
+    }
+
+    /*
+    ** Load the key table and put its keys in service
+    */
+    status = SECURITY_APP_InitKeyTbl();
+    if (status != CFE_SUCCESS)
+    {
+        return status;
+    }
+
+    /*
+    ** Load the inline encryption table and subscribe to its streams
+    */
+    status = SECURITY_APP_InitInlineTbl();
+    if (status != CFE_SUCCESS)
+    {
+        return status;
+    }
+
+#if (SECURITY_APP_NUM_WORKERS > 0)
+    /*
+    ** Start the crypto worker pool
+    */
+    status = SECURITY_APP_InitWorkers();
+    if (status != CFE_SUCCESS)
+    {
+        return status;
+    }
+#endif
+
+    /*
+    ** Report which provider serves each cipher suite
+    */
+    CFE_EVS_SendEvent(SECURITY_APP_PROVIDER_INF_EID, CFE_EVS_INFORMATION,
+                     "Crypto providers: CBC %s, CTR %s, GCM %s, ChaCha20-Poly1305 %s, GMAC %s, Poly1305 %s",
+                     SECURITY_APP_CryptoProviderName(SECURITY_APP_SUITE_AES256_CBC),
+                     SECURITY_APP_CryptoProviderName(SECURITY_APP_SUITE_AES256_CTR),
+                     SECURITY_APP_CryptoProviderName(SECURITY_APP_SUITE_AES256_GCM),
+                     SECURITY_APP_CryptoProviderName(SECURITY_APP_SUITE_CHACHA20_POLY1305),
+                     SECURITY_APP_CryptoProviderName(SECURITY_APP_SUITE_AES256_GMAC),
+                     SECURITY_APP_CryptoProviderName(SECURITY_APP_SUITE_POLY1305));
+    if (SECURITY_APP_Data.HkTlm.SelfTestFailMask != 0)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_PROVIDER_ERR_EID, CFE_EVS_ERROR,
+                         "Crypto provider self-test failed for suite mask 0x%02X",
+                         (unsigned int)SECURITY_APP_Data.HkTlm.SelfTestFailMask);
+    }
+
     /*
     ** Application startup event message
     */
@@ -164,6 +455,29 @@ int32 SECURITY_APP_Init(void)
     return CFE_SUCCESS;
 }
 
+/* Command codes that carry crypto work; only accepted on SECURITY_APP_DATA_CMD_MID */
+static bool SECURITY_APP_IsBulkCmd(uint16 CommandCode)
+{
+    switch (CommandCode)
+    {
+        case SECURITY_APP_ENCRYPT_CC:
+        case SECURITY_APP_DECRYPT_CC:
+        case SECURITY_APP_SIGN_CC:
+        case SECURITY_APP_VERIFY_CC:
+        case SECURITY_APP_ENCRYPT_BATCH_CC:
+        case SECURITY_APP_DECRYPT_BATCH_CC:
+        case SECURITY_APP_STREAM_BEGIN_CC:
+        case SECURITY_APP_STREAM_APPEND_CC:
+        case SECURITY_APP_STREAM_END_CC:
+        case SECURITY_APP_FILE_ENCRYPT_CC:
+        case SECURITY_APP_FILE_DECRYPT_CC:
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
 /* Process a command packet */
 void SECURITY_APP_ProcessCommandPacket(CFE_SB_MsgPtr_t Msg)
 {
@@ -181,12 +495,31 @@ void SECURITY_APP_ProcessCommandPacket(CFE_SB_MsgPtr_t Msg)
             break;
 
         /*
-        ** Security App commands
+        ** Performance telemetry request
+        */
+        case SECURITY_APP_SEND_PERF_MID:
+            SECURITY_APP_ReportPerf();
+            break;
+
+        /*
+        ** Security App commands: control commands on either MID, crypto
+        ** commands only on the data MID
         */
         case SECURITY_APP_CMD_MID:
+        case SECURITY_APP_DATA_CMD_MID:
         {
             uint16 CommandCode = CFE_SB_GetCmdCode(Msg);
 
+            /* Crypto work on the control pipe would hold up housekeeping behind it */
+            if (MsgId == SECURITY_APP_CMD_MID && SECURITY_APP_IsBulkCmd(CommandCode))
+            {
+                SECURITY_APP_Data.ErrCounter++;
+                CFE_EVS_SendEvent(SECURITY_APP_COMMAND_ERR_EID, CFE_EVS_ERROR,
+                                 "Command code %d refused on the control MID, send it on MID 0x%04X",
+                                 CommandCode, SECURITY_APP_DATA_CMD_MID);
+                break;
+            }
+
             switch (CommandCode)
             {
                 /*
@@ -213,7 +546,8 @@ void SECURITY_APP_ProcessCommandPacket(CFE_SB_MsgPtr_t Msg)
                 ** Encrypt message command
                 */
                 case SECURITY_APP_ENCRYPT_CC:
-                    if (SECURITY_APP_VerifyCmdLength(Msg, sizeof(SECURITY_APP_EncryptCmd_t)))
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_EncryptCmd_t, Data),
+                                                          sizeof(SECURITY_APP_EncryptCmd_t)))
                     {
                         SECURITY_APP_EncryptMsg((SECURITY_APP_EncryptCmd_t *)Msg);
                     }
@@ -223,12 +557,107 @@ void SECURITY_APP_ProcessCommandPacket(CFE_SB_MsgPtr_t Msg)
                 ** Decrypt message command
                 */
                 case SECURITY_APP_DECRYPT_CC:
-                    if (SECURITY_APP_VerifyCmdLength(Msg, sizeof(SECURITY_APP_DecryptCmd_t)))
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_DecryptCmd_t, Record),
+                                                          sizeof(SECURITY_APP_DecryptCmd_t)))
                     {
                         SECURITY_APP_DecryptMsg((SECURITY_APP_DecryptCmd_t *)Msg);
                     }
                     break;
 
+                /*
+                ** Authenticate-only sign and verify commands
+                */
+                case SECURITY_APP_SIGN_CC:
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_SignCmd_t, Data),
+                                                          sizeof(SECURITY_APP_SignCmd_t)))
+                    {
+                        SECURITY_APP_SignMsg((SECURITY_APP_SignCmd_t *)Msg);
+                    }
+                    break;
+
+                case SECURITY_APP_VERIFY_CC:
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_VerifyCmd_t, Record),
+                                                          sizeof(SECURITY_APP_VerifyCmd_t)))
+                    {
+                        SECURITY_APP_VerifyMsg((SECURITY_APP_VerifyCmd_t *)Msg);
+                    }
+                    break;
+
+                /*
+                ** Batch encrypt command
+                */
+                case SECURITY_APP_ENCRYPT_BATCH_CC:
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_EncryptBatchCmd_t, Records),
+                                                          sizeof(SECURITY_APP_EncryptBatchCmd_t)))
+                    {
+                        SECURITY_APP_EncryptBatch((SECURITY_APP_EncryptBatchCmd_t *)Msg);
+                    }
+                    break;
+
+                /*
+                ** Batch decrypt command
+                */
+                case SECURITY_APP_DECRYPT_BATCH_CC:
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_DecryptBatchCmd_t, Records),
+                                                          sizeof(SECURITY_APP_DecryptBatchCmd_t)))
+                    {
+                        SECURITY_APP_DecryptBatch((SECURITY_APP_DecryptBatchCmd_t *)Msg);
+                    }
+                    break;
+
+                /*
+                ** Stream session commands
+                */
+                case SECURITY_APP_STREAM_BEGIN_CC:
+                    if (SECURITY_APP_VerifyCmdLength(Msg, sizeof(SECURITY_APP_StreamBeginCmd_t)))
+                    {
+                        SECURITY_APP_StreamBeginCmd((SECURITY_APP_StreamBeginCmd_t *)Msg);
+                    }
+                    break;
+
+                case SECURITY_APP_STREAM_APPEND_CC:
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_StreamAppendCmd_t, Data),
+                                                          sizeof(SECURITY_APP_StreamAppendCmd_t)))
+                    {
+                        SECURITY_APP_StreamAppendCmd((SECURITY_APP_StreamAppendCmd_t *)Msg);
+                    }
+                    break;
+
+                case SECURITY_APP_STREAM_END_CC:
+                    if (SECURITY_APP_VerifyCmdLengthRange(Msg, offsetof(SECURITY_APP_StreamEndCmd_t, Data),
+                                                          sizeof(SECURITY_APP_StreamEndCmd_t)))
+                    {
+                        SECURITY_APP_StreamEndCmd((SECURITY_APP_StreamEndCmd_t *)Msg);
+                    }
+                    break;
+
+                /*
+                ** File commands
+                */
+                case SECURITY_APP_FILE_ENCRYPT_CC:
+                    if (SECURITY_APP_VerifyCmdLength(Msg, sizeof(SECURITY_APP_FileEncryptCmd_t)))
+                    {
+                        SECURITY_APP_FileEncryptCmd((SECURITY_APP_FileEncryptCmd_t *)Msg);
+                    }
+                    break;
+
+                case SECURITY_APP_FILE_DECRYPT_CC:
+                    if (SECURITY_APP_VerifyCmdLength(Msg, sizeof(SECURITY_APP_FileDecryptCmd_t)))
+                    {
+                        SECURITY_APP_FileDecryptCmd((SECURITY_APP_FileDecryptCmd_t *)Msg);
+                    }
+                    break;
+
+                /*
+                ** Per-stream accounting dump command
+                */
+                case SECURITY_APP_ACCT_DUMP_CC:
+                    if (SECURITY_APP_VerifyCmdLength(Msg, sizeof(SECURITY_APP_AcctDumpCmd_t)))
+                    {
+                        SECURITY_APP_AcctDumpCmd((SECURITY_APP_AcctDumpCmd_t *)Msg);
+                    }
+                    break;
+
                 /*
                 ** Invalid command code
                 */
@@ -242,57 +671,183 @@ void SECURITY_APP_ProcessCommandPacket(CFE_SB_MsgPtr_t Msg)
         }
 
         /*
-        ** Invalid message ID
+        ** Streams intercepted through the inline table, otherwise an invalid message ID
         */
         default:
-            SECURITY_APP_Data.ErrCounter++;
-            CFE_EVS_SendEvent(SECURITY_APP_INVALID_MSGID_ERR_EID, CFE_EVS_ERROR,
-                             "Invalid message ID: 0x%04X", MsgId);
+        {
+            const SECURITY_APP_InlineEntry_t *Entry = SECURITY_APP_FindInlineEntry(MsgId);
+
+            if (Entry != NULL)
+            {
+                SECURITY_APP_InlineEncrypt(Msg, Entry);
+            }
+            else
+            {
+                SECURITY_APP_Data.ErrCounter++;
+                CFE_EVS_SendEvent(SECURITY_APP_INVALID_MSGID_ERR_EID, CFE_EVS_ERROR,
+                                 "Invalid message ID: 0x%04X", MsgId);
+            }
             break;
+        }
     }
 }
 
 /* Report housekeeping telemetry */
 void SECURITY_APP_ReportHousekeeping(void)
 {
+    /*
+    ** Apply any pending key or inline table update
+    */
+    SECURITY_APP_ManageKeyTbl();
+    SECURITY_APP_ManageInlineTbl();
+    
     /*
     ** Update housekeeping values
     */
     SECURITY_APP_Data.HkTlm.CommandCounter = SECURITY_APP_Data.CmdCounter;
     SECURITY_APP_Data.HkTlm.CommandErrorCounter = SECURITY_APP_Data.ErrCounter;
+    SECURITY_APP_GetNonceStats(&SECURITY_APP_Data.HkTlm.NonceRefillCount,
+                               &SECURITY_APP_Data.HkTlm.NonceUnderflowCount);
     
     /*
     ** Send housekeeping telemetry packet
     */
     CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)&SECURITY_APP_Data.HkTlm);
     CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&SECURITY_APP_Data.HkTlm);
-}
-
-/* Verify command packet length */
-bool SECURITY_APP_VerifyCmdLength(CFE_SB_MsgPtr_t Msg, uint16 ExpectedLength)
-{
-    bool result = TRUE;
-    uint16 ActualLength = CFE_SB_GetTotalMsgLength(Msg);
-
+    SECURITY_APP_ReportLoad();
+    
     /*
-    ** Verify the command packet length
+    ** Statistics go out at a slower cadence than housekeeping
     */
-    if (ExpectedLength != ActualLength)
+    if (++SECURITY_APP_Data.StatsCycles >= SECURITY_APP_STATS_REPORT_CYCLES)
     {
-        SECURITY_APP_Data.ErrCounter++;
-        CFE_EVS_SendEvent(SECURITY_APP_LEN_ERR_EID, CFE_EVS_ERROR,
-                         "Invalid msg length: expected = %d, actual = %d",
-                         ExpectedLength, ActualLength);
-        result = FALSE;
+        SECURITY_APP_Data.StatsCycles = 0;
+        SECURITY_APP_ReportStats();
     }
-
-    return result;
 }
 
-/* NOOP command handler */
-int32 SECURITY_APP_Noop(const SECURITY_APP_NoopCmd_t *Msg)
+/* Send the statistics accumulated since the last report and start a new period */
+void SECURITY_APP_ReportStats(void)
 {
-    SECURITY_APP_Data.CmdCounter++;
+    SECURITY_APP_StatsTlm_t *Stats = &SECURITY_APP_Data.Stats;
+    SECURITY_APP_StatsTlm_t *Tlm = &SECURITY_APP_Data.StatsTlm;
+    uint32 Errors[2] = { 0, 0 };
+    uint8 Op;
+    uint8 i;
+    
+    for (Op = SECURITY_APP_OP_ENCRYPT; Op <= SECURITY_APP_OP_DECRYPT; Op++)
+    {
+        Tlm->Operations[Op] = SECURITY_APP_COUNTER_TAKE(Stats->Operations[Op]);
+        Tlm->Bytes[Op] = SECURITY_APP_COUNTER_TAKE(Stats->Bytes[Op]);
+        for (i = 0; i < SECURITY_APP_STAT_ERR_COUNT; i++)
+        {
+            Tlm->Errors[Op][i] = SECURITY_APP_COUNTER_TAKE(Stats->Errors[Op][i]);
+            Errors[Op] += Tlm->Errors[Op][i];
+        }
+    }
+    
+    CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)Tlm);
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)Tlm);
+    
+    /* One summary line per period, and only when something happened */
+    if (Tlm->Operations[SECURITY_APP_OP_ENCRYPT] != 0 || Tlm->Operations[SECURITY_APP_OP_DECRYPT] != 0 ||
+        Errors[SECURITY_APP_OP_ENCRYPT] != 0 || Errors[SECURITY_APP_OP_DECRYPT] != 0)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_STATS_INF_EID, CFE_EVS_INFORMATION,
+                         "SECURITY_APP: Encrypted %u (%u bytes, %u errors), decrypted %u (%u bytes, %u errors)",
+                         (unsigned int)Tlm->Operations[SECURITY_APP_OP_ENCRYPT],
+                         (unsigned int)Tlm->Bytes[SECURITY_APP_OP_ENCRYPT],
+                         (unsigned int)Errors[SECURITY_APP_OP_ENCRYPT],
+                         (unsigned int)Tlm->Operations[SECURITY_APP_OP_DECRYPT],
+                         (unsigned int)Tlm->Bytes[SECURITY_APP_OP_DECRYPT],
+                         (unsigned int)Errors[SECURITY_APP_OP_DECRYPT]);
+    }
+}
+
+/* Account a successful operation in HK and in the current statistics period */
+void SECURITY_APP_CountSuccess(uint8 Operation, uint32 Bytes)
+{
+    if (Operation == SECURITY_APP_OP_ENCRYPT)
+    {
+        SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.HkTlm.EncryptionCount);
+    }
+    else
+    {
+        SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.HkTlm.DecryptionCount);
+    }
+    
+    SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.Stats.Operations[Operation]);
+    SECURITY_APP_COUNTER_ADD(SECURITY_APP_Data.Stats.Bytes[Operation], Bytes);
+}
+
+/* Account a failed operation in HK and in the current statistics period */
+void SECURITY_APP_CountError(uint8 Operation, uint8 Category)
+{
+    if (Operation == SECURITY_APP_OP_ENCRYPT)
+    {
+        SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.HkTlm.EncryptionErrorCount);
+    }
+    else
+    {
+        SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.HkTlm.DecryptionErrorCount);
+    }
+    
+    SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.Stats.Errors[Operation][Category]);
+}
+
+/* Account a record dropped by the anti-replay window */
+void SECURITY_APP_CountReplay(uint8 KeyId, uint32 Seq)
+{
+    SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_REPLAY);
+    SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.HkTlm.ReplayRejectCount);
+    CFE_EVS_SendEvent(SECURITY_APP_REPLAY_ERR_EID, CFE_EVS_ERROR,
+                     "SECURITY_APP: Replayed or stale record for key ID %d, sequence %u",
+                     KeyId, (unsigned int)Seq);
+}
+
+/* Verify a variable-length command packet falls within [MinLength, MaxLength] */
+bool SECURITY_APP_VerifyCmdLengthRange(CFE_SB_MsgPtr_t Msg, uint16 MinLength, uint16 MaxLength)
+{
+    bool result = TRUE;
+    uint16 ActualLength = CFE_SB_GetTotalMsgLength(Msg);
+
+    if (ActualLength < MinLength || ActualLength > MaxLength)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_LEN_ERR_EID, CFE_EVS_ERROR,
+                         "Invalid msg length: expected %d to %d, actual = %d",
+                         MinLength, MaxLength, ActualLength);
+        result = FALSE;
+    }
+
+    return result;
+}
+
+/* Verify command packet length */
+bool SECURITY_APP_VerifyCmdLength(CFE_SB_MsgPtr_t Msg, uint16 ExpectedLength)
+{
+    bool result = TRUE;
+    uint16 ActualLength = CFE_SB_GetTotalMsgLength(Msg);
+
+    /*
+    ** Verify the command packet length
+    */
+    if (ExpectedLength != ActualLength)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_LEN_ERR_EID, CFE_EVS_ERROR,
+                         "Invalid msg length: expected = %d, actual = %d",
+                         ExpectedLength, ActualLength);
+        result = FALSE;
+    }
+
+    return result;
+}
+
+/* NOOP command handler */
+int32 SECURITY_APP_Noop(const SECURITY_APP_NoopCmd_t *Msg)
+{
+    SECURITY_APP_Data.CmdCounter++;
 
     CFE_EVS_SendEvent(SECURITY_APP_COMMANDNOP_INF_EID, CFE_EVS_INFORMATION,
                      "SECURITY_APP: NOOP command received");
@@ -305,121 +860,808 @@ int32 SECURITY_APP_ResetCounters(const SECURITY_APP_ResetCountersCmd_t *Msg)
     SECURITY_APP_Data.CmdCounter = 0;
     SECURITY_APP_Data.ErrCounter = 0;
 
-    SECURITY_APP_Data.HkTlm.EncryptionCount = 0;
-    SECURITY_APP_Data.HkTlm.DecryptionCount = 0;
-    SECURITY_APP_Data.HkTlm.EncryptionErrorCount = 0;
-    SECURITY_APP_Data.HkTlm.DecryptionErrorCount = 0;
+    SECURITY_APP_COUNTER_CLEAR(SECURITY_APP_Data.HkTlm.EncryptionCount);
+    SECURITY_APP_COUNTER_CLEAR(SECURITY_APP_Data.HkTlm.DecryptionCount);
+    SECURITY_APP_COUNTER_CLEAR(SECURITY_APP_Data.HkTlm.EncryptionErrorCount);
+    SECURITY_APP_COUNTER_CLEAR(SECURITY_APP_Data.HkTlm.DecryptionErrorCount);
+    SECURITY_APP_COUNTER_CLEAR(SECURITY_APP_Data.HkTlm.VerifyFailCount);
+    SECURITY_APP_COUNTER_CLEAR(SECURITY_APP_Data.HkTlm.ReplayRejectCount);
+    SECURITY_APP_ResetNonceStats();
+    SECURITY_APP_ResetPerf();
+    SECURITY_APP_ResetAcct();
+    SECURITY_APP_ResetLoad();
 
     CFE_EVS_SendEvent(SECURITY_APP_COMMANDRST_INF_EID, CFE_EVS_INFORMATION,
                      "SECURITY_APP: RESET counters command received");
     return CFE_SUCCESS;
 }
 
-/* Encrypt message command handler */
-int32 SECURITY_APP_EncryptMsg(const SECURITY_APP_EncryptCmd_t *Msg)
+/* Get an initialized output packet, either from the SB pool or local storage */
+CFE_SB_MsgPtr_t SECURITY_APP_AcquireOutput(SECURITY_APP_OutputBuf_t *Buf, CFE_SB_MsgId_t MsgId, uint16 Size)
 {
-    int32_t status;
-    SECURITY_APP_EncryptedTlm_t EncryptedTlm;
-    size_t encrypted_len;
+#if (SECURITY_APP_ZERO_COPY_OUTPUT == 1)
+    Buf->MsgPtr = CFE_SB_ZeroCopyGetPtr(Size, &Buf->BufferHandle);
+    if (Buf->MsgPtr == NULL)
+    {
+        return NULL;
+    }
+#else
+    Buf->MsgPtr = (CFE_SB_MsgPtr_t)&Buf->Local;
+#endif
+
+    CFE_SB_InitMsg(Buf->MsgPtr, MsgId, Size, TRUE);
+    Buf->ReplaySeq = 0;
+
+    return Buf->MsgPtr;
+}
+
+/* Publish an output packet acquired with SECURITY_APP_AcquireOutput */
+int32 SECURITY_APP_SendOutput(SECURITY_APP_OutputBuf_t *Buf)
+{
+    int32 status;
+
+    CFE_SB_TimeStampMsg(Buf->MsgPtr);
+
+#if (SECURITY_APP_ZERO_COPY_OUTPUT == 1)
+    status = CFE_SB_ZeroCopySend(Buf->MsgPtr, Buf->BufferHandle);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_SB_ZeroCopyReleasePtr(Buf->MsgPtr, Buf->BufferHandle);
+    }
+#else
+    status = CFE_SB_SendMsg(Buf->MsgPtr);
+#endif
+
+    Buf->MsgPtr = NULL;
+
+    return status;
+}
+
+/* Return an unsent output packet */
+void SECURITY_APP_ReleaseOutput(SECURITY_APP_OutputBuf_t *Buf)
+{
+#if (SECURITY_APP_ZERO_COPY_OUTPUT == 1)
+    if (Buf->MsgPtr != NULL)
+    {
+        CFE_SB_ZeroCopyReleasePtr(Buf->MsgPtr, Buf->BufferHandle);
+    }
+#endif
+
+    Buf->MsgPtr = NULL;
+}
+
+/*
+** Compress Data into the channel's staging buffer if that makes the
+** encrypted payload smaller. Returns the bytes to encrypt and updates Length
+** and the record flags to match.
+*/
+static const uint8 *SECURITY_APP_CompressInput(uint8 Channel, uint8 Suite, const uint8 *Data, uint16 *Length,
+                                               uint8 *Flags)
+{
+    uint64 Start = SECURITY_APP_PerfNow();
+    size_t CompressedLength;
     
-    SECURITY_APP_Data.CmdCounter++;
+    CompressedLength = SECURITY_APP_Compress(Channel, Data, *Length, SECURITY_APP_CodecBuf[Channel], *Length);
+    
+    /* CBC rounds up to a whole block, so compare what would actually be sent */
+    if (CompressedLength == 0 ||
+        SECURITY_APP_CiphertextLength(Suite, CompressedLength) >= SECURITY_APP_CiphertextLength(Suite, *Length))
+    {
+        SECURITY_APP_PerfRecordCompress(Channel, *Length, *Length, Start);
+        return Data;
+    }
+    
+    SECURITY_APP_PerfRecordCompress(Channel, *Length, CompressedLength, Start);
+    
+    *Length = CompressedLength;
+    *Flags |= SECURITY_APP_WIRE_FLAG_COMPRESSED;
+    
+    return SECURITY_APP_CodecBuf[Channel];
+}
+
+/*
+** First half of an encryption: check the request, get the output packet and
+** write the record header into it. Job is set up to encrypt the data
+** straight into the packet's aligned payload, with the IV going to Hdr.
+*/
+static int32 SECURITY_APP_EncryptPrepare(uint8 Channel, const uint8 *Data, uint16 DataLength,
+                                         CFE_SB_MsgId_t TargetMsgID, uint8 Suite, uint8 KeyId, uint8 Options,
+                                         SECURITY_APP_OutputBuf_t *OutputBuf, SECURITY_APP_WireHdr_t *Hdr,
+                                         security_app_crypto_job_t *Job)
+{
+    SECURITY_APP_EncryptedTlm_t *EncryptedTlm;
+    const uint8 *Input = Data;
+    uint16 InputLength = DataLength;
     
     /* Validate input */
-    if (Msg->DataLength == 0 || Msg->DataLength > SECURITY_APP_MAX_DATA_LENGTH)
+    if (DataLength == 0 || DataLength > SECURITY_APP_MAX_DATA_LENGTH)
     {
-        SECURITY_APP_Data.HkTlm.EncryptionErrorCount++;
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_LENGTH);
         CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
-                         "SECURITY_APP: Invalid data length for encryption: %d", Msg->DataLength);
-        return CFE_SUCCESS;
+                         "SECURITY_APP: Invalid data length for encryption: %d", DataLength);
+        return SECURITY_APP_ERROR;
+    }
+    
+    if (Suite >= SECURITY_APP_SUITE_COUNT)
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_SUITE);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Invalid cipher suite for encryption: %d", Suite);
+        return SECURITY_APP_ERROR;
+    }
+    
+    if (!SECURITY_APP_KeyLoaded(KeyId))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_KEY);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: No key loaded for encryption key ID %d", KeyId);
+        return SECURITY_APP_ERROR;
+    }
+    
+    Hdr->Version = SECURITY_APP_WIRE_VERSION;
+    Hdr->Flags = 0;
+    Hdr->Suite = Suite;
+    Hdr->KeyId = KeyId;
+    Hdr->DataLength = DataLength;
+    
+    /* Signed data has to stay readable, so it is never compressed */
+    if ((Options & SECURITY_APP_OPT_COMPRESS) != 0 && !SECURITY_APP_SuiteAuthOnly(Suite))
+    {
+        Input = SECURITY_APP_CompressInput(Channel, Suite, Data, &InputLength, &Hdr->Flags);
     }
     
     /* Initialize telemetry packet */
-    CFE_SB_InitMsg(&EncryptedTlm, Msg->TargetMsgID, sizeof(SECURITY_APP_EncryptedTlm_t), TRUE);
+    EncryptedTlm = (SECURITY_APP_EncryptedTlm_t *)SECURITY_APP_AcquireOutput(OutputBuf, TargetMsgID,
+                        offsetof(SECURITY_APP_EncryptedTlm_t, Record) + SECURITY_APP_WIRE_HDR_SIZE +
+                        SECURITY_APP_CiphertextLength(Suite, InputLength));
+    if (EncryptedTlm == NULL)
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_BUFFER);
+        CFE_EVS_SendEvent(SECURITY_APP_ENCRYPT_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Unable to get SB buffer for encrypted output");
+        return SECURITY_APP_ERROR;
+    }
+    
+    Hdr->Sequence = SECURITY_APP_ReplayNextSeq(KeyId);
+    if (Hdr->Sequence == 0)
+    {
+        SECURITY_APP_ReleaseOutput(OutputBuf);
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_KEY);
+        CFE_EVS_SendEvent(SECURITY_APP_ENCRYPT_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Sequence numbers used up for key ID %d, load a new key", KeyId);
+        return SECURITY_APP_ERROR;
+    }
     
-    /* Store original data length */
-    EncryptedTlm.OriginalDataLength = Msg->DataLength;
+    /* The header goes in first so its leading bytes can be authenticated */
+    SECURITY_APP_WirePack(EncryptedTlm->Record, Hdr);
     
-    /* Encrypt the data */
-    status = SECURITY_APP_Encrypt(Msg->Data, Msg->DataLength,
-                                 EncryptedTlm.IV, EncryptedTlm.EncryptedData, &encrypted_len);
+    Job->aad = EncryptedTlm->Record;
+    Job->aad_len = SECURITY_APP_WIRE_AAD_SIZE;
+    Job->plaintext = Input;
+    Job->plaintext_len = InputLength;
+    Job->iv = Hdr->Nonce;
+    Job->ciphertext = SECURITY_APP_WIRE_PAYLOAD(EncryptedTlm->Record);
+    Job->ciphertext_len = 0;
+    Job->status = 0;
     
-    if (status != 0)
+    return SECURITY_APP_SUCCESS;
+}
+
+/*
+** Second half: report a failed Job, or complete the packet around its
+** ciphertext. CryptoTicks is the cipher time spent on Job.
+*/
+static int32 SECURITY_APP_EncryptFinish(uint8 Channel, SECURITY_APP_OutputBuf_t *OutputBuf,
+                                        const SECURITY_APP_WireHdr_t *Hdr, const security_app_crypto_job_t *Job,
+                                        uint64 CryptoTicks)
+{
+    if (Job->status != 0)
     {
-        SECURITY_APP_Data.HkTlm.EncryptionErrorCount++;
+        SECURITY_APP_ReleaseOutput(OutputBuf);
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT,
+                                 (Job->status == -8) ? SECURITY_APP_STAT_ERR_KEY : SECURITY_APP_STAT_ERR_CIPHER);
         CFE_EVS_SendEvent(SECURITY_APP_ENCRYPT_ERR_EID, CFE_EVS_ERROR,
-                         "SECURITY_APP: Encryption failed with error: %d", status);
-        return CFE_SUCCESS;
+                         "SECURITY_APP: Encryption failed with error: %d", Job->status);
+        return SECURITY_APP_ERROR;
     }
     
-    /* Update telemetry */
-    EncryptedTlm.EncryptedDataLength = encrypted_len;
+    SECURITY_APP_PerfRecordCryptoTicks(Channel, SECURITY_APP_OP_ENCRYPT, Job->plaintext_len, CryptoTicks);
     
-    /* Send encrypted data */
-    CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)&EncryptedTlm);
-    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&EncryptedTlm);
+    /* Fill in the nonce; the packet ends with the last ciphertext byte */
+    SECURITY_APP_WirePack(((SECURITY_APP_EncryptedTlm_t *)OutputBuf->MsgPtr)->Record, Hdr);
+    CFE_SB_SetTotalMsgLength(OutputBuf->MsgPtr, offsetof(SECURITY_APP_EncryptedTlm_t, Record) +
+                             SECURITY_APP_WIRE_HDR_SIZE + Job->ciphertext_len);
     
-    /* Update housekeeping */
-    SECURITY_APP_Data.HkTlm.EncryptionCount++;
+    return SECURITY_APP_SUCCESS;
+}
+
+/* Encrypt one payload into an output packet for TargetMsgID; the caller publishes it */
+int32 SECURITY_APP_EncryptPayload(uint8 Channel, const uint8 *Data, uint16 DataLength, CFE_SB_MsgId_t TargetMsgID,
+                                  uint8 Suite, uint8 KeyId, uint8 Options, SECURITY_APP_OutputBuf_t *OutputBuf)
+{
+    SECURITY_APP_WireHdr_t Hdr;
+    security_app_crypto_job_t Job;
+    uint64 Start;
     
-    /* Log success */
-    CFE_EVS_SendEvent(SECURITY_APP_ENCRYPT_INF_EID, CFE_EVS_INFORMATION,
-                     "SECURITY_APP: Encrypted %d bytes of data", Msg->DataLength);
+    if (SECURITY_APP_EncryptPrepare(Channel, Data, DataLength, TargetMsgID, Suite, KeyId, Options, OutputBuf,
+                                    &Hdr, &Job) != SECURITY_APP_SUCCESS)
+    {
+        return SECURITY_APP_ERROR;
+    }
     
-    return CFE_SUCCESS;
+    Start = SECURITY_APP_PerfNow();
+    Job.status = SECURITY_APP_Encrypt(Channel, KeyId, Suite, Job.aad, Job.aad_len, Job.plaintext,
+                                      Job.plaintext_len, Job.iv, Job.ciphertext, &Job.ciphertext_len);
+    
+    return SECURITY_APP_EncryptFinish(Channel, OutputBuf, &Hdr, &Job, SECURITY_APP_PerfNow() - Start);
 }
 
-/* Decrypt message command handler */
-int32 SECURITY_APP_DecryptMsg(const SECURITY_APP_DecryptCmd_t *Msg)
+/*
+** Decrypt one wire format record into an output packet for TargetMsgID; the
+** caller publishes it. Suite and key ID come from the record header.
+*/
+int32 SECURITY_APP_DecryptPayload(uint8 Channel, const uint8 *Record, uint16 RecordLength, CFE_SB_MsgId_t TargetMsgID,
+                                  SECURITY_APP_OutputBuf_t *OutputBuf, uint16 *DecryptedLength)
 {
     int32_t status;
-    SECURITY_APP_DecryptedTlm_t DecryptedTlm;
+    SECURITY_APP_DecryptedTlm_t *DecryptedTlm;
+    SECURITY_APP_WireHdr_t Hdr;
     size_t decrypted_len;
-    
-    SECURITY_APP_Data.CmdCounter++;
+    uint16 PayloadLength;
+    uint16 OutputLength;
+    uint8 *Output;
+    bool Compressed;
+    uint64 Start;
     
     /* Validate input */
-    if (Msg->DataLength == 0 || Msg->DataLength > SECURITY_APP_MAX_DATA_LENGTH)
+    if (RecordLength <= SECURITY_APP_WIRE_HDR_SIZE || RecordLength > SECURITY_APP_MAX_RECORD_LENGTH)
     {
-        SECURITY_APP_Data.HkTlm.DecryptionErrorCount++;
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_LENGTH);
         CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
-                         "SECURITY_APP: Invalid data length for decryption: %d", Msg->DataLength);
-        return CFE_SUCCESS;
+                         "SECURITY_APP: Invalid data length for decryption: %d", RecordLength);
+        return SECURITY_APP_ERROR;
     }
     
-    /* Initialize telemetry packet */
-    CFE_SB_InitMsg(&DecryptedTlm, Msg->TargetMsgID, sizeof(SECURITY_APP_DecryptedTlm_t), TRUE);
+    if (SECURITY_APP_WireUnpack(&Hdr, Record) != SECURITY_APP_SUCCESS)
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_FORMAT);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Unsupported record version %d, flags 0x%X", Hdr.Version, Hdr.Flags);
+        return SECURITY_APP_ERROR;
+    }
     
-    /* Extract encrypted data and IV from command */
-    uint8_t *iv = (uint8_t *)(Msg->Data);
-    uint32_t original_len = *(uint32_t *)(iv + 16);
-    uint8_t *encrypted_data = iv + 16 + sizeof(uint32_t);
-    uint16_t encrypted_len = Msg->DataLength - 16 - sizeof(uint32_t);
+    if (Hdr.Suite >= SECURITY_APP_SUITE_COUNT)
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_SUITE);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Invalid cipher suite for decryption: %d", Hdr.Suite);
+        return SECURITY_APP_ERROR;
+    }
     
-    /* Decrypt the data */
-    status = SECURITY_APP_Decrypt(encrypted_data, encrypted_len,
-                                 iv, DecryptedTlm.Data, &decrypted_len, original_len);
+    if (!SECURITY_APP_KeyLoaded(Hdr.KeyId))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_KEY);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: No key loaded for decryption key ID %d", Hdr.KeyId);
+        return SECURITY_APP_ERROR;
+    }
+    
+    /*
+    ** Duplicates are dropped before any decryption work. Only a tag makes the
+    ** sequence number trustworthy, so CBC and CTR records are not checked.
+    */
+    if (SECURITY_APP_SuiteTagged(Hdr.Suite) &&
+        SECURITY_APP_ReplayCheck(Hdr.KeyId, Hdr.Sequence) != SECURITY_APP_SUCCESS)
+    {
+        SECURITY_APP_CountReplay(Hdr.KeyId, Hdr.Sequence);
+        return SECURITY_APP_ERROR;
+    }
+    
+    Compressed = (Hdr.Flags & SECURITY_APP_WIRE_FLAG_COMPRESSED) != 0;
+    if (Compressed && SECURITY_APP_SuiteAuthOnly(Hdr.Suite))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_FORMAT);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Signed record for decryption is marked compressed");
+        return SECURITY_APP_ERROR;
+    }
+    
+    /*
+    ** The payload must be exactly what encrypting DataLength bytes produces,
+    ** or no longer than that if it was compressed first
+    */
+    PayloadLength = RecordLength - SECURITY_APP_WIRE_HDR_SIZE;
+    if (Hdr.DataLength > SECURITY_APP_MAX_DATA_LENGTH ||
+        (!Compressed && PayloadLength != SECURITY_APP_CiphertextLength(Hdr.Suite, Hdr.DataLength)) ||
+        (Compressed && PayloadLength > SECURITY_APP_CiphertextLength(Hdr.Suite, Hdr.DataLength)))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_LENGTH);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Record length %d does not match data length %d for decryption",
+                         RecordLength, Hdr.DataLength);
+        return SECURITY_APP_ERROR;
+    }
+    
+    /* Initialize telemetry packet; raw CBC decrypts its padding into the packet too */
+    OutputLength = Compressed ? Hdr.DataLength : PayloadLength;
+    DecryptedTlm = (SECURITY_APP_DecryptedTlm_t *)SECURITY_APP_AcquireOutput(OutputBuf, TargetMsgID,
+                        offsetof(SECURITY_APP_DecryptedTlm_t, Data) + OutputLength);
+    if (DecryptedTlm == NULL)
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_BUFFER);
+        CFE_EVS_SendEvent(SECURITY_APP_DECRYPT_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Unable to get SB buffer for decrypted output");
+        return SECURITY_APP_ERROR;
+    }
+    
+    /* Decrypt straight into the output packet, or into staging if it still has to be expanded */
+    Output = Compressed ? SECURITY_APP_CodecBuf[Channel] : DecryptedTlm->Data;
+    Start = SECURITY_APP_PerfNow();
+    status = SECURITY_APP_Decrypt(Channel, Hdr.KeyId, Hdr.Suite, Record, SECURITY_APP_WIRE_AAD_SIZE,
+                                 SECURITY_APP_WIRE_PAYLOAD(Record), PayloadLength, Hdr.Nonce, Output,
+                                 &decrypted_len, Compressed ? PayloadLength : Hdr.DataLength);
+    
+    if (status == -7 && SECURITY_APP_SuiteAuthOnly(Hdr.Suite))
+    {
+        /* A signed record whose tag does not match is dropped */
+        SECURITY_APP_ReleaseOutput(OutputBuf);
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_AUTH);
+        SECURITY_APP_COUNTER_INC(SECURITY_APP_Data.HkTlm.VerifyFailCount);
+        CFE_EVS_SendEvent(SECURITY_APP_VERIFY_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Signed record for 0x%04X failed verification", TargetMsgID);
+        return SECURITY_APP_ERROR;
+    }
     
     if (status != 0)
     {
-        SECURITY_APP_Data.HkTlm.DecryptionErrorCount++;
+        SECURITY_APP_ReleaseOutput(OutputBuf);
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT,
+                                 (status == -7) ? SECURITY_APP_STAT_ERR_AUTH :
+                                 (status == -8) ? SECURITY_APP_STAT_ERR_KEY : SECURITY_APP_STAT_ERR_CIPHER);
         CFE_EVS_SendEvent(SECURITY_APP_DECRYPT_ERR_EID, CFE_EVS_ERROR,
                          "SECURITY_APP: Decryption failed with error: %d", status);
+        return SECURITY_APP_ERROR;
+    }
+    
+    SECURITY_APP_PerfRecordCrypto(Channel, SECURITY_APP_OP_DECRYPT, decrypted_len, Start);
+    
+    /* Expand to exactly the sender's length; any CBC padding is left behind */
+    if (Compressed)
+    {
+        Start = SECURITY_APP_PerfNow();
+        if (SECURITY_APP_Decompress(Output, decrypted_len, DecryptedTlm->Data, Hdr.DataLength) != 0)
+        {
+            SECURITY_APP_ReleaseOutput(OutputBuf);
+            SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_FORMAT);
+            CFE_EVS_SendEvent(SECURITY_APP_DECRYPT_ERR_EID, CFE_EVS_ERROR,
+                             "SECURITY_APP: Compressed payload for 0x%04X is malformed", TargetMsgID);
+            return SECURITY_APP_ERROR;
+        }
+        SECURITY_APP_PerfRecordDecompress(Channel, Start);
+        decrypted_len = Hdr.DataLength;
+    }
+    
+    /*
+    ** The sequence number is recorded as seen when the result is published.
+    ** An untagged record's number may be forged, so it never moves the window.
+    */
+    if (SECURITY_APP_SuiteTagged(Hdr.Suite))
+    {
+        OutputBuf->ReplayKey = Hdr.KeyId;
+        OutputBuf->ReplaySeq = Hdr.Sequence;
+    }
+    
+    /* Update telemetry; the packet ends with the last plaintext byte */
+    DecryptedTlm->DataLength = decrypted_len;
+    CFE_SB_SetTotalMsgLength(OutputBuf->MsgPtr, offsetof(SECURITY_APP_DecryptedTlm_t, Data) + decrypted_len);
+    
+    *DecryptedLength = decrypted_len;
+    
+    return SECURITY_APP_SUCCESS;
+}
+
+/* Publish a finished crypto result and account for it */
+void SECURITY_APP_PublishResult(uint8 Operation, SECURITY_APP_OutputBuf_t *OutputBuf, uint16 DataLength,
+                                bool Notify)
+{
+    /* A copy of the same record may have been published since it was checked */
+    if (OutputBuf->ReplaySeq != 0 &&
+        SECURITY_APP_ReplayCommit(OutputBuf->ReplayKey, OutputBuf->ReplaySeq) != SECURITY_APP_SUCCESS)
+    {
+        SECURITY_APP_ReleaseOutput(OutputBuf);
+        SECURITY_APP_CountReplay(OutputBuf->ReplayKey, OutputBuf->ReplaySeq);
+        return;
+    }
+    
+    /* Send the output packet */
+    SECURITY_APP_SendOutput(OutputBuf);
+    
+    /* Update housekeeping and statistics */
+    SECURITY_APP_CountSuccess(Operation, DataLength);
+    
+    /* Per-operation events are filtered by EVS unless ground enables them */
+    if (Notify)
+    {
+        if (Operation == SECURITY_APP_OP_ENCRYPT)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_ENCRYPT_INF_EID, CFE_EVS_INFORMATION,
+                             "SECURITY_APP: Encrypted %d bytes of data", DataLength);
+        }
+        else
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_DECRYPT_INF_EID, CFE_EVS_INFORMATION,
+                             "SECURITY_APP: Decrypted %d bytes of data", DataLength);
+        }
+    }
+}
+
+/*
+** Encrypt one payload and publish the result on TargetMsgID, either inline
+** or through the worker pool. Notify requests a success event.
+*/
+int32 SECURITY_APP_EncryptRecord(const uint8 *Data, uint16 DataLength, CFE_SB_MsgId_t TargetMsgID,
+                                 uint8 Suite, uint8 KeyId, uint8 Options, bool Notify)
+{
+#if (SECURITY_APP_NUM_WORKERS > 0)
+    return SECURITY_APP_SubmitJob(SECURITY_APP_OP_ENCRYPT, Data, DataLength, TargetMsgID, Suite, KeyId, Options,
+                                  Notify);
+#else
+    SECURITY_APP_OutputBuf_t OutputBuf;
+    uint64 Start = SECURITY_APP_PerfNow();
+    int32 status;
+    
+    status = SECURITY_APP_EncryptPayload(SECURITY_APP_MAIN_CHANNEL, Data, DataLength, TargetMsgID,
+                                         Suite, KeyId, Options, &OutputBuf);
+    SECURITY_APP_AcctRecord(TargetMsgID, SECURITY_APP_OP_ENCRYPT, DataLength, status == SECURITY_APP_SUCCESS,
+                            Start);
+    if (status != SECURITY_APP_SUCCESS)
+    {
+        return SECURITY_APP_ERROR;
+    }
+    
+    SECURITY_APP_PublishResult(SECURITY_APP_OP_ENCRYPT, &OutputBuf, DataLength, Notify);
+    
+    return SECURITY_APP_SUCCESS;
+#endif
+}
+
+/*
+** Decrypt one wire format record and publish the result on TargetMsgID,
+** either inline or through the worker pool. Notify requests a success event.
+*/
+int32 SECURITY_APP_DecryptRecord(const uint8 *Record, uint16 RecordLength, CFE_SB_MsgId_t TargetMsgID,
+                                 bool Notify)
+{
+#if (SECURITY_APP_NUM_WORKERS > 0)
+    return SECURITY_APP_SubmitJob(SECURITY_APP_OP_DECRYPT, Record, RecordLength, TargetMsgID, 0, 0, 0, Notify);
+#else
+    SECURITY_APP_OutputBuf_t OutputBuf;
+    uint16 DecryptedLength = 0;
+    uint64 Start = SECURITY_APP_PerfNow();
+    int32 status;
+    
+    status = SECURITY_APP_DecryptPayload(SECURITY_APP_MAIN_CHANNEL, Record, RecordLength, TargetMsgID,
+                                         &OutputBuf, &DecryptedLength);
+    SECURITY_APP_AcctRecord(TargetMsgID, SECURITY_APP_OP_DECRYPT, DecryptedLength,
+                            status == SECURITY_APP_SUCCESS, Start);
+    if (status != SECURITY_APP_SUCCESS)
+    {
+        return SECURITY_APP_ERROR;
+    }
+    
+    SECURITY_APP_PublishResult(SECURITY_APP_OP_DECRYPT, &OutputBuf, DecryptedLength, Notify);
+    
+    return SECURITY_APP_SUCCESS;
+#endif
+}
+
+/* Encrypt or sign the data of one command; AuthOnly selects signing */
+int32 SECURITY_APP_ProcessEncrypt(const SECURITY_APP_EncryptCmd_t *Msg, bool AuthOnly)
+{
+    SECURITY_APP_Data.CmdCounter++;
+    
+    /* Data may be shorter than the full array, but must be present in the packet */
+    if (Msg->DataLength > CFE_SB_GetTotalMsgLength((CFE_SB_MsgPtr_t)Msg) - offsetof(SECURITY_APP_EncryptCmd_t, Data))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_LENGTH);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Data length %d exceeds %s command length", Msg->DataLength,
+                         AuthOnly ? "sign" : "encrypt");
+        return CFE_SUCCESS;
+    }
+    
+    /* Never let an encrypt request go out in the clear, or a sign request be enciphered */
+    if (Msg->Suite < SECURITY_APP_SUITE_COUNT && (SECURITY_APP_SuiteAuthOnly(Msg->Suite) != 0) != AuthOnly)
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_SUITE);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Cipher suite %d cannot be used to %s", Msg->Suite,
+                         AuthOnly ? "sign" : "encrypt");
+        return CFE_SUCCESS;
+    }
+    
+    SECURITY_APP_EncryptRecord(Msg->Data, Msg->DataLength, Msg->TargetMsgID, Msg->Suite, Msg->KeyId,
+                               Msg->Options, TRUE);
+    
+    return CFE_SUCCESS;
+}
+
+/*
+** Whether a record's suite rules it out of decrypting (AuthOnly FALSE) or
+** verifying (TRUE). Malformed headers are left for the decrypt path to
+** report, so they are not refused here.
+*/
+static bool SECURITY_APP_RecordSuiteRefused(const uint8 *Record, uint16 RecordLength, bool AuthOnly, uint8 *Suite)
+{
+    SECURITY_APP_WireHdr_t Hdr;
+    
+    if (RecordLength < SECURITY_APP_WIRE_HDR_SIZE || SECURITY_APP_WireUnpack(&Hdr, Record) != SECURITY_APP_SUCCESS ||
+        Hdr.Suite >= SECURITY_APP_SUITE_COUNT)
+    {
+        return FALSE;
+    }
+    
+    *Suite = Hdr.Suite;
+    
+    return (SECURITY_APP_SuiteAuthOnly(Hdr.Suite) != 0) != AuthOnly;
+}
+
+/* Decrypt or verify the record of one command; AuthOnly selects verifying */
+int32 SECURITY_APP_ProcessDecrypt(const SECURITY_APP_DecryptCmd_t *Msg, bool AuthOnly)
+{
+    uint8 Suite;
+    
+    SECURITY_APP_Data.CmdCounter++;
+    
+    /* Data may be shorter than the full array, but must be present in the packet */
+    if (Msg->DataLength > CFE_SB_GetTotalMsgLength((CFE_SB_MsgPtr_t)Msg) - offsetof(SECURITY_APP_DecryptCmd_t, Record))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_LENGTH);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Data length %d exceeds %s command length", Msg->DataLength,
+                         AuthOnly ? "verify" : "decrypt");
+        return CFE_SUCCESS;
+    }
+    
+    if (SECURITY_APP_RecordSuiteRefused(Msg->Record, Msg->DataLength, AuthOnly, &Suite))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_SUITE);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Cipher suite %d cannot be used to %s", Suite,
+                         AuthOnly ? "verify" : "decrypt");
+        return CFE_SUCCESS;
+    }
+    
+    SECURITY_APP_DecryptRecord(Msg->Record, Msg->DataLength, Msg->TargetMsgID, TRUE);
+    
+    return CFE_SUCCESS;
+}
+
+/* Encrypt message command handler */
+int32 SECURITY_APP_EncryptMsg(const SECURITY_APP_EncryptCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessEncrypt(Msg, FALSE);
+}
+
+/* Decrypt message command handler */
+int32 SECURITY_APP_DecryptMsg(const SECURITY_APP_DecryptCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessDecrypt(Msg, FALSE);
+}
+
+/* Sign message command handler */
+int32 SECURITY_APP_SignMsg(const SECURITY_APP_SignCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessEncrypt(Msg, TRUE);
+}
+
+/* Verify message command handler */
+int32 SECURITY_APP_VerifyMsg(const SECURITY_APP_VerifyCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessDecrypt(Msg, TRUE);
+}
+
+#if (SECURITY_APP_NUM_WORKERS == 0)
+/*
+** Batch encrypt records waiting to be encrypted together. Inline, the main
+** task holds up to SECURITY_APP_MULTI_BUFFERS of them so that
+** SECURITY_APP_EncryptMulti can interleave their cipher chains; headers,
+** sequence numbers and publication stay in record order.
+*/
+typedef struct
+{
+    const uint8     *Data;
+    uint16           DataLength;
+    CFE_SB_MsgId_t   TargetMsgID;
+} SECURITY_APP_GroupRecord_t;
+
+static SECURITY_APP_OutputBuf_t SECURITY_APP_GroupBuf[SECURITY_APP_MULTI_BUFFERS];
+
+/*
+** Encrypt and publish a group of records; returns how many failed. The one
+** cipher call is timed once and shared out by record length, so each record
+** is accounted its own prepare, its share of the cipher time and its own
+** finish.
+*/
+static uint16 SECURITY_APP_EncryptGroup(const SECURITY_APP_GroupRecord_t *Group, uint16 Count,
+                                        uint8 Suite, uint8 KeyId)
+{
+    SECURITY_APP_WireHdr_t Hdr[SECURITY_APP_MULTI_BUFFERS];
+    security_app_crypto_job_t Job[SECURITY_APP_MULTI_BUFFERS];
+    int32 Prepared[SECURITY_APP_MULTI_BUFFERS];
+    uint64 Ticks[SECURITY_APP_MULTI_BUFFERS];
+    uint64 Start;
+    uint64 CryptoTicks;
+    uint64 Share;
+    uint32 GroupBytes = 0;
+    uint16 Jobs = 0;
+    uint16 Failed = 0;
+    uint16 i;
+    int32 status;
+    
+    for (i = 0; i < Count; i++)
+    {
+        Start = SECURITY_APP_PerfNow();
+        Prepared[i] = SECURITY_APP_EncryptPrepare(SECURITY_APP_MAIN_CHANNEL, Group[i].Data, Group[i].DataLength,
+                                                  Group[i].TargetMsgID, Suite, KeyId, 0,
+                                                  &SECURITY_APP_GroupBuf[i], &Hdr[i], &Job[Jobs]);
+        if (Prepared[i] == SECURITY_APP_SUCCESS)
+        {
+            GroupBytes += Job[Jobs].plaintext_len;
+            Jobs++;
+        }
+        Ticks[i] = SECURITY_APP_PerfNow() - Start;
+    }
+    
+    Start = SECURITY_APP_PerfNow();
+    SECURITY_APP_EncryptMulti(SECURITY_APP_MAIN_CHANNEL, KeyId, Suite, Job, Jobs);
+    CryptoTicks = SECURITY_APP_PerfNow() - Start;
+    
+    Jobs = 0;
+    for (i = 0; i < Count; i++)
+    {
+        Start = SECURITY_APP_PerfNow();
+        status = Prepared[i];
+        if (status == SECURITY_APP_SUCCESS)
+        {
+            Share = (GroupBytes != 0) ? CryptoTicks * Job[Jobs].plaintext_len / GroupBytes : 0;
+            Ticks[i] += Share;
+            status = SECURITY_APP_EncryptFinish(SECURITY_APP_MAIN_CHANNEL, &SECURITY_APP_GroupBuf[i], &Hdr[i],
+                                                &Job[Jobs++], Share);
+        }
+        
+        SECURITY_APP_AcctRecordTicks(Group[i].TargetMsgID, SECURITY_APP_OP_ENCRYPT, Group[i].DataLength,
+                                     status == SECURITY_APP_SUCCESS, Ticks[i] + SECURITY_APP_PerfNow() - Start);
+        if (status == SECURITY_APP_SUCCESS)
+        {
+            SECURITY_APP_PublishResult(SECURITY_APP_OP_ENCRYPT, &SECURITY_APP_GroupBuf[i], Group[i].DataLength,
+                                       FALSE);
+        }
+        else
+        {
+            Failed++;
+        }
+    }
+    
+    return Failed;
+}
+#endif
+
+/* Walk a packed record list and encrypt or decrypt every record in one pass */
+int32 SECURITY_APP_ProcessBatch(const SECURITY_APP_BatchCmd_t *Msg, bool Encrypt)
+{
+    SECURITY_APP_BatchRecordHdr_t RecordHdr;
+    uint16 PayloadLength;
+    uint16 Offset = 0;
+    uint16 Processed = 0;
+    uint16 Failed = 0;
+    uint16 i;
+    uint8 Suite;
+    int32 status;
+#if (SECURITY_APP_NUM_WORKERS == 0)
+    SECURITY_APP_GroupRecord_t Group[SECURITY_APP_MULTI_BUFFERS];
+    uint16 Grouped = 0;
+#endif
+    
+    SECURITY_APP_Data.CmdCounter++;
+    
+    /* As for single records, an encrypt batch must never go out in the clear */
+    if (Encrypt && Msg->Suite < SECURITY_APP_SUITE_COUNT && SECURITY_APP_SuiteAuthOnly(Msg->Suite))
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, SECURITY_APP_STAT_ERR_SUITE);
+        CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Cipher suite %d cannot be used to encrypt", Msg->Suite);
         return CFE_SUCCESS;
     }
     
-    /* Update telemetry */
-    DecryptedTlm.DataLength = decrypted_len;
+    PayloadLength = CFE_SB_GetTotalMsgLength((CFE_SB_MsgPtr_t)Msg) - offsetof(SECURITY_APP_BatchCmd_t, Records);
     
-    /* Send decrypted data */
-    CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)&DecryptedTlm);
-    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)&DecryptedTlm);
+    for (i = 0; i < Msg->RecordCount; i++)
+    {
+        /* Records are packed, so copy each header out before use */
+        if ((uint16)(PayloadLength - Offset) < sizeof(RecordHdr))
+        {
+            break;
+        }
+        memcpy(&RecordHdr, &Msg->Records[Offset], sizeof(RecordHdr));
+        Offset += sizeof(RecordHdr);
+        
+        if (RecordHdr.DataLength > PayloadLength - Offset)
+        {
+            break;
+        }
+        
+        if (Encrypt)
+        {
+#if (SECURITY_APP_NUM_WORKERS == 0)
+            /* Failures are counted when the group is encrypted */
+            Group[Grouped].Data = &Msg->Records[Offset];
+            Group[Grouped].DataLength = RecordHdr.DataLength;
+            Group[Grouped].TargetMsgID = RecordHdr.TargetMsgID;
+            if (++Grouped == SECURITY_APP_MULTI_BUFFERS)
+            {
+                Failed += SECURITY_APP_EncryptGroup(Group, Grouped, Msg->Suite, Msg->KeyId);
+                Grouped = 0;
+            }
+            status = SECURITY_APP_SUCCESS;
+#else
+            status = SECURITY_APP_EncryptRecord(&Msg->Records[Offset], RecordHdr.DataLength,
+                                                RecordHdr.TargetMsgID, Msg->Suite, Msg->KeyId, 0, FALSE);
+#endif
+        }
+        else if (SECURITY_APP_RecordSuiteRefused(&Msg->Records[Offset], RecordHdr.DataLength, FALSE, &Suite))
+        {
+            /* Signed records are only released through verify */
+            SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, SECURITY_APP_STAT_ERR_SUITE);
+            CFE_EVS_SendEvent(SECURITY_APP_INVALID_DATA_ERR_EID, CFE_EVS_ERROR,
+                             "SECURITY_APP: Cipher suite %d cannot be used to decrypt batch record %d", Suite, i);
+            status = SECURITY_APP_ERROR;
+        }
+        else
+        {
+            status = SECURITY_APP_DecryptRecord(&Msg->Records[Offset], RecordHdr.DataLength,
+                                                RecordHdr.TargetMsgID, FALSE);
+        }
+        
+        if (status != SECURITY_APP_SUCCESS)
+        {
+            Failed++;
+        }
+        
+        Offset += RecordHdr.DataLength;
+        Processed++;
+    }
+    
+#if (SECURITY_APP_NUM_WORKERS == 0)
+    if (Grouped > 0)
+    {
+        Failed += SECURITY_APP_EncryptGroup(Group, Grouped, Msg->Suite, Msg->KeyId);
+    }
+#endif
     
-    /* Update housekeeping */
-    SECURITY_APP_Data.HkTlm.DecryptionCount++;
+    if (Processed < Msg->RecordCount)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_BATCH_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Batch truncated at record %d of %d",
+                         Processed, Msg->RecordCount);
+    }
     
-    /* Log success */
-    CFE_EVS_SendEvent(SECURITY_APP_DECRYPT_INF_EID, CFE_EVS_INFORMATION,
-                     "SECURITY_APP: Decrypted %d bytes of data", decrypted_len);
+    CFE_EVS_SendEvent(SECURITY_APP_BATCH_INF_EID, CFE_EVS_INFORMATION,
+                     "SECURITY_APP: %s batch of %d records, %d failed",
+                     Encrypt ? "Encrypted" : "Decrypted", Processed, Failed);
     
     return CFE_SUCCESS;
-}
\ No newline at end of file
+}
+
+/* Batch encrypt command handler */
+int32 SECURITY_APP_EncryptBatch(const SECURITY_APP_EncryptBatchCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessBatch(Msg, TRUE);
+}
+
+/* Batch decrypt command handler */
+int32 SECURITY_APP_DecryptBatch(const SECURITY_APP_DecryptBatchCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessBatch(Msg, FALSE);
+}
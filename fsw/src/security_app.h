@@ -8,6 +8,7 @@
 #include "security_app_platform_cfg.h"
 #include "security_app_mission_cfg.h"
 #include "security_app_msg.h"
+#include "security_app_tbl.h"
 
 /**
  * \defgroup cfsSECURITYAPP CFS Security Application
@@ -20,11 +21,47 @@
 #define SECURITY_APP_SUCCESS           (0)
 #define SECURITY_APP_ERROR             (-1)
 
-#define SECURITY_APP_PIPE_DEPTH        32
+/*
+** Software Bus pipes, in the order the main loop reads them
+*/
+#define SECURITY_APP_PIPE_CONTROL      0
+#define SECURITY_APP_PIPE_DATA         1
+#define SECURITY_APP_PIPE_COUNT        2
+
+/*
+** Crypto operations
+*/
+#define SECURITY_APP_OP_ENCRYPT        0
+#define SECURITY_APP_OP_DECRYPT        1
+
+/*
+** HK counters are updated by the main task and by crypto worker tasks, so
+** every update goes through these atomic helpers.
+*/
+#define SECURITY_APP_COUNTER_INC(Counter)    ((void)__atomic_fetch_add(&(Counter), 1, __ATOMIC_RELAXED))
+#define SECURITY_APP_COUNTER_CLEAR(Counter)  (__atomic_store_n(&(Counter), 0, __ATOMIC_RELAXED))
+#define SECURITY_APP_COUNTER_ADD(Counter, N) ((void)__atomic_fetch_add(&(Counter), (N), __ATOMIC_RELAXED))
+#define SECURITY_APP_COUNTER_TAKE(Counter)   (__atomic_exchange_n(&(Counter), 0, __ATOMIC_RELAXED))
 
 /*
 ** Type definitions
 */
+
+/*
+** Stream session bookkeeping (cipher state lives in the crypto layer)
+*/
+typedef struct
+{
+    bool               InUse;
+    uint8              Suite;
+    uint8              Direction;
+    CFE_SB_MsgId_t     TargetMsgID;
+    uint16             NextSeq;
+    uint32             TotalLength;
+    uint32             HeldLength;          /* Decrypt sessions: plaintext held until END */
+
+} SECURITY_APP_StreamSession_t;
+
 typedef struct
 {
     /*
@@ -38,10 +75,31 @@ typedef struct
     */
     SECURITY_APP_HkTlm_t   HkTlm;
 
+    /*
+    ** Crypto statistics: Stats accumulates between reports and is drained
+    ** into StatsTlm every SECURITY_APP_STATS_REPORT_CYCLES HK requests
+    */
+    SECURITY_APP_StatsTlm_t  Stats;
+    SECURITY_APP_StatsTlm_t  StatsTlm;
+    uint16                   StatsCycles;
+
     /*
     ** Operational data
     */
-    CFE_SB_PipeId_t    CmdPipe;
+    CFE_SB_PipeId_t    ControlPipe;
+    CFE_SB_PipeId_t    DataPipe;
+
+    SECURITY_APP_StreamSession_t  Streams[SECURITY_APP_MAX_STREAMS];
+
+    /*
+    ** Key table, and the inline encryption table with the active entries
+    ** copied out of it
+    */
+    CFE_TBL_Handle_t             KeyTblHandle;
+    bool                         KeyRetryPending;
+    CFE_TBL_Handle_t             InlineTblHandle;
+    SECURITY_APP_InlineEntry_t   InlineMap[SECURITY_APP_INLINE_TBL_MAX_ENTRIES];
+    uint16                       InlineCount;
     
     /*
     ** Run Status variable used in the main processing loop
@@ -51,11 +109,39 @@ typedef struct
     /*
     ** Initialization data (not reported in housekeeping)
     */
-    char    PipeName[16];
-    uint16  PipeDepth;
+    char    ControlPipeName[OS_MAX_API_NAME];
+    char    DataPipeName[OS_MAX_API_NAME];
+    uint16  PipeDepth[SECURITY_APP_PIPE_COUNT];
 
 } SECURITY_APP_Data_t;
 
+extern SECURITY_APP_Data_t SECURITY_APP_Data;
+
+/*
+** Output packet for crypto results. In zero-copy mode the packet lives in an
+** SB buffer; otherwise it is held locally and copied by CFE_SB_SendMsg.
+*/
+typedef struct
+{
+    CFE_SB_MsgPtr_t    MsgPtr;
+
+    /* Sequence number a decrypted packet commits to the replay window, 0 for none */
+    uint8              ReplayKey;
+    uint32             ReplaySeq;
+
+#if (SECURITY_APP_ZERO_COPY_OUTPUT == 1)
+    CFE_SB_ZeroCopyHandle_t  BufferHandle;
+#else
+    union
+    {
+        SECURITY_APP_EncryptedTlm_t  Encrypted;
+        SECURITY_APP_DecryptedTlm_t  Decrypted;
+        SECURITY_APP_StreamTlm_t     Stream;
+    } Local __attribute__((aligned(16)));
+#endif
+
+} SECURITY_APP_OutputBuf_t;
+
 /*
 ** Function prototypes
 */
@@ -63,10 +149,54 @@ void SECURITY_APP_Main(void);
 int32 SECURITY_APP_Init(void);
 void SECURITY_APP_ProcessCommandPacket(CFE_SB_MsgPtr_t Msg);
 void SECURITY_APP_ReportHousekeeping(void);
+void SECURITY_APP_ReportStats(void);
+void SECURITY_APP_CountSuccess(uint8 Operation, uint32 Bytes);
+void SECURITY_APP_CountError(uint8 Operation, uint8 Category);
+void SECURITY_APP_CountReplay(uint8 KeyId, uint32 Seq);
 bool SECURITY_APP_VerifyCmdLength(CFE_SB_MsgPtr_t Msg, uint16 ExpectedLength);
+bool SECURITY_APP_VerifyCmdLengthRange(CFE_SB_MsgPtr_t Msg, uint16 MinLength, uint16 MaxLength);
 int32 SECURITY_APP_Noop(const SECURITY_APP_NoopCmd_t *Msg);
 int32 SECURITY_APP_ResetCounters(const SECURITY_APP_ResetCountersCmd_t *Msg);
 int32 SECURITY_APP_EncryptMsg(const SECURITY_APP_EncryptCmd_t *Msg);
 int32 SECURITY_APP_DecryptMsg(const SECURITY_APP_DecryptCmd_t *Msg);
+int32 SECURITY_APP_SignMsg(const SECURITY_APP_SignCmd_t *Msg);
+int32 SECURITY_APP_VerifyMsg(const SECURITY_APP_VerifyCmd_t *Msg);
+int32 SECURITY_APP_ProcessEncrypt(const SECURITY_APP_EncryptCmd_t *Msg, bool AuthOnly);
+int32 SECURITY_APP_ProcessDecrypt(const SECURITY_APP_DecryptCmd_t *Msg, bool AuthOnly);
+int32 SECURITY_APP_EncryptBatch(const SECURITY_APP_EncryptBatchCmd_t *Msg);
+int32 SECURITY_APP_DecryptBatch(const SECURITY_APP_DecryptBatchCmd_t *Msg);
+int32 SECURITY_APP_ProcessBatch(const SECURITY_APP_BatchCmd_t *Msg, bool Encrypt);
+int32 SECURITY_APP_EncryptRecord(const uint8 *Data, uint16 DataLength, CFE_SB_MsgId_t TargetMsgID,
+                                 uint8 Suite, uint8 KeyId, uint8 Options, bool Notify);
+int32 SECURITY_APP_StreamBeginCmd(const SECURITY_APP_StreamBeginCmd_t *Msg);
+int32 SECURITY_APP_StreamAppendCmd(const SECURITY_APP_StreamAppendCmd_t *Msg);
+int32 SECURITY_APP_StreamEndCmd(const SECURITY_APP_StreamEndCmd_t *Msg);
+int32 SECURITY_APP_InitNonceTask(void);
+void SECURITY_APP_NonceTaskMain(void);
+int32 SECURITY_APP_InitFileTask(void);
+void SECURITY_APP_FileTaskMain(void);
+void SECURITY_APP_FileReaderMain(void);
+int32 SECURITY_APP_FileEncryptCmd(const SECURITY_APP_FileEncryptCmd_t *Msg);
+int32 SECURITY_APP_FileDecryptCmd(const SECURITY_APP_FileDecryptCmd_t *Msg);
+int32 SECURITY_APP_AcctDumpCmd(const SECURITY_APP_AcctDumpCmd_t *Msg);
+int32 SECURITY_APP_InitKeyTbl(void);
+int32 SECURITY_APP_ValidateKeyTbl(void *TblData);
+void SECURITY_APP_ManageKeyTbl(void);
+int32 SECURITY_APP_InitInlineTbl(void);
+int32 SECURITY_APP_ValidateInlineTbl(void *TblData);
+void SECURITY_APP_ManageInlineTbl(void);
+const SECURITY_APP_InlineEntry_t *SECURITY_APP_FindInlineEntry(CFE_SB_MsgId_t MsgId);
+int32 SECURITY_APP_InlineEncrypt(CFE_SB_MsgPtr_t Msg, const SECURITY_APP_InlineEntry_t *Entry);
+int32 SECURITY_APP_DecryptRecord(const uint8 *Record, uint16 RecordLength, CFE_SB_MsgId_t TargetMsgID,
+                                 bool Notify);
+int32 SECURITY_APP_EncryptPayload(uint8 Channel, const uint8 *Data, uint16 DataLength, CFE_SB_MsgId_t TargetMsgID,
+                                  uint8 Suite, uint8 KeyId, uint8 Options, SECURITY_APP_OutputBuf_t *OutputBuf);
+int32 SECURITY_APP_DecryptPayload(uint8 Channel, const uint8 *Record, uint16 RecordLength, CFE_SB_MsgId_t TargetMsgID,
+                                  SECURITY_APP_OutputBuf_t *OutputBuf, uint16 *DecryptedLength);
+void SECURITY_APP_PublishResult(uint8 Operation, SECURITY_APP_OutputBuf_t *OutputBuf, uint16 DataLength,
+                                bool Notify);
+CFE_SB_MsgPtr_t SECURITY_APP_AcquireOutput(SECURITY_APP_OutputBuf_t *Buf, CFE_SB_MsgId_t MsgId, uint16 Size);
+int32 SECURITY_APP_SendOutput(SECURITY_APP_OutputBuf_t *Buf);
+void SECURITY_APP_ReleaseOutput(SECURITY_APP_OutputBuf_t *Buf);
 
 #endif /* SECURITY_APP_H */
\ No newline at end of file
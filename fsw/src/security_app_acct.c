@@ -0,0 +1,285 @@
+#include "security_app_acct.h"
+#include "security_app_events.h"
+#include "security_app_perf.h"
+
+#include <stddef.h>
+#include <string.h>
+
+CompileTimeAssert((SECURITY_APP_ACCT_TBL_SIZE & (SECURITY_APP_ACCT_TBL_SIZE - 1)) == 0 &&
+                  SECURITY_APP_ACCT_TBL_SIZE <= 0xFFFF, AcctTableSizePowerOfTwo);
+
+/*
+** Key is the message ID plus one, so that zero marks a free slot. A slot's
+** key never changes once claimed.
+*/
+typedef struct
+{
+    uint32  Key;
+    uint32  Ops[2];
+    uint32  Bytes[2];
+    uint32  Errors[2];
+    uint64  Ticks;
+
+} SECURITY_APP_AcctSlot_t;
+
+static struct
+{
+    SECURITY_APP_AcctSlot_t  Slots[SECURITY_APP_ACCT_TBL_SIZE];
+    uint32                   UntrackedCount;
+    SECURITY_APP_AcctTlm_t   Tlm;
+
+} SECURITY_APP_Acct;
+
+/* Find the slot for a message ID, claiming a free one for a new ID; NULL if the table is full */
+static SECURITY_APP_AcctSlot_t *SECURITY_APP_AcctLookup(CFE_SB_MsgId_t MsgId)
+{
+    uint32 Key = (uint32)MsgId + 1;
+    uint32 Index = ((uint32)MsgId * 2654435761U) >> 16;
+    uint32 Found;
+    uint32 Probe;
+    SECURITY_APP_AcctSlot_t *Slot;
+
+    for (Probe = 0; Probe < SECURITY_APP_ACCT_TBL_SIZE; Probe++)
+    {
+        Slot = &SECURITY_APP_Acct.Slots[(Index + Probe) & (SECURITY_APP_ACCT_TBL_SIZE - 1)];
+
+        Found = __atomic_load_n(&Slot->Key, __ATOMIC_ACQUIRE);
+        if (Found == 0)
+        {
+            /* On losing the race, Found holds the winner's key */
+            if (__atomic_compare_exchange_n(&Slot->Key, &Found, Key, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                return Slot;
+            }
+        }
+        if (Found == Key)
+        {
+            return Slot;
+        }
+    }
+
+    return NULL;
+}
+
+/* Clear the table at startup */
+void SECURITY_APP_InitAcct(void)
+{
+    memset(&SECURITY_APP_Acct, 0, sizeof(SECURITY_APP_Acct));
+    CFE_SB_InitMsg(&SECURITY_APP_Acct.Tlm, SECURITY_APP_ACCT_TLM_MID, sizeof(SECURITY_APP_AcctTlm_t), TRUE);
+}
+
+/* Zero every total; message IDs keep their slots */
+void SECURITY_APP_ResetAcct(void)
+{
+    SECURITY_APP_AcctSlot_t *Slot;
+    uint32 i;
+
+    for (i = 0; i < SECURITY_APP_ACCT_TBL_SIZE; i++)
+    {
+        Slot = &SECURITY_APP_Acct.Slots[i];
+        SECURITY_APP_COUNTER_CLEAR(Slot->Ops[0]);
+        SECURITY_APP_COUNTER_CLEAR(Slot->Ops[1]);
+        SECURITY_APP_COUNTER_CLEAR(Slot->Bytes[0]);
+        SECURITY_APP_COUNTER_CLEAR(Slot->Bytes[1]);
+        SECURITY_APP_COUNTER_CLEAR(Slot->Errors[0]);
+        SECURITY_APP_COUNTER_CLEAR(Slot->Errors[1]);
+        SECURITY_APP_COUNTER_CLEAR(Slot->Ticks);
+    }
+
+    SECURITY_APP_COUNTER_CLEAR(SECURITY_APP_Acct.UntrackedCount);
+}
+
+/* Account one record for MsgId, started at Start; any task may call this */
+void SECURITY_APP_AcctRecord(CFE_SB_MsgId_t MsgId, uint8 Operation, uint32 Bytes, bool Success, uint64 Start)
+{
+    SECURITY_APP_AcctRecordTicks(MsgId, Operation, Bytes, Success, SECURITY_APP_PerfNow() - Start);
+}
+
+/* Account one record for MsgId that took Ticks of processing; any task may call this */
+void SECURITY_APP_AcctRecordTicks(CFE_SB_MsgId_t MsgId, uint8 Operation, uint32 Bytes, bool Success, uint64 Ticks)
+{
+    SECURITY_APP_AcctSlot_t *Slot = SECURITY_APP_AcctLookup(MsgId);
+
+    if (Slot == NULL)
+    {
+        SECURITY_APP_COUNTER_INC(SECURITY_APP_Acct.UntrackedCount);
+        return;
+    }
+
+    if (Success)
+    {
+        SECURITY_APP_COUNTER_INC(Slot->Ops[Operation]);
+        SECURITY_APP_COUNTER_ADD(Slot->Bytes[Operation], Bytes);
+    }
+    else
+    {
+        SECURITY_APP_COUNTER_INC(Slot->Errors[Operation]);
+    }
+
+    SECURITY_APP_COUNTER_ADD(Slot->Ticks, Ticks);
+}
+
+/* The measure entries are ranked by */
+static uint64 SECURITY_APP_AcctMeasure(const SECURITY_APP_AcctSlot_t *Slot, uint8 SortBy)
+{
+    switch (SortBy)
+    {
+        case SECURITY_APP_ACCT_SORT_BYTES:
+            return (uint64)Slot->Bytes[0] + Slot->Bytes[1];
+
+        case SECURITY_APP_ACCT_SORT_ERRORS:
+            return (uint64)Slot->Errors[0] + Slot->Errors[1];
+
+        case SECURITY_APP_ACCT_SORT_TICKS:
+            return Slot->Ticks;
+
+        default:
+            return (uint64)Slot->Ops[0] + Slot->Ops[1];
+    }
+}
+
+/*
+** Fill the telemetry packet with up to Count entries, largest measure first.
+** Totals are read while other tasks may be adding to them, so an entry can
+** be a record or two behind its neighbours.
+*/
+static void SECURITY_APP_AcctCollect(uint16 Count, uint8 SortBy)
+{
+    SECURITY_APP_AcctTlm_t *Tlm = &SECURITY_APP_Acct.Tlm;
+    SECURITY_APP_AcctSlot_t Snapshot[SECURITY_APP_ACCT_TBL_SIZE];
+    SECURITY_APP_AcctSlot_t *Slot;
+    SECURITY_APP_AcctSlot_t Swap;
+    SECURITY_APP_AcctEntry_t *Entry;
+    uint32 Used = 0;
+    uint32 Best;
+    uint32 i;
+    uint32 j;
+
+    for (i = 0; i < SECURITY_APP_ACCT_TBL_SIZE; i++)
+    {
+        Slot = &SECURITY_APP_Acct.Slots[i];
+        if (__atomic_load_n(&Slot->Key, __ATOMIC_ACQUIRE) != 0)
+        {
+            Snapshot[Used].Key = Slot->Key;
+            for (j = 0; j < 2; j++)
+            {
+                Snapshot[Used].Ops[j] = __atomic_load_n(&Slot->Ops[j], __ATOMIC_RELAXED);
+                Snapshot[Used].Bytes[j] = __atomic_load_n(&Slot->Bytes[j], __ATOMIC_RELAXED);
+                Snapshot[Used].Errors[j] = __atomic_load_n(&Slot->Errors[j], __ATOMIC_RELAXED);
+            }
+            Snapshot[Used].Ticks = __atomic_load_n(&Slot->Ticks, __ATOMIC_RELAXED);
+            Used++;
+        }
+    }
+
+    if (Count == 0 || Count > Used)
+    {
+        Count = Used;
+    }
+
+    /* Partial selection sort: only the first Count places are needed */
+    for (i = 0; i < Count; i++)
+    {
+        Best = i;
+        for (j = i + 1; j < Used; j++)
+        {
+            if (SECURITY_APP_AcctMeasure(&Snapshot[j], SortBy) > SECURITY_APP_AcctMeasure(&Snapshot[Best], SortBy))
+            {
+                Best = j;
+            }
+        }
+        Swap = Snapshot[i];
+        Snapshot[i] = Snapshot[Best];
+        Snapshot[Best] = Swap;
+
+        Entry = &Tlm->Entries[i];
+        Entry->MsgId = (uint16)(Snapshot[i].Key - 1);
+        Entry->Spare = 0;
+        for (j = 0; j < 2; j++)
+        {
+            Entry->Ops[j] = Snapshot[i].Ops[j];
+            Entry->Bytes[j] = Snapshot[i].Bytes[j];
+            Entry->Errors[j] = Snapshot[i].Errors[j];
+        }
+        Entry->TicksHigh = (uint32)(Snapshot[i].Ticks >> 32);
+        Entry->TicksLow = (uint32)Snapshot[i].Ticks;
+    }
+
+    Tlm->EntryCount = Count;
+    Tlm->TrackedCount = Used;
+    Tlm->UntrackedCount = __atomic_load_n(&SECURITY_APP_Acct.UntrackedCount, __ATOMIC_RELAXED);
+}
+
+/* Write the collected entries to a file; returns FALSE on any file error */
+static bool SECURITY_APP_AcctWriteFile(const char *File)
+{
+    const SECURITY_APP_AcctTlm_t *Tlm = &SECURITY_APP_Acct.Tlm;
+    CFE_FS_Header_t FileHeader;
+    uint32 Length;
+    int32 Fd;
+    int32 status;
+    bool Written;
+
+    Length = offsetof(SECURITY_APP_AcctTlm_t, Entries) - offsetof(SECURITY_APP_AcctTlm_t, EntryCount) +
+              Tlm->EntryCount * sizeof(SECURITY_APP_AcctEntry_t);
+
+    Fd = OS_creat(File, OS_WRITE_ONLY);
+    if (Fd < 0)
+    {
+        return FALSE;
+    }
+
+    memset(&FileHeader, 0, sizeof(FileHeader));
+    FileHeader.SubType = SECURITY_APP_ACCT_FILE_SUBTYPE;
+    strncpy(FileHeader.Description, "Security app stream accounting", sizeof(FileHeader.Description) - 1);
+
+    status = CFE_FS_WriteHeader(Fd, &FileHeader);
+    Written = (status == sizeof(CFE_FS_Header_t)) &&
+              (OS_write(Fd, &Tlm->EntryCount, Length) == (int32)Length);
+
+    OS_close(Fd);
+
+    return Written;
+}
+
+/* Per-stream accounting dump command handler */
+int32 SECURITY_APP_AcctDumpCmd(const SECURITY_APP_AcctDumpCmd_t *Msg)
+{
+    SECURITY_APP_AcctTlm_t *Tlm = &SECURITY_APP_Acct.Tlm;
+
+    SECURITY_APP_Data.CmdCounter++;
+
+    if (Msg->SortBy > SECURITY_APP_ACCT_SORT_TICKS ||
+        memchr(Msg->File, '\0', sizeof(Msg->File)) == NULL)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_ACCT_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Invalid accounting dump, sort %d or unterminated file name", Msg->SortBy);
+        return CFE_SUCCESS;
+    }
+
+    SECURITY_APP_AcctCollect(Msg->Count, Msg->SortBy);
+
+    if (Msg->File[0] == '\0')
+    {
+        CFE_SB_SetTotalMsgLength((CFE_SB_MsgPtr_t)Tlm, offsetof(SECURITY_APP_AcctTlm_t, Entries) +
+                                 Tlm->EntryCount * sizeof(SECURITY_APP_AcctEntry_t));
+        CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)Tlm);
+        CFE_SB_SendMsg((CFE_SB_MsgPtr_t)Tlm);
+        return CFE_SUCCESS;
+    }
+
+    if (!SECURITY_APP_AcctWriteFile(Msg->File))
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_ACCT_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Unable to write accounting dump %s", Msg->File);
+        return CFE_SUCCESS;
+    }
+
+    CFE_EVS_SendEvent(SECURITY_APP_ACCT_INF_EID, CFE_EVS_INFORMATION,
+                     "SECURITY_APP: Wrote %d of %d stream accounting entries to %s",
+                     Tlm->EntryCount, Tlm->TrackedCount, Msg->File);
+
+    return CFE_SUCCESS;
+}
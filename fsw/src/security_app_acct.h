@@ -0,0 +1,22 @@
+#ifndef SECURITY_APP_ACCT_H
+#define SECURITY_APP_ACCT_H
+
+#include "security_app.h"
+
+/*
+** Per-stream accounting
+**
+** Operations, bytes, errors and processing time are totalled per target
+** message ID in a fixed-size open-addressing hash table. The main task and
+** every worker record into it directly: an unseen message ID claims a free
+** slot with a compare-and-swap and the totals are atomic adds, so a record
+** is a hash and a short probe with no locks or allocation. Message IDs that
+** find the table full are only counted in aggregate. Slots are never freed;
+** resetting clears the totals but keeps the message IDs.
+*/
+void SECURITY_APP_InitAcct(void);
+void SECURITY_APP_ResetAcct(void);
+void SECURITY_APP_AcctRecord(CFE_SB_MsgId_t MsgId, uint8 Operation, uint32 Bytes, bool Success, uint64 Start);
+void SECURITY_APP_AcctRecordTicks(CFE_SB_MsgId_t MsgId, uint8 Operation, uint32 Bytes, bool Success, uint64 Ticks);
+
+#endif /* SECURITY_APP_ACCT_H */
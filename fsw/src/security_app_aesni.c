@@ -0,0 +1,707 @@
+#include "security_app_provider.h"
+
+#if (SECURITY_APP_HAVE_AESNI == 1)
+
+#include <string.h>
+#include <cpuid.h>
+#include <immintrin.h>
+
+/*
+** Built-in AES-256 CBC and CTR on the x86 AES instructions
+**
+** Two providers share one context layout and key schedule. "aesni" keeps
+** eight blocks in flight in the XMM registers for CTR and CBC decryption;
+** CBC encryption is serial by construction. "vaes" runs the same modes
+** sixteen blocks at a time with the 256-bit VAES instructions on long
+** messages and falls back to the XMM kernels for the tail. Both also
+** encrypt several CBC messages at once, interleaving their independent
+** chains on the XMM kernel. The rest of the
+** file is compiled for the baseline ISA and only calls into either kernel
+** once the CPU and OS support for it has been checked.
+*/
+#define AES_BLOCK_SIZE      16
+#define AES256_ROUNDS       14
+#define AESNI_LANES         8
+#define VAES_LANES          16
+
+#define AESNI_TARGET        __attribute__((target("sse2,ssse3,aes")))
+#define VAES_TARGET         __attribute__((target("sse2,ssse3,aes,avx2,vaes")))
+#define RDRAND_TARGET       __attribute__((target("rdrnd")))
+
+typedef struct {
+    __m128i  enc[AES256_ROUNDS + 1];
+    __m128i  dec[AES256_ROUNDS + 1];
+    __m128i  chain;         /* CBC: previous ciphertext block */
+    uint32_t nonce[3];      /* CTR: counter block bytes 0-11, as loaded */
+    uint32_t counter;       /* CTR: next block number */
+    uint8_t  suite;
+} aesni_ctx_t;
+
+static aesni_ctx_t aesni_ctx[SECURITY_APP_PROVIDER_CONTEXTS];
+static uint8_t     aesni_in_use[SECURITY_APP_PROVIDER_CONTEXTS];
+static int         aesni_has_rdrand;
+
+/*
+** CPU features
+*/
+static int SECURITY_APP_AesniAvailable(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+
+    return (ecx & bit_AES) && (ecx & bit_SSSE3) && (edx & bit_SSE2);
+}
+
+static int SECURITY_APP_VaesAvailable(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0_lo, xcr0_hi;
+
+    if (!SECURITY_APP_AesniAvailable() || !__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+        !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return 0;
+    }
+
+    /* The OS must save the YMM state across context switches */
+    __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0_lo & 0x6) != 0x6) {
+        return 0;
+    }
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+
+    return (ebx & bit_AVX2) && (ecx & bit_VAES);
+}
+
+static int32_t SECURITY_APP_AesniInit(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    aesni_has_rdrand = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_RDRND);
+
+    return 0;
+}
+
+static int SECURITY_APP_AesniSupports(uint8_t suite)
+{
+    return suite == SECURITY_APP_SUITE_AES256_CBC || suite == SECURITY_APP_SUITE_AES256_CTR;
+}
+
+/*
+** Key schedule
+*/
+AESNI_TARGET static inline __m128i SECURITY_APP_AesniExpand(__m128i key, __m128i assist)
+{
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+
+    return _mm_xor_si128(key, assist);
+}
+
+/* Round key n of AES-256 from the two before it */
+#define AESNI_EXPAND_EVEN(k, n, rcon) \
+    ((k)[n] = SECURITY_APP_AesniExpand((k)[(n) - 2], \
+                  _mm_shuffle_epi32(_mm_aeskeygenassist_si128((k)[(n) - 1], rcon), 0xff)))
+#define AESNI_EXPAND_ODD(k, n) \
+    ((k)[n] = SECURITY_APP_AesniExpand((k)[(n) - 2], \
+                  _mm_shuffle_epi32(_mm_aeskeygenassist_si128((k)[(n) - 1], 0x00), 0xaa)))
+
+AESNI_TARGET static void SECURITY_APP_AesniKeySchedule(aesni_ctx_t *ctx, const uint8_t *key)
+{
+    __m128i *k = ctx->enc;
+    int round;
+
+    k[0] = _mm_loadu_si128((const __m128i *)key);
+    k[1] = _mm_loadu_si128((const __m128i *)(key + AES_BLOCK_SIZE));
+    AESNI_EXPAND_EVEN(k, 2, 0x01);
+    AESNI_EXPAND_ODD(k, 3);
+    AESNI_EXPAND_EVEN(k, 4, 0x02);
+    AESNI_EXPAND_ODD(k, 5);
+    AESNI_EXPAND_EVEN(k, 6, 0x04);
+    AESNI_EXPAND_ODD(k, 7);
+    AESNI_EXPAND_EVEN(k, 8, 0x08);
+    AESNI_EXPAND_ODD(k, 9);
+    AESNI_EXPAND_EVEN(k, 10, 0x10);
+    AESNI_EXPAND_ODD(k, 11);
+    AESNI_EXPAND_EVEN(k, 12, 0x20);
+    AESNI_EXPAND_ODD(k, 13);
+    AESNI_EXPAND_EVEN(k, 14, 0x40);
+
+    /* Equivalent inverse cipher: reversed order, inner keys through InvMixColumns */
+    ctx->dec[0] = k[AES256_ROUNDS];
+    for (round = 1; round < AES256_ROUNDS; round++) {
+        ctx->dec[round] = _mm_aesimc_si128(k[AES256_ROUNDS - round]);
+    }
+    ctx->dec[AES256_ROUNDS] = k[0];
+}
+
+/*
+** XMM kernels
+*/
+AESNI_TARGET static inline __m128i SECURITY_APP_AesniEncryptBlock(const __m128i *k, __m128i block)
+{
+    int round;
+
+    block = _mm_xor_si128(block, k[0]);
+    for (round = 1; round < AES256_ROUNDS; round++) {
+        block = _mm_aesenc_si128(block, k[round]);
+    }
+
+    return _mm_aesenclast_si128(block, k[AES256_ROUNDS]);
+}
+
+/*
+** CTR counter blocks are kept with the block number in native order, so
+** the next one is a single add, and byte-swapped into the big-endian
+** counter block as they are encrypted
+*/
+AESNI_TARGET static inline __m128i SECURITY_APP_AesniCounterBase(const aesni_ctx_t *ctx)
+{
+    return _mm_set_epi32((int)ctx->counter, (int)ctx->nonce[2], (int)ctx->nonce[1], (int)ctx->nonce[0]);
+}
+
+AESNI_TARGET static inline __m128i SECURITY_APP_AesniCounterSwap(void)
+{
+    return _mm_set_epi8(12, 13, 14, 15, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+}
+
+AESNI_TARGET static void SECURITY_APP_AesniCbcEncryptBlocks(aesni_ctx_t *ctx, uint8_t *out, const uint8_t *in,
+                                                            size_t blocks)
+{
+    __m128i chain = ctx->chain;
+    size_t i;
+
+    for (i = 0; i < blocks; i++) {
+        chain = _mm_xor_si128(chain, _mm_loadu_si128((const __m128i *)(in + i * AES_BLOCK_SIZE)));
+        chain = SECURITY_APP_AesniEncryptBlock(ctx->enc, chain);
+        _mm_storeu_si128((__m128i *)(out + i * AES_BLOCK_SIZE), chain);
+    }
+
+    ctx->chain = chain;
+}
+
+/*
+** Multi-buffer CBC encryption
+**
+** One message's chain is serial, but separate messages' chains are not: a
+** block of every lane goes through the rounds together, so up to eight
+** independent AES operations are in flight instead of one. The lanes run in
+** lockstep until the shortest message is done, which then drops out.
+*/
+typedef struct {
+    __m128i        chain;
+    const uint8_t *src;
+    const uint8_t *end;     /* End of the whole blocks, where src moves to last */
+    const uint8_t *last;
+    uint8_t       *dst;
+    size_t         left;    /* Blocks still to encrypt, last included */
+} aesni_lane_t;
+
+/* Inlined once per lane count so each lane's state stays in a register */
+AESNI_TARGET static inline __attribute__((always_inline)) void
+SECURITY_APP_AesniCbcMultiSteps(const __m128i *k, aesni_lane_t *lane, int lanes, size_t steps)
+{
+    __m128i state[AESNI_LANES];
+    size_t step;
+    int l;
+    int round;
+
+    for (step = 0; step < steps; step++) {
+        for (l = 0; l < lanes; l++) {
+            state[l] = _mm_xor_si128(lane[l].chain, _mm_loadu_si128((const __m128i *)lane[l].src));
+            state[l] = _mm_xor_si128(state[l], k[0]);
+        }
+        for (round = 1; round < AES256_ROUNDS; round++) {
+            for (l = 0; l < lanes; l++) {
+                state[l] = _mm_aesenc_si128(state[l], k[round]);
+            }
+        }
+        for (l = 0; l < lanes; l++) {
+            lane[l].chain = _mm_aesenclast_si128(state[l], k[AES256_ROUNDS]);
+            _mm_storeu_si128((__m128i *)lane[l].dst, lane[l].chain);
+            lane[l].dst += AES_BLOCK_SIZE;
+            lane[l].src += AES_BLOCK_SIZE;
+            if (lane[l].src == lane[l].end) {
+                lane[l].src = lane[l].last;
+            }
+        }
+    }
+}
+
+AESNI_TARGET static void SECURITY_APP_AesniCbcEncryptMulti(const __m128i *k, const security_app_lane_t *lanes,
+                                                           size_t count)
+{
+    aesni_lane_t lane[AESNI_LANES];
+    size_t steps;
+    size_t i;
+    int active = 0;
+    int l;
+
+    for (i = 0; i < count; i++) {
+        lane[active].left = lanes[i].blocks + (lanes[i].last != NULL);
+        if (lane[active].left == 0) {
+            continue;
+        }
+        lane[active].chain = _mm_loadu_si128((const __m128i *)lanes[i].iv);
+        lane[active].src = lanes[i].blocks > 0 ? lanes[i].in : lanes[i].last;
+        lane[active].end = lanes[i].in + lanes[i].blocks * AES_BLOCK_SIZE;
+        lane[active].last = lanes[i].last;
+        lane[active].dst = lanes[i].out;
+        active++;
+    }
+
+    while (active > 0) {
+        steps = lane[0].left;
+        for (l = 1; l < active; l++) {
+            if (lane[l].left < steps) {
+                steps = lane[l].left;
+            }
+        }
+
+        switch (active) {
+            case 8:  SECURITY_APP_AesniCbcMultiSteps(k, lane, 8, steps); break;
+            case 7:  SECURITY_APP_AesniCbcMultiSteps(k, lane, 7, steps); break;
+            case 6:  SECURITY_APP_AesniCbcMultiSteps(k, lane, 6, steps); break;
+            case 5:  SECURITY_APP_AesniCbcMultiSteps(k, lane, 5, steps); break;
+            case 4:  SECURITY_APP_AesniCbcMultiSteps(k, lane, 4, steps); break;
+            case 3:  SECURITY_APP_AesniCbcMultiSteps(k, lane, 3, steps); break;
+            case 2:  SECURITY_APP_AesniCbcMultiSteps(k, lane, 2, steps); break;
+            default: SECURITY_APP_AesniCbcMultiSteps(k, lane, 1, steps); break;
+        }
+
+        /* Drop the finished lanes by moving the last active lane into their place */
+        for (l = 0; l < active; l++) {
+            lane[l].left -= steps;
+        }
+        for (l = 0; l < active; ) {
+            if (lane[l].left == 0) {
+                lane[l] = lane[--active];
+            } else {
+                l++;
+            }
+        }
+    }
+}
+
+/* Every ciphertext block is read before its plaintext is stored, so out may equal in */
+AESNI_TARGET static void SECURITY_APP_AesniCbcDecryptBlocks(aesni_ctx_t *ctx, uint8_t *out, const uint8_t *in,
+                                                            size_t blocks)
+{
+    const __m128i *k = ctx->dec;
+    __m128i chain = ctx->chain;
+    __m128i cipher[AESNI_LANES];
+    __m128i state[AESNI_LANES];
+    int lane;
+    int round;
+
+    while (blocks >= AESNI_LANES) {
+        for (lane = 0; lane < AESNI_LANES; lane++) {
+            cipher[lane] = _mm_loadu_si128((const __m128i *)(in + lane * AES_BLOCK_SIZE));
+            state[lane] = _mm_xor_si128(cipher[lane], k[0]);
+        }
+        for (round = 1; round < AES256_ROUNDS; round++) {
+            for (lane = 0; lane < AESNI_LANES; lane++) {
+                state[lane] = _mm_aesdec_si128(state[lane], k[round]);
+            }
+        }
+        for (lane = 0; lane < AESNI_LANES; lane++) {
+            state[lane] = _mm_aesdeclast_si128(state[lane], k[AES256_ROUNDS]);
+            _mm_storeu_si128((__m128i *)(out + lane * AES_BLOCK_SIZE), _mm_xor_si128(state[lane], chain));
+            chain = cipher[lane];
+        }
+
+        in += AESNI_LANES * AES_BLOCK_SIZE;
+        out += AESNI_LANES * AES_BLOCK_SIZE;
+        blocks -= AESNI_LANES;
+    }
+
+    while (blocks > 0) {
+        cipher[0] = _mm_loadu_si128((const __m128i *)in);
+        state[0] = _mm_xor_si128(cipher[0], k[0]);
+        for (round = 1; round < AES256_ROUNDS; round++) {
+            state[0] = _mm_aesdec_si128(state[0], k[round]);
+        }
+        state[0] = _mm_aesdeclast_si128(state[0], k[AES256_ROUNDS]);
+        _mm_storeu_si128((__m128i *)out, _mm_xor_si128(state[0], chain));
+        chain = cipher[0];
+
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+        blocks--;
+    }
+
+    ctx->chain = chain;
+}
+
+/* Encryption and decryption are the same keystream XOR; a partial block ends the message */
+AESNI_TARGET static void SECURITY_APP_AesniCtr(aesni_ctx_t *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    const __m128i *k = ctx->enc;
+    const __m128i swap = SECURITY_APP_AesniCounterSwap();
+    const __m128i one = _mm_set_epi32(1, 0, 0, 0);
+    __m128i counter = SECURITY_APP_AesniCounterBase(ctx);
+    __m128i state[AESNI_LANES];
+    uint8_t keystream[AES_BLOCK_SIZE];
+    size_t i;
+    int lane;
+    int round;
+
+    while (len >= AESNI_LANES * AES_BLOCK_SIZE) {
+        for (lane = 0; lane < AESNI_LANES; lane++) {
+            state[lane] = _mm_xor_si128(_mm_shuffle_epi8(counter, swap), k[0]);
+            counter = _mm_add_epi32(counter, one);
+        }
+        for (round = 1; round < AES256_ROUNDS; round++) {
+            for (lane = 0; lane < AESNI_LANES; lane++) {
+                state[lane] = _mm_aesenc_si128(state[lane], k[round]);
+            }
+        }
+        for (lane = 0; lane < AESNI_LANES; lane++) {
+            state[lane] = _mm_aesenclast_si128(state[lane], k[AES256_ROUNDS]);
+            _mm_storeu_si128((__m128i *)(out + lane * AES_BLOCK_SIZE),
+                             _mm_xor_si128(state[lane],
+                                           _mm_loadu_si128((const __m128i *)(in + lane * AES_BLOCK_SIZE))));
+        }
+
+        ctx->counter += AESNI_LANES;
+        in += AESNI_LANES * AES_BLOCK_SIZE;
+        out += AESNI_LANES * AES_BLOCK_SIZE;
+        len -= AESNI_LANES * AES_BLOCK_SIZE;
+    }
+
+    while (len >= AES_BLOCK_SIZE) {
+        state[0] = SECURITY_APP_AesniEncryptBlock(k, _mm_shuffle_epi8(counter, swap));
+        counter = _mm_add_epi32(counter, one);
+        _mm_storeu_si128((__m128i *)out, _mm_xor_si128(state[0], _mm_loadu_si128((const __m128i *)in)));
+
+        ctx->counter++;
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+        len -= AES_BLOCK_SIZE;
+    }
+
+    if (len > 0) {
+        state[0] = SECURITY_APP_AesniEncryptBlock(k, _mm_shuffle_epi8(counter, swap));
+        _mm_storeu_si128((__m128i *)keystream, state[0]);
+        for (i = 0; i < len; i++) {
+            out[i] = in[i] ^ keystream[i];
+        }
+        ctx->counter++;
+    }
+}
+
+/*
+** YMM kernels: two blocks per register, eight registers in flight
+*/
+VAES_TARGET static void SECURITY_APP_VaesBroadcast(const __m128i *k, __m256i *k256)
+{
+    int round;
+
+    for (round = 0; round <= AES256_ROUNDS; round++) {
+        k256[round] = _mm256_broadcastsi128_si256(k[round]);
+    }
+}
+
+VAES_TARGET static void SECURITY_APP_VaesCtr(aesni_ctx_t *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    const __m256i swap = _mm256_broadcastsi128_si256(SECURITY_APP_AesniCounterSwap());
+    const __m256i two = _mm256_set_epi32(2, 0, 0, 0, 2, 0, 0, 0);
+    __m256i k[AES256_ROUNDS + 1];
+    __m256i counter;
+    __m256i state[VAES_LANES / 2];
+    __m128i base;
+    int lane;
+    int round;
+
+    if (len < VAES_LANES * AES_BLOCK_SIZE) {
+        SECURITY_APP_AesniCtr(ctx, out, in, len);
+        return;
+    }
+
+    SECURITY_APP_VaesBroadcast(ctx->enc, k);
+    base = SECURITY_APP_AesniCounterBase(ctx);
+    counter = _mm256_set_m128i(_mm_add_epi32(base, _mm_set_epi32(1, 0, 0, 0)), base);
+
+    while (len >= VAES_LANES * AES_BLOCK_SIZE) {
+        for (lane = 0; lane < VAES_LANES / 2; lane++) {
+            state[lane] = _mm256_xor_si256(_mm256_shuffle_epi8(counter, swap), k[0]);
+            counter = _mm256_add_epi32(counter, two);
+        }
+        for (round = 1; round < AES256_ROUNDS; round++) {
+            for (lane = 0; lane < VAES_LANES / 2; lane++) {
+                state[lane] = _mm256_aesenc_epi128(state[lane], k[round]);
+            }
+        }
+        for (lane = 0; lane < VAES_LANES / 2; lane++) {
+            state[lane] = _mm256_aesenclast_epi128(state[lane], k[AES256_ROUNDS]);
+            _mm256_storeu_si256((__m256i *)(out + lane * 2 * AES_BLOCK_SIZE),
+                                _mm256_xor_si256(state[lane],
+                                                 _mm256_loadu_si256((const __m256i *)(in + lane * 2 * AES_BLOCK_SIZE))));
+        }
+
+        ctx->counter += VAES_LANES;
+        in += VAES_LANES * AES_BLOCK_SIZE;
+        out += VAES_LANES * AES_BLOCK_SIZE;
+        len -= VAES_LANES * AES_BLOCK_SIZE;
+    }
+
+    SECURITY_APP_AesniCtr(ctx, out, in, len);
+}
+
+VAES_TARGET static void SECURITY_APP_VaesCbcDecryptBlocks(aesni_ctx_t *ctx, uint8_t *out, const uint8_t *in,
+                                                          size_t blocks)
+{
+    __m256i k[AES256_ROUNDS + 1];
+    __m256i cipher[VAES_LANES / 2];
+    __m256i chain[VAES_LANES / 2];
+    __m256i state[VAES_LANES / 2];
+    int lane;
+    int round;
+
+    if (blocks >= VAES_LANES) {
+        SECURITY_APP_VaesBroadcast(ctx->dec, k);
+    }
+
+    while (blocks >= VAES_LANES) {
+        /* Each pair of blocks is chained to the pair shifted back by one block */
+        chain[0] = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)in), ctx->chain);
+        for (lane = 0; lane < VAES_LANES / 2; lane++) {
+            cipher[lane] = _mm256_loadu_si256((const __m256i *)(in + lane * 2 * AES_BLOCK_SIZE));
+            if (lane > 0) {
+                chain[lane] = _mm256_loadu_si256((const __m256i *)(in + (lane * 2 - 1) * AES_BLOCK_SIZE));
+            }
+            state[lane] = _mm256_xor_si256(cipher[lane], k[0]);
+        }
+        ctx->chain = _mm256_extracti128_si256(cipher[VAES_LANES / 2 - 1], 1);
+
+        for (round = 1; round < AES256_ROUNDS; round++) {
+            for (lane = 0; lane < VAES_LANES / 2; lane++) {
+                state[lane] = _mm256_aesdec_epi128(state[lane], k[round]);
+            }
+        }
+        for (lane = 0; lane < VAES_LANES / 2; lane++) {
+            state[lane] = _mm256_aesdeclast_epi128(state[lane], k[AES256_ROUNDS]);
+            _mm256_storeu_si256((__m256i *)(out + lane * 2 * AES_BLOCK_SIZE),
+                                _mm256_xor_si256(state[lane], chain[lane]));
+        }
+
+        in += VAES_LANES * AES_BLOCK_SIZE;
+        out += VAES_LANES * AES_BLOCK_SIZE;
+        blocks -= VAES_LANES;
+    }
+
+    SECURITY_APP_AesniCbcDecryptBlocks(ctx, out, in, blocks);
+}
+
+/*
+** Provider functions
+*/
+static void SECURITY_APP_AesniClose(void *ctx)
+{
+    aesni_ctx_t *actx = ctx;
+
+    /* Do not leave the key schedule behind in memory */
+    memset(actx, 0, sizeof(*actx));
+    __atomic_store_n(&aesni_in_use[actx - aesni_ctx], 0, __ATOMIC_RELEASE);
+}
+
+static void *SECURITY_APP_AesniOpen(uint8_t suite, const uint8_t *key)
+{
+    aesni_ctx_t *actx;
+    int index;
+
+    if (!SECURITY_APP_AesniSupports(suite)) {
+        return NULL;
+    }
+
+    index = SECURITY_APP_ClaimContext(aesni_in_use, SECURITY_APP_PROVIDER_CONTEXTS);
+    if (index < 0) {
+        return NULL;
+    }
+    actx = &aesni_ctx[index];
+
+    SECURITY_APP_AesniKeySchedule(actx, key);
+    actx->suite = suite;
+
+    return actx;
+}
+
+static int SECURITY_APP_AesniStart(void *ctx, const uint8_t *iv)
+{
+    aesni_ctx_t *actx = ctx;
+
+    if (actx->suite == SECURITY_APP_SUITE_AES256_CBC) {
+        memcpy(&actx->chain, iv, AES_BLOCK_SIZE);
+    } else {
+        /* 96-bit nonce followed by a 32-bit block counter starting at zero */
+        memcpy(actx->nonce, iv, sizeof(actx->nonce));
+        actx->counter = 0;
+    }
+
+    return 0;
+}
+
+static int SECURITY_APP_AesniEncrypt(void *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    aesni_ctx_t *actx = ctx;
+
+    if (actx->suite == SECURITY_APP_SUITE_AES256_CBC) {
+        if (len % AES_BLOCK_SIZE != 0) {
+            return -1;
+        }
+        SECURITY_APP_AesniCbcEncryptBlocks(actx, out, in, len / AES_BLOCK_SIZE);
+    } else {
+        SECURITY_APP_AesniCtr(actx, out, in, len);
+    }
+
+    return 0;
+}
+
+static int SECURITY_APP_AesniDecrypt(void *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    aesni_ctx_t *actx = ctx;
+
+    if (actx->suite == SECURITY_APP_SUITE_AES256_CBC) {
+        if (len % AES_BLOCK_SIZE != 0) {
+            return -1;
+        }
+        SECURITY_APP_AesniCbcDecryptBlocks(actx, out, in, len / AES_BLOCK_SIZE);
+    } else {
+        SECURITY_APP_AesniCtr(actx, out, in, len);
+    }
+
+    return 0;
+}
+
+static int SECURITY_APP_VaesEncrypt(void *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    aesni_ctx_t *actx = ctx;
+
+    /* CBC encryption cannot run blocks in parallel */
+    if (actx->suite == SECURITY_APP_SUITE_AES256_CBC) {
+        return SECURITY_APP_AesniEncrypt(ctx, out, in, len);
+    }
+
+    SECURITY_APP_VaesCtr(actx, out, in, len);
+
+    return 0;
+}
+
+static int SECURITY_APP_VaesDecrypt(void *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    aesni_ctx_t *actx = ctx;
+
+    if (actx->suite == SECURITY_APP_SUITE_AES256_CBC) {
+        if (len % AES_BLOCK_SIZE != 0) {
+            return -1;
+        }
+        SECURITY_APP_VaesCbcDecryptBlocks(actx, out, in, len / AES_BLOCK_SIZE);
+    } else {
+        SECURITY_APP_VaesCtr(actx, out, in, len);
+    }
+
+    return 0;
+}
+
+/* The same XMM kernel serves both providers: eight lanes already fill the AES units */
+static int SECURITY_APP_AesniEncryptMulti(void *ctx, const security_app_lane_t *lanes, size_t count)
+{
+    aesni_ctx_t *actx = ctx;
+
+    if (actx->suite != SECURITY_APP_SUITE_AES256_CBC || count > AESNI_LANES) {
+        return -1;
+    }
+
+    SECURITY_APP_AesniCbcEncryptMulti(actx->enc, lanes, count);
+
+    return 0;
+}
+
+/* Neither mode carries a tag */
+static int SECURITY_APP_AesniNoTag(void *ctx, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    (void)data;
+    (void)len;
+
+    return -1;
+}
+
+static int SECURITY_APP_AesniGetTag(void *ctx, uint8_t *tag, size_t len)
+{
+    return SECURITY_APP_AesniNoTag(ctx, tag, len);
+}
+
+/* RDRAND, retried as Intel recommends before the generator is taken as failed */
+RDRAND_TARGET static int SECURITY_APP_AesniRandom(uint8_t *buf, size_t len)
+{
+    unsigned int word;
+    size_t chunk;
+    int retry;
+
+    if (!aesni_has_rdrand) {
+        return -1;
+    }
+
+    while (len > 0) {
+        for (retry = 0; retry < 10; retry++) {
+            if (_rdrand32_step(&word)) {
+                break;
+            }
+        }
+        if (retry == 10) {
+            return -1;
+        }
+
+        chunk = len < sizeof(word) ? len : sizeof(word);
+        memcpy(buf, &word, chunk);
+        buf += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+const security_app_provider_t SECURITY_APP_AesniProvider = {
+    "aesni",
+    SECURITY_APP_PROVIDER_AESNI,
+    SECURITY_APP_AesniAvailable,
+    SECURITY_APP_AesniInit,
+    SECURITY_APP_AesniSupports,
+    SECURITY_APP_AesniOpen,
+    SECURITY_APP_AesniClose,
+    SECURITY_APP_AesniStart,
+    SECURITY_APP_AesniEncrypt,
+    SECURITY_APP_AesniDecrypt,
+    SECURITY_APP_AesniNoTag,
+    SECURITY_APP_AesniGetTag,
+    SECURITY_APP_AesniNoTag,
+    SECURITY_APP_AesniRandom,
+    SECURITY_APP_AesniEncryptMulti,
+};
+
+const security_app_provider_t SECURITY_APP_VaesProvider = {
+    "vaes",
+    SECURITY_APP_PROVIDER_VAES,
+    SECURITY_APP_VaesAvailable,
+    SECURITY_APP_AesniInit,
+    SECURITY_APP_AesniSupports,
+    SECURITY_APP_AesniOpen,
+    SECURITY_APP_AesniClose,
+    SECURITY_APP_AesniStart,
+    SECURITY_APP_VaesEncrypt,
+    SECURITY_APP_VaesDecrypt,
+    SECURITY_APP_AesniNoTag,
+    SECURITY_APP_AesniGetTag,
+    SECURITY_APP_AesniNoTag,
+    SECURITY_APP_AesniRandom,
+    SECURITY_APP_AesniEncryptMulti,
+};
+
+#endif /* SECURITY_APP_HAVE_AESNI */
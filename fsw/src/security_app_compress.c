@@ -0,0 +1,216 @@
+#include "security_app_compress.h"
+#include "security_app_crypto.h"
+#include <string.h>
+
+/*
+** LZ4 block format: each sequence is a token (literal count in the high
+** nibble, match length - 4 in the low nibble, 15 meaning more length bytes
+** follow), the literals, a 16-bit little-endian match offset and any extra
+** match length bytes. The last sequence is literals only. Matches never
+** start in the last LZ_MFLIMIT bytes or reach into the last
+** LZ_LAST_LITERALS bytes, as the format requires.
+*/
+#define LZ_MIN_MATCH        4
+#define LZ_LAST_LITERALS    5
+#define LZ_MFLIMIT          12
+#define LZ_MAX_OFFSET       0xFFFF
+#define LZ_HASH_BITS        12
+#define LZ_RUN_MASK         15
+
+/*
+** Match tables hold the last input position seen for each hash. They are
+** never cleared: a stale position from an earlier message is just a
+** candidate whose bytes fail to match.
+*/
+static uint16_t lz_table[SECURITY_APP_CRYPTO_CHANNELS][1 << LZ_HASH_BITS];
+
+static uint32_t lz_read32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t lz_hash(const uint8_t *p)
+{
+    return (lz_read32(p) * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/* Write a length continuation: runs of 255 then the remainder */
+static uint8_t *lz_put_length(uint8_t *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* Emit one sequence; match_len 0 marks the final literals-only sequence */
+static uint8_t *lz_put_sequence(uint8_t *op, const uint8_t *oend, const uint8_t *literals,
+                                size_t literal_len, size_t offset, size_t match_len)
+{
+    size_t code = (match_len > 0) ? match_len - LZ_MIN_MATCH : 0;
+    uint8_t *token;
+
+    /* Worst case size of this sequence */
+    if ((size_t)(oend - op) < 1 + literal_len + literal_len / 255 + 1 + 2 + code / 255 + 1) {
+        return NULL;
+    }
+
+    token = op++;
+    *token = (uint8_t)((literal_len < LZ_RUN_MASK ? literal_len : LZ_RUN_MASK) << 4);
+    if (literal_len >= LZ_RUN_MASK) {
+        op = lz_put_length(op, literal_len - LZ_RUN_MASK);
+    }
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+
+    if (match_len == 0) {
+        return op;
+    }
+
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    *token |= (uint8_t)(code < LZ_RUN_MASK ? code : LZ_RUN_MASK);
+    if (code >= LZ_RUN_MASK) {
+        op = lz_put_length(op, code - LZ_RUN_MASK);
+    }
+
+    return op;
+}
+
+size_t SECURITY_APP_Compress(uint8_t channel, const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap)
+{
+    uint16_t *table;
+    const uint8_t *ip = in;
+    const uint8_t *anchor = in;
+    const uint8_t *iend = in + in_len;
+    const uint8_t *ref;
+    const uint8_t *oend = out + out_cap;
+    uint8_t *op = out;
+    size_t match_len;
+    uint32_t h;
+
+    if (in == NULL || out == NULL || channel >= SECURITY_APP_CRYPTO_CHANNELS || in_len > LZ_MAX_OFFSET) {
+        return 0;
+    }
+
+    table = lz_table[channel];
+
+    if (in_len >= LZ_MFLIMIT) {
+        while (ip < iend - LZ_MFLIMIT) {
+            h = lz_hash(ip);
+            ref = in + table[h];
+            table[h] = (uint16_t)(ip - in);
+
+            if (ref >= ip || lz_read32(ref) != lz_read32(ip)) {
+                ip++;
+                continue;
+            }
+
+            match_len = LZ_MIN_MATCH;
+            while (ip + match_len < iend - LZ_LAST_LITERALS && ref[match_len] == ip[match_len]) {
+                match_len++;
+            }
+
+            op = lz_put_sequence(op, oend, anchor, ip - anchor, ip - ref, match_len);
+            if (op == NULL) {
+                return 0;
+            }
+
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+
+    op = lz_put_sequence(op, oend, anchor, iend - anchor, 0, 0);
+    if (op == NULL) {
+        return 0;
+    }
+
+    return op - out;
+}
+
+/* Read a length continuation; returns -1 if the input ends inside it */
+static int32_t lz_get_length(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+    uint8_t b;
+
+    do {
+        if (*ip >= iend) {
+            return -1;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+
+    return 0;
+}
+
+int32_t SECURITY_APP_Decompress(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_len)
+{
+    const uint8_t *ip = in;
+    const uint8_t *iend = in + in_len;
+    const uint8_t *match;
+    uint8_t *op = out;
+    uint8_t *oend = out + out_len;
+    size_t offset;
+    size_t len;
+    uint8_t token;
+
+    if (in == NULL || out == NULL) {
+        return -1;
+    }
+
+    while (op < oend) {
+        if (ip >= iend) {
+            return -1;
+        }
+        token = *ip++;
+
+        len = token >> 4;
+        if (len == LZ_RUN_MASK && lz_get_length(&ip, iend, &len) != 0) {
+            return -1;
+        }
+        if (len > (size_t)(iend - ip) || len > (size_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+
+        /* The last sequence ends on the last output byte */
+        if (op == oend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - out)) {
+            return -1;
+        }
+
+        len = token & LZ_RUN_MASK;
+        if (len == LZ_RUN_MASK && lz_get_length(&ip, iend, &len) != 0) {
+            return -1;
+        }
+        len += LZ_MIN_MATCH;
+        if (len > (size_t)(oend - op)) {
+            return -1;
+        }
+
+        /* Byte at a time: a match may overlap the bytes it produces */
+        match = op - offset;
+        while (len-- > 0) {
+            *op++ = *match++;
+        }
+    }
+
+    return 0;
+}
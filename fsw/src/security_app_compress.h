@@ -0,0 +1,26 @@
+#ifndef SECURITY_APP_COMPRESS_H
+#define SECURITY_APP_COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+** Lossless pre-encryption compression
+**
+** A greedy LZ77 codec producing LZ4 block format, so ground tools can
+** decode it with any LZ4 block decoder. Each crypto channel has its own
+** preallocated match table; nothing is allocated per call.
+**
+** SECURITY_APP_Compress returns the compressed length, or 0 if the output
+** would not fit in out_cap (the caller then sends the data raw). Inputs are
+** limited to 64 KB.
+**
+** SECURITY_APP_Decompress expands exactly out_len bytes and ignores any
+** input left over after them (CBC padding); it returns -1 on malformed input
+** without ever reading or writing outside the buffers.
+*/
+size_t SECURITY_APP_Compress(uint8_t channel, const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap);
+
+int32_t SECURITY_APP_Decompress(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_len);
+
+#endif /* SECURITY_APP_COMPRESS_H */
@@ -1,152 +1,962 @@
 #include "security_app_crypto.h"
+#include "security_app_platform_cfg.h"
+#include "security_app_provider.h"
 #include <string.h>
-#include <gcrypt.h>
 
 #define AES_BLOCK_SIZE 16
-#define AES_KEY_SIZE 32  // AES-256 key size in bytes
-
-/* Hardcoded encryption key (32 bytes for AES-256) */
-static const unsigned char hardcoded_key[AES_KEY_SIZE] = {
-    0x4d, 0x79, 0x53, 0x65, 0x63, 0x72, 0x65, 0x74, 
-    0x41, 0x45, 0x53, 0x32, 0x35, 0x36, 0x45, 0x6e,
-    0x63, 0x72, 0x79, 0x70, 0x74, 0x69, 0x6f, 0x6e, 
-    0x4b, 0x65, 0x79, 0x32, 0x30, 0x32, 0x35, 0x21
+
+/*
+** Per-suite cipher parameters. The ciphers themselves are behind the
+** provider selected for the suite (security_app_provider.h).
+*/
+typedef struct {
+    int    cbc;         /* Zero-padded block mode; IVs must be unpredictable */
+    size_t nonce_len;   /* Bytes of the IV field used as nonce */
+    size_t tag_len;     /* Authentication tag appended to the ciphertext */
+    int    auth_only;   /* Data is only authenticated, never enciphered */
+} suite_info_t;
+
+static const suite_info_t suite_table[SECURITY_APP_SUITE_COUNT] = {
+    [SECURITY_APP_SUITE_AES256_CBC]        = { 1, 12, 0,  0 },
+    [SECURITY_APP_SUITE_AES256_CTR]        = { 0, 12, 0,  0 },
+    [SECURITY_APP_SUITE_AES256_GCM]        = { 0, 12, 16, 0 },
+    [SECURITY_APP_SUITE_CHACHA20_POLY1305] = { 0, 12, 16, 0 },
+    /* Authenticate-only: the AEAD suites above with all data fed as associated data */
+    [SECURITY_APP_SUITE_AES256_GMAC]       = { 0, 12, 16, 1 },
+    [SECURITY_APP_SUITE_POLY1305]          = { 0, 12, 16, 1 },
 };
 
-int32_t SECURITY_APP_InitCrypto(void)
+/*
+** Key slots
+**
+** Each key ID has two banks of key material and cipher contexts. state is
+** 0 while the slot is empty and 1 + bank for the bank in service; it is the
+** only field the hot path reads to pick a bank. bank is the loader's record
+** of the last bank it filled.
+*/
+#define KEY_STATE_EMPTY     0
+#define KEY_HAZARD_NONE     0
+#define KEY_HAZARD(key, bank)   (1 + (uint32_t)(key) * 2 + (bank))
+
+typedef struct {
+    uint8_t state;
+    uint8_t bank;
+    uint8_t material[2][SECURITY_APP_KEY_SIZE];
+} key_slot_t;
+
+static key_slot_t key_slot[SECURITY_APP_MAX_KEYS];
+
+/*
+** Each channel publishes the key bank it is using, if any, for the length
+** of one operation. The loader will not overwrite a bank a channel has
+** published, so an in-flight operation always finishes on the key it
+** started with.
+*/
+typedef struct {
+    uint32_t slot __attribute__((aligned(64)));
+} key_hazard_t;
+
+static key_hazard_t key_hazard[SECURITY_APP_CRYPTO_CHANNELS];
+
+/*
+** Long-lived cipher contexts, one pair per suite for each channel, key and
+** bank. A channel belongs to exactly one task, so contexts are never shared
+** between tasks. The key schedule is expanded once when a pair is opened;
+** the per-message path only resets the IV.
+*/
+typedef struct {
+    void    *encrypt[SECURITY_APP_SUITE_COUNT];
+    void    *decrypt[SECURITY_APP_SUITE_COUNT];
+    uint8_t  valid[SECURITY_APP_SUITE_COUNT];
+} key_contexts_t;
+
+static key_contexts_t contexts[SECURITY_APP_CRYPTO_CHANNELS][SECURITY_APP_MAX_KEYS][2];
+
+static void SECURITY_APP_CloseContexts(key_contexts_t *ctx, uint8_t suite)
+{
+    const security_app_provider_t *p = SECURITY_APP_SuiteProvider(suite);
+
+    if (ctx->valid[suite]) {
+        p->close(ctx->encrypt[suite]);
+        p->close(ctx->decrypt[suite]);
+        ctx->valid[suite] = 0;
+    }
+}
+
+static int32_t SECURITY_APP_OpenContexts(key_contexts_t *ctx, uint8_t suite, const uint8_t *key)
+{
+    const security_app_provider_t *p = SECURITY_APP_SuiteProvider(suite);
+
+    /* A suite no provider passed the self-test for cannot be used */
+    if (p == NULL) {
+        return -2;
+    }
+
+    /* Expand the key schedule once for each direction */
+    ctx->encrypt[suite] = p->open(suite, key);
+    if (ctx->encrypt[suite] == NULL) {
+        return -3;
+    }
+
+    ctx->decrypt[suite] = p->open(suite, key);
+    if (ctx->decrypt[suite] == NULL) {
+        p->close(ctx->encrypt[suite]);
+        return -3;
+    }
+
+    ctx->valid[suite] = 1;
+
+    return 0;
+}
+
+/*
+** Pin the bank in service for a key on a channel. The bank is re-read after
+** the hazard is published, so the loader either sees the hazard or the
+** channel sees the new bank.
+*/
+static int32_t SECURITY_APP_AcquireKey(uint8_t channel, uint8_t key, uint8_t *bank)
+{
+    uint8_t state;
+
+    if (key >= SECURITY_APP_MAX_KEYS) {
+        return -8;
+    }
+
+    do {
+        state = __atomic_load_n(&key_slot[key].state, __ATOMIC_ACQUIRE);
+        if (state == KEY_STATE_EMPTY) {
+            __atomic_store_n(&key_hazard[channel].slot, KEY_HAZARD_NONE, __ATOMIC_RELEASE);
+            return -8;
+        }
+        __atomic_store_n(&key_hazard[channel].slot, KEY_HAZARD(key, state - 1), __ATOMIC_SEQ_CST);
+    } while (__atomic_load_n(&key_slot[key].state, __ATOMIC_SEQ_CST) != state);
+
+    *bank = state - 1;
+
+    return 0;
+}
+
+static void SECURITY_APP_ReleaseKey(uint8_t channel)
+{
+    __atomic_store_n(&key_hazard[channel].slot, KEY_HAZARD_NONE, __ATOMIC_RELEASE);
+}
+
+/* Get a channel's contexts for a pinned key bank, reopening them after a failure */
+static key_contexts_t *SECURITY_APP_GetContexts(uint8_t channel, uint8_t key, uint8_t bank, uint8_t suite)
+{
+    key_contexts_t *ctx = &contexts[channel][key][bank];
+
+    if (!ctx->valid[suite] && SECURITY_APP_OpenContexts(ctx, suite, key_slot[key].material[bank]) != 0) {
+        return NULL;
+    }
+
+    return ctx;
+}
+
+int32_t SECURITY_APP_LoadKey(uint8_t key, const uint8_t *material)
 {
-    /* Initialize libgcrypt */
-    if (!gcry_check_version(GCRYPT_VERSION)) {
+    key_slot_t *slot;
+    uint8_t standby;
+    uint8_t channel;
+    uint8_t suite;
+    int32_t status;
+
+    if (key >= SECURITY_APP_MAX_KEYS || material == NULL) {
         return -1;
     }
-    
-    gcry_control(GCRYCTL_DISABLE_SECMEM, 0);
-    gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
-    
+
+    slot = &key_slot[key];
+    standby = slot->bank ^ 1;
+
+    /* A channel may still be finishing on the bank that is about to be reused */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (channel = 0; channel < SECURITY_APP_CRYPTO_CHANNELS; channel++) {
+        if (__atomic_load_n(&key_hazard[channel].slot, __ATOMIC_SEQ_CST) == KEY_HAZARD(key, standby)) {
+            return -9;
+        }
+    }
+
+    /* Expand the new key for every channel and suite while the old one serves traffic */
+    memcpy(slot->material[standby], material, SECURITY_APP_KEY_SIZE);
+    for (channel = 0; channel < SECURITY_APP_CRYPTO_CHANNELS; channel++) {
+        for (suite = 0; suite < SECURITY_APP_SUITE_COUNT; suite++) {
+            key_contexts_t *ctx = &contexts[channel][key][standby];
+
+            if (SECURITY_APP_SuiteProvider(suite) == NULL) {
+                continue;
+            }
+
+            SECURITY_APP_CloseContexts(ctx, suite);
+            status = SECURITY_APP_OpenContexts(ctx, suite, slot->material[standby]);
+            if (status != 0) {
+                return status;
+            }
+        }
+    }
+
+    /* Switch over in one store */
+    slot->bank = standby;
+    __atomic_store_n(&slot->state, standby + 1, __ATOMIC_SEQ_CST);
+
     return 0;
 }
 
-int32_t SECURITY_APP_Encrypt(const uint8_t *plaintext, size_t plaintext_len,
-                            uint8_t *iv, uint8_t *ciphertext, size_t *ciphertext_len)
+void SECURITY_APP_UnloadKey(uint8_t key)
 {
-    gcry_cipher_hd_t cipher_handle;
-    gcry_error_t err;
-    
-    /* Parameter check */
-    if (plaintext == NULL || iv == NULL || ciphertext == NULL || ciphertext_len == NULL) {
+    if (key < SECURITY_APP_MAX_KEYS) {
+        __atomic_store_n(&key_slot[key].state, KEY_STATE_EMPTY, __ATOMIC_SEQ_CST);
+    }
+}
+
+int SECURITY_APP_KeyLoaded(uint8_t key)
+{
+    return key < SECURITY_APP_MAX_KEYS &&
+           __atomic_load_n(&key_slot[key].state, __ATOMIC_ACQUIRE) != KEY_STATE_EMPTY;
+}
+
+/* Whether the key in service for an ID is this one (loading task only) */
+int SECURITY_APP_KeyMatches(uint8_t key, const uint8_t *material)
+{
+    return key < SECURITY_APP_MAX_KEYS &&
+           memcmp(key_slot[key].material[key_slot[key].bank], material, SECURITY_APP_KEY_SIZE) == 0;
+}
+
+/*
+** Nonce supply
+**
+** Every channel has its own ring of pre-generated random IVs. The channel's
+** task is the only consumer and SECURITY_APP_NonceRefill the only producer,
+** so the ring needs no locks. An empty ring falls back to generating the IV
+** inline and counts an underflow.
+**
+** With SECURITY_APP_COUNTER_NONCES the counter-based suites instead use a
+** deterministic nonce: a per-channel salt, the channel number and a
+** per-channel message counter, with no random generation on the hot path.
+** That is only unique per key if no counter value is ever used twice under
+** the same salt, restarts included, so it needs the nonce store set with
+** SECURITY_APP_SetNonceStore. Counter values are reserved
+** SECURITY_APP_NONCE_RESERVE at a time and each reservation is stored with
+** the salt before any value in it is used; SECURITY_APP_RestoreNonce
+** resumes a channel after its stored reservation. With no store, or once a
+** store call fails, the channel takes pool IVs like CBC does. CBC always
+** takes pool IVs because its IVs must be unpredictable.
+*/
+#define NONCE_SALT_SIZE     SECURITY_APP_NONCE_SALT_SIZE
+#define NONCE_COUNTER_MAX   0xFFFFFFFFFFFFULL   /* 48-bit invocation field */
+
+typedef struct {
+    uint32_t head __attribute__((aligned(64)));    /* Written by the refill side */
+    uint32_t tail __attribute__((aligned(64)));    /* Written by the channel's task */
+    uint8_t  iv[SECURITY_APP_NONCE_POOL_DEPTH][AES_BLOCK_SIZE];
+    uint8_t  salt[NONCE_SALT_SIZE];
+    uint64_t counter;
+    uint64_t limit;                                 /* Highest counter value stored */
+    uint32_t refills;
+    uint32_t underflows;
+} nonce_ring_t;
+
+static nonce_ring_t nonce_ring[SECURITY_APP_CRYPTO_CHANNELS];
+static void (*nonce_low_callback)(void);
+static security_app_nonce_store_t nonce_store;
+
+void SECURITY_APP_NonceRefill(void)
+{
+    uint8_t channel;
+
+    for (channel = 0; channel < SECURITY_APP_CRYPTO_CHANNELS; channel++) {
+        nonce_ring_t *ring = &nonce_ring[channel];
+        uint32_t head = ring->head;
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        uint32_t space = SECURITY_APP_NONCE_POOL_DEPTH - (head - tail);
+        uint32_t index = head % SECURITY_APP_NONCE_POOL_DEPTH;
+
+        if (space == 0) {
+            continue;
+        }
+
+        /* Fill up to the end of the array in one call, then wrap; nothing is published on failure */
+        if (index + space > SECURITY_APP_NONCE_POOL_DEPTH) {
+            if (SECURITY_APP_Random(ring->iv[index], (SECURITY_APP_NONCE_POOL_DEPTH - index) * AES_BLOCK_SIZE) != 0 ||
+                SECURITY_APP_Random(ring->iv[0],
+                                    (index + space - SECURITY_APP_NONCE_POOL_DEPTH) * AES_BLOCK_SIZE) != 0) {
+                continue;
+            }
+        } else if (SECURITY_APP_Random(ring->iv[index], space * AES_BLOCK_SIZE) != 0) {
+            continue;
+        }
+
+        __atomic_store_n(&ring->head, head + space, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&ring->refills, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void SECURITY_APP_SetNonceLowCallback(void (*callback)(void))
+{
+    nonce_low_callback = callback;
+}
+
+void SECURITY_APP_SetNonceStore(security_app_nonce_store_t store)
+{
+    __atomic_store_n(&nonce_store, store, __ATOMIC_RELEASE);
+}
+
+void SECURITY_APP_RestoreNonce(uint8_t channel, const uint8_t *salt, uint64_t limit)
+{
+    if (channel < SECURITY_APP_CRYPTO_CHANNELS && limit <= NONCE_COUNTER_MAX) {
+        memcpy(nonce_ring[channel].salt, salt, NONCE_SALT_SIZE);
+        nonce_ring[channel].counter = limit;
+        nonce_ring[channel].limit = limit;
+    }
+}
+
+void SECURITY_APP_GetNonceStats(uint32_t *refills, uint32_t *underflows)
+{
+    uint8_t channel;
+
+    *refills = 0;
+    *underflows = 0;
+    for (channel = 0; channel < SECURITY_APP_CRYPTO_CHANNELS; channel++) {
+        *refills += __atomic_load_n(&nonce_ring[channel].refills, __ATOMIC_RELAXED);
+        *underflows += __atomic_load_n(&nonce_ring[channel].underflows, __ATOMIC_RELAXED);
+    }
+}
+
+void SECURITY_APP_ResetNonceStats(void)
+{
+    uint8_t channel;
+
+    for (channel = 0; channel < SECURITY_APP_CRYPTO_CHANNELS; channel++) {
+        __atomic_store_n(&nonce_ring[channel].refills, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&nonce_ring[channel].underflows, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* Produce the IV field for one message on a channel; fails only if no random bytes can be had */
+static int32_t SECURITY_APP_NextNonce(uint8_t channel, uint8_t suite, uint8_t *iv)
+{
+    const suite_info_t *info = &suite_table[suite];
+    nonce_ring_t *ring = &nonce_ring[channel];
+    security_app_nonce_store_t store = __atomic_load_n(&nonce_store, __ATOMIC_ACQUIRE);
+    uint32_t tail;
+    uint32_t level;
+    uint64_t counter;
+    int i;
+
+    memset(iv, 0, SECURITY_APP_IV_SIZE);
+
+#if (SECURITY_APP_COUNTER_NONCES == 1)
+    if (!info->cbc && store != NULL) {
+        /* salt | channel | 48-bit big-endian counter */
+        if (ring->counter >= NONCE_COUNTER_MAX) {
+            if (SECURITY_APP_Random(ring->salt, NONCE_SALT_SIZE) != 0) {
+                return -1;
+            }
+            ring->counter = 0;
+            ring->limit = 0;
+        }
+        counter = ring->counter + 1;
+
+        /* Store the next reservation before using anything in it */
+        if (counter > ring->limit) {
+            ring->limit = (counter > NONCE_COUNTER_MAX - SECURITY_APP_NONCE_RESERVE) ?
+                          NONCE_COUNTER_MAX : counter + SECURITY_APP_NONCE_RESERVE - 1;
+            if (store(channel, ring->salt, ring->limit) != 0) {
+                SECURITY_APP_SetNonceStore(NULL);
+                return SECURITY_APP_NextNonce(channel, suite, iv);
+            }
+        }
+        ring->counter = counter;
+
+        memcpy(iv, ring->salt, NONCE_SALT_SIZE);
+        iv[NONCE_SALT_SIZE] = channel;
+        for (i = 0; i < 6; i++) {
+            iv[NONCE_SALT_SIZE + 1 + i] = (uint8_t)(counter >> (8 * (5 - i)));
+        }
+        return 0;
+    }
+#else
+    (void)store;
+    (void)counter;
+    (void)i;
+#endif
+
+    tail = ring->tail;
+    level = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+
+    if (level == 0) {
+        __atomic_fetch_add(&ring->underflows, 1, __ATOMIC_RELAXED);
+        if (SECURITY_APP_Random(iv, info->nonce_len) != 0) {
+            return -1;
+        }
+    } else {
+        memcpy(iv, ring->iv[tail % SECURITY_APP_NONCE_POOL_DEPTH], info->nonce_len);
+        __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+        level--;
+    }
+
+    if (level <= SECURITY_APP_NONCE_LOW_WATER && nonce_low_callback != NULL) {
+        nonce_low_callback();
+    }
+
+    return 0;
+}
+
+int32_t SECURITY_APP_InitCrypto(void)
+{
+    uint8_t channel;
+
+    /* Pick and self-test a provider for every suite */
+    if (SECURITY_APP_InitProviders() != 0) {
         return -1;
     }
     
-    /* Create cipher handle */
-    err = gcry_cipher_open(&cipher_handle, GCRY_CIPHER_AES256, 
-                          GCRY_CIPHER_MODE_CBC, 0);
-    if (err) {
-        return -2;
+    /* Seed the counter nonces (SECURITY_APP_RestoreNonce may replace this) and pre-fill every IV ring */
+    for (channel = 0; channel < SECURITY_APP_CRYPTO_CHANNELS; channel++) {
+        if (SECURITY_APP_Random(nonce_ring[channel].salt, NONCE_SALT_SIZE) != 0) {
+            return -1;
+        }
+        nonce_ring[channel].counter = 0;
+        nonce_ring[channel].limit = 0;
     }
+    nonce_store = NULL;
+    SECURITY_APP_NonceRefill();
     
-    /* Set key */
-    err = gcry_cipher_setkey(cipher_handle, hardcoded_key, AES_KEY_SIZE);
-    if (err) {
-        gcry_cipher_close(cipher_handle);
-        return -3;
+    /* Keys are loaded separately with SECURITY_APP_LoadKey */
+    memset(key_slot, 0, sizeof(key_slot));
+    memset(key_hazard, 0, sizeof(key_hazard));
+    
+    return 0;
+}
+
+void SECURITY_APP_CleanupCrypto(void)
+{
+    uint8_t channel;
+    uint8_t key;
+    uint8_t bank;
+    uint8_t suite;
+    uint8_t stream;
+
+    for (channel = 0; channel < SECURITY_APP_CRYPTO_CHANNELS; channel++) {
+        for (key = 0; key < SECURITY_APP_MAX_KEYS; key++) {
+            for (bank = 0; bank < 2; bank++) {
+                for (suite = 0; suite < SECURITY_APP_SUITE_COUNT; suite++) {
+                    SECURITY_APP_CloseContexts(&contexts[channel][key][bank], suite);
+                }
+            }
+        }
     }
+
+    /* Do not leave key material behind in memory */
+    memset(key_slot, 0, sizeof(key_slot));
+
+    for (stream = 0; stream < SECURITY_APP_CRYPTO_STREAMS; stream++) {
+        SECURITY_APP_StreamAbort(stream);
+    }
+}
+
+size_t SECURITY_APP_CiphertextLength(uint8_t suite, size_t plaintext_len)
+{
+    if (suite >= SECURITY_APP_SUITE_COUNT) {
+        return 0;
+    }
+
+    /* CBC output is zero-padded up to a whole number of blocks */
+    if (suite_table[suite].cbc) {
+        return ((plaintext_len + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE) * AES_BLOCK_SIZE;
+    }
+
+    return plaintext_len + suite_table[suite].tag_len;
+}
+
+int SECURITY_APP_SuiteAuthOnly(uint8_t suite)
+{
+    return suite < SECURITY_APP_SUITE_COUNT && suite_table[suite].auth_only;
+}
+
+int SECURITY_APP_SuiteTagged(uint8_t suite)
+{
+    return suite < SECURITY_APP_SUITE_COUNT && suite_table[suite].tag_len > 0;
+}
+
+/* Encrypt with a channel's contexts for one key bank */
+static int32_t SECURITY_APP_EncryptWith(key_contexts_t *ctx, uint8_t channel, uint8_t suite,
+                                        const uint8_t *aad, size_t aad_len,
+                                        const uint8_t *plaintext, size_t plaintext_len,
+                                        uint8_t *iv, uint8_t *ciphertext, size_t *ciphertext_len)
+{
+    const suite_info_t *info = &suite_table[suite];
+    const security_app_provider_t *p = SECURITY_APP_SuiteProvider(suite);
+    void *handle = ctx->encrypt[suite];
+    int err = 0;
+    uint8_t last_block[AES_BLOCK_SIZE];
+    size_t full_len;
+    size_t tail_len;
     
-    /* Generate random IV */
-    gcry_randomize(iv, AES_BLOCK_SIZE, GCRY_STRONG_RANDOM);
+    /* Take the next IV; bytes past the nonce are sent as zero */
+    if (SECURITY_APP_NextNonce(channel, suite, iv) != 0) {
+        return -4;
+    }
     
-    /* Set IV */
-    err = gcry_cipher_setiv(cipher_handle, iv, AES_BLOCK_SIZE);
+    err = p->start(handle, iv);
     if (err) {
-        gcry_cipher_close(cipher_handle);
+        SECURITY_APP_CloseContexts(ctx, suite);
         return -4;
     }
     
-    /* Calculate padded length (multiple of block size) */
-    size_t padded_len = ((plaintext_len + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE) * AES_BLOCK_SIZE;
+    /* The tag covers the associated data ahead of the message */
+    if (info->tag_len > 0 && aad_len > 0) {
+        err = p->authenticate(handle, aad, aad_len);
+        if (err) {
+            SECURITY_APP_CloseContexts(ctx, suite);
+            return -6;
+        }
+    }
     
-    /* Create a buffer for padded plaintext */
-    uint8_t *padded_plaintext = malloc(padded_len);
-    if (padded_plaintext == NULL) {
-        gcry_cipher_close(cipher_handle);
-        return -5;
+    if (info->auth_only) {
+        /* Pass the data through and tag it; the MAC key schedule stays warm in the context */
+        memmove(ciphertext, plaintext, plaintext_len);
+        err = p->authenticate(handle, ciphertext, plaintext_len);
+        if (!err) {
+            err = p->gettag(handle, ciphertext + plaintext_len, info->tag_len);
+        }
+        if (err) {
+            SECURITY_APP_CloseContexts(ctx, suite);
+            return -6;
+        }
+        
+        *ciphertext_len = plaintext_len + info->tag_len;
+        return 0;
     }
     
-    /* Copy plaintext and add padding (zeros) */
-    memcpy(padded_plaintext, plaintext, plaintext_len);
-    memset(padded_plaintext + plaintext_len, 0, padded_len - plaintext_len);
+    if (!info->cbc) {
+        /* Counter-based modes: output length equals input length, tag follows */
+        err = p->encrypt(handle, ciphertext, plaintext, plaintext_len);
+        if (!err && info->tag_len > 0) {
+            err = p->gettag(handle, ciphertext + plaintext_len, info->tag_len);
+        }
+        if (err) {
+            SECURITY_APP_CloseContexts(ctx, suite);
+            return -6;
+        }
+        
+        *ciphertext_len = plaintext_len + info->tag_len;
+        return 0;
+    }
     
-    /* Encrypt */
-    err = gcry_cipher_encrypt(cipher_handle, ciphertext, padded_len, 
-                             padded_plaintext, padded_len);
+    /* Full blocks are encrypted straight from the caller's buffer */
+    full_len = plaintext_len - (plaintext_len % AES_BLOCK_SIZE);
+    tail_len = plaintext_len - full_len;
     
-    /* Free padded plaintext buffer */
-    free(padded_plaintext);
+    if (full_len > 0) {
+        err = p->encrypt(handle, ciphertext, plaintext, full_len);
+    }
+    
+    /* Zero-pad the trailing partial block, if any */
+    if (!err && tail_len > 0) {
+        memcpy(last_block, plaintext + full_len, tail_len);
+        memset(last_block + tail_len, 0, AES_BLOCK_SIZE - tail_len);
+        err = p->encrypt(handle, ciphertext + full_len, last_block, AES_BLOCK_SIZE);
+    }
     
     if (err) {
-        gcry_cipher_close(cipher_handle);
+        SECURITY_APP_CloseContexts(ctx, suite);
         return -6;
     }
     
     /* Output the ciphertext length */
-    *ciphertext_len = padded_len;
-    
-    /* Clean up */
-    gcry_cipher_close(cipher_handle);
+    *ciphertext_len = full_len + (tail_len > 0 ? AES_BLOCK_SIZE : 0);
     
     return 0;
 }
 
-int32_t SECURITY_APP_Decrypt(const uint8_t *ciphertext, size_t ciphertext_len,
-                            const uint8_t *iv, uint8_t *plaintext, 
-                            size_t *plaintext_len, uint32_t orig_len)
+int32_t SECURITY_APP_Encrypt(uint8_t channel, uint8_t key, uint8_t suite, const uint8_t *aad, size_t aad_len,
+                            const uint8_t *plaintext, size_t plaintext_len,
+                            uint8_t *iv, uint8_t *ciphertext, size_t *ciphertext_len)
 {
-    gcry_cipher_hd_t cipher_handle;
-    gcry_error_t err;
+    key_contexts_t *ctx;
+    uint8_t bank;
+    int32_t status;
     
     /* Parameter check */
-    if (ciphertext == NULL || iv == NULL || plaintext == NULL || plaintext_len == NULL) {
+    if (plaintext == NULL || iv == NULL || ciphertext == NULL || ciphertext_len == NULL ||
+        (aad == NULL && aad_len > 0) ||
+        channel >= SECURITY_APP_CRYPTO_CHANNELS || suite >= SECURITY_APP_SUITE_COUNT) {
         return -1;
     }
     
-    /* Check that ciphertext length is a multiple of the block size */
-    if (ciphertext_len % AES_BLOCK_SIZE != 0) {
-        return -2;
+    status = SECURITY_APP_AcquireKey(channel, key, &bank);
+    if (status != 0) {
+        return status;
     }
     
-    /* Create cipher handle */
-    err = gcry_cipher_open(&cipher_handle, GCRY_CIPHER_AES256, 
-                          GCRY_CIPHER_MODE_CBC, 0);
-    if (err) {
-        return -3;
+    /* Rebuild the contexts if a previous failure invalidated them */
+    ctx = SECURITY_APP_GetContexts(channel, key, bank, suite);
+    if (ctx == NULL) {
+        status = -2;
+    } else {
+        status = SECURITY_APP_EncryptWith(ctx, channel, suite, aad, aad_len, plaintext, plaintext_len,
+                                          iv, ciphertext, ciphertext_len);
     }
     
-    /* Set key */
-    err = gcry_cipher_setkey(cipher_handle, hardcoded_key, AES_KEY_SIZE);
-    if (err) {
-        gcry_cipher_close(cipher_handle);
-        return -4;
+    SECURITY_APP_ReleaseKey(channel);
+    
+    return status;
+}
+
+int32_t SECURITY_APP_EncryptMulti(uint8_t channel, uint8_t key, uint8_t suite,
+                                 security_app_crypto_job_t *jobs, size_t count)
+{
+    const security_app_provider_t *p;
+    security_app_lane_t lanes[SECURITY_APP_MULTI_BUFFERS];
+    security_app_crypto_job_t *lane_job[SECURITY_APP_MULTI_BUFFERS];
+    uint8_t last_block[SECURITY_APP_MULTI_BUFFERS][AES_BLOCK_SIZE];
+    key_contexts_t *ctx = NULL;
+    uint8_t bank;
+    int32_t status;
+    int32_t failed = 0;
+    int acquired;
+    size_t full_len;
+    size_t tail_len;
+    size_t n = 0;
+    size_t i;
+
+    if (jobs == NULL || count > SECURITY_APP_MULTI_BUFFERS) {
+        return -1;
+    }
+
+    /* Only CBC chains gain from interleaving; anything else goes message by message */
+    p = suite < SECURITY_APP_SUITE_COUNT ? SECURITY_APP_SuiteProvider(suite) : NULL;
+    if (channel >= SECURITY_APP_CRYPTO_CHANNELS || p == NULL || p->encrypt_multi == NULL ||
+        !suite_table[suite].cbc || count < 2) {
+        for (i = 0; i < count; i++) {
+            jobs[i].status = SECURITY_APP_Encrypt(channel, key, suite, jobs[i].aad, jobs[i].aad_len,
+                                                  jobs[i].plaintext, jobs[i].plaintext_len,
+                                                  jobs[i].iv, jobs[i].ciphertext, &jobs[i].ciphertext_len);
+            failed += jobs[i].status != 0;
+        }
+        return failed;
+    }
+
+    /* One key pin and one context lookup cover the whole group */
+    status = SECURITY_APP_AcquireKey(channel, key, &bank);
+    acquired = status == 0;
+    if (acquired) {
+        ctx = SECURITY_APP_GetContexts(channel, key, bank, suite);
+        if (ctx == NULL) {
+            status = -2;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        jobs[i].status = status;
+        if (status != 0) {
+            continue;
+        }
+
+        /* Same checks and IV order as SECURITY_APP_Encrypt; CBC carries no tag, so aad is unused */
+        if (jobs[i].plaintext == NULL || jobs[i].iv == NULL || jobs[i].ciphertext == NULL ||
+            (jobs[i].aad == NULL && jobs[i].aad_len > 0)) {
+            jobs[i].status = -1;
+            continue;
+        }
+        if (SECURITY_APP_NextNonce(channel, suite, jobs[i].iv) != 0) {
+            jobs[i].status = -4;
+            continue;
+        }
+
+        full_len = jobs[i].plaintext_len - (jobs[i].plaintext_len % AES_BLOCK_SIZE);
+        tail_len = jobs[i].plaintext_len - full_len;
+
+        lanes[n].iv = jobs[i].iv;
+        lanes[n].in = jobs[i].plaintext;
+        lanes[n].blocks = full_len / AES_BLOCK_SIZE;
+        lanes[n].last = NULL;
+        lanes[n].out = jobs[i].ciphertext;
+
+        /* Zero-pad the trailing partial block, if any */
+        if (tail_len > 0) {
+            memcpy(last_block[n], jobs[i].plaintext + full_len, tail_len);
+            memset(last_block[n] + tail_len, 0, AES_BLOCK_SIZE - tail_len);
+            lanes[n].last = last_block[n];
+        }
+
+        jobs[i].ciphertext_len = full_len + (tail_len > 0 ? AES_BLOCK_SIZE : 0);
+        lane_job[n++] = &jobs[i];
+    }
+
+    if (n > 0 && p->encrypt_multi(ctx->encrypt[suite], lanes, n) != 0) {
+        SECURITY_APP_CloseContexts(ctx, suite);
+        for (i = 0; i < n; i++) {
+            lane_job[i]->status = -6;
+        }
+    }
+
+    if (acquired) {
+        SECURITY_APP_ReleaseKey(channel);
     }
+
+    for (i = 0; i < count; i++) {
+        failed += jobs[i].status != 0;
+    }
+
+    return failed;
+}
+
+/* Decrypt with a channel's contexts for one key bank */
+static int32_t SECURITY_APP_DecryptWith(key_contexts_t *ctx, uint8_t suite,
+                                        const uint8_t *aad, size_t aad_len,
+                                        const uint8_t *ciphertext, size_t ciphertext_len,
+                                        const uint8_t *iv, uint8_t *plaintext,
+                                        size_t *plaintext_len, uint32_t orig_len)
+{
+    const suite_info_t *info = &suite_table[suite];
+    const security_app_provider_t *p = SECURITY_APP_SuiteProvider(suite);
+    void *handle = ctx->decrypt[suite];
+    int err;
+    size_t data_len = ciphertext_len - info->tag_len;
     
-    /* Set IV */
-    err = gcry_cipher_setiv(cipher_handle, iv, AES_BLOCK_SIZE);
+    err = p->start(handle, iv);
     if (err) {
-        gcry_cipher_close(cipher_handle);
+        SECURITY_APP_CloseContexts(ctx, suite);
         return -5;
     }
     
+    if (info->tag_len > 0 && aad_len > 0) {
+        err = p->authenticate(handle, aad, aad_len);
+        if (err) {
+            SECURITY_APP_CloseContexts(ctx, suite);
+            return -6;
+        }
+    }
+    
+    if (info->auth_only) {
+        /* Check the tag first so unauthenticated data never reaches the output */
+        err = p->authenticate(handle, ciphertext, data_len);
+        if (err) {
+            SECURITY_APP_CloseContexts(ctx, suite);
+            return -6;
+        }
+        if (p->checktag(handle, ciphertext + data_len, info->tag_len)) {
+            return -7;
+        }
+        
+        memmove(plaintext, ciphertext, data_len);
+        *plaintext_len = data_len;
+        return 0;
+    }
+    
     /* Decrypt */
-    err = gcry_cipher_decrypt(cipher_handle, plaintext, ciphertext_len, 
-                             ciphertext, ciphertext_len);
+    err = p->decrypt(handle, plaintext, ciphertext, data_len);
     if (err) {
-        gcry_cipher_close(cipher_handle);
+        SECURITY_APP_CloseContexts(ctx, suite);
         return -6;
     }
     
-    /* Clean up */
-    gcry_cipher_close(cipher_handle);
+    /* Authenticate before reporting any output */
+    if (info->tag_len > 0) {
+        err = p->checktag(handle, ciphertext + data_len, info->tag_len);
+        if (err) {
+            return -7;
+        }
+    }
     
-    /* Set the original plaintext length */
-    *plaintext_len = orig_len;
+    /* Zero-padded CBC relies on the sender's length; other modes are exact */
+    *plaintext_len = info->cbc ? orig_len : data_len;
     
     return 0;
-}
\ No newline at end of file
+}
+
+int32_t SECURITY_APP_Decrypt(uint8_t channel, uint8_t key, uint8_t suite, const uint8_t *aad, size_t aad_len,
+                            const uint8_t *ciphertext, size_t ciphertext_len,
+                            const uint8_t *iv, uint8_t *plaintext, 
+                            size_t *plaintext_len, uint32_t orig_len)
+{
+    const suite_info_t *info;
+    key_contexts_t *ctx;
+    uint8_t bank;
+    int32_t status;
+    
+    /* Parameter check */
+    if (ciphertext == NULL || iv == NULL || plaintext == NULL || plaintext_len == NULL ||
+        (aad == NULL && aad_len > 0) ||
+        channel >= SECURITY_APP_CRYPTO_CHANNELS || suite >= SECURITY_APP_SUITE_COUNT) {
+        return -1;
+    }
+    
+    info = &suite_table[suite];
+    
+    /* CBC needs whole blocks; AEAD input must at least hold the tag */
+    if (info->cbc && ciphertext_len % AES_BLOCK_SIZE != 0) {
+        return -2;
+    }
+    if (ciphertext_len < info->tag_len) {
+        return -2;
+    }
+    
+    status = SECURITY_APP_AcquireKey(channel, key, &bank);
+    if (status != 0) {
+        return status;
+    }
+    
+    /* Rebuild the contexts if a previous failure invalidated them */
+    ctx = SECURITY_APP_GetContexts(channel, key, bank, suite);
+    if (ctx == NULL) {
+        status = -3;
+    } else {
+        status = SECURITY_APP_DecryptWith(ctx, suite, aad, aad_len, ciphertext, ciphertext_len,
+                                          iv, plaintext, plaintext_len, orig_len);
+    }
+    
+    SECURITY_APP_ReleaseKey(channel);
+    
+    return status;
+}
+
+/*
+** Stream sessions. Each session owns a cipher context that carries the
+** counter and authentication state from one segment to the next.
+*/
+typedef struct {
+    const security_app_provider_t *provider;
+    void                          *handle;
+    uint8_t                        suite;
+    uint8_t                        encrypt;
+    uint8_t                        active;
+} stream_ctx_t;
+
+static stream_ctx_t stream_table[SECURITY_APP_CRYPTO_STREAMS];
+
+int32_t SECURITY_APP_StreamBegin(uint8_t stream, uint8_t channel, uint8_t key, uint8_t suite, int encrypt,
+                                 uint8_t *iv)
+{
+    const suite_info_t *info;
+    const security_app_provider_t *p;
+    stream_ctx_t *ctx;
+    uint8_t bank;
+
+    if (stream >= SECURITY_APP_CRYPTO_STREAMS || channel >= SECURITY_APP_CRYPTO_CHANNELS || iv == NULL ||
+        suite >= SECURITY_APP_SUITE_COUNT) {
+        return -1;
+    }
+
+    info = &suite_table[suite];
+    ctx = &stream_table[stream];
+
+    /* Zero-padded CBC cannot carry an exact length across segments */
+    if (info->cbc || info->auth_only) {
+        return -2;
+    }
+
+    SECURITY_APP_StreamAbort(stream);
+
+    p = SECURITY_APP_SuiteProvider(suite);
+    if (p == NULL) {
+        return -3;
+    }
+
+    /* Sessions outlive a key rotation, so each takes its own copy of the schedule */
+    if (SECURITY_APP_AcquireKey(channel, key, &bank) != 0) {
+        return -8;
+    }
+    ctx->handle = p->open(suite, key_slot[key].material[bank]);
+    SECURITY_APP_ReleaseKey(channel);
+    if (ctx->handle == NULL) {
+        return -4;
+    }
+
+    if ((encrypt && SECURITY_APP_NextNonce(channel, suite, iv) != 0) || p->start(ctx->handle, iv) != 0) {
+        p->close(ctx->handle);
+        return -5;
+    }
+
+    ctx->provider = p;
+    ctx->suite = suite;
+    ctx->encrypt = encrypt ? 1 : 0;
+    ctx->active = 1;
+
+    return 0;
+}
+
+int32_t SECURITY_APP_StreamUpdate(uint8_t stream, const uint8_t *input, size_t len, uint8_t *output)
+{
+    stream_ctx_t *ctx;
+    int err;
+
+    if (stream >= SECURITY_APP_CRYPTO_STREAMS || input == NULL || output == NULL) {
+        return -1;
+    }
+
+    ctx = &stream_table[stream];
+    if (!ctx->active) {
+        return -2;
+    }
+
+    /* Intermediate segments must keep the cipher on a block boundary */
+    if (len % SECURITY_APP_STREAM_SEGMENT_ALIGN != 0) {
+        return -3;
+    }
+
+    if (ctx->encrypt) {
+        err = ctx->provider->encrypt(ctx->handle, output, input, len);
+    } else {
+        err = ctx->provider->decrypt(ctx->handle, output, input, len);
+    }
+    if (err) {
+        SECURITY_APP_StreamAbort(stream);
+        return -6;
+    }
+
+    return 0;
+}
+
+int32_t SECURITY_APP_StreamFinish(uint8_t stream, const uint8_t *input, size_t len,
+                                  uint8_t *output, uint8_t *tag)
+{
+    const suite_info_t *info;
+    stream_ctx_t *ctx;
+    int err = 0;
+    int32_t status = 0;
+
+    if (stream >= SECURITY_APP_CRYPTO_STREAMS || (len > 0 && (input == NULL || output == NULL)) || tag == NULL) {
+        return -1;
+    }
+
+    ctx = &stream_table[stream];
+    if (!ctx->active) {
+        return -2;
+    }
+    info = &suite_table[ctx->suite];
+
+    if (len > 0) {
+        if (ctx->encrypt) {
+            err = ctx->provider->encrypt(ctx->handle, output, input, len);
+        } else {
+            err = ctx->provider->decrypt(ctx->handle, output, input, len);
+        }
+    }
+
+    if (err) {
+        status = -6;
+    } else if (info->tag_len > 0) {
+        if (ctx->encrypt) {
+            err = ctx->provider->gettag(ctx->handle, tag, info->tag_len);
+            status = err ? -6 : 0;
+        } else {
+            err = ctx->provider->checktag(ctx->handle, tag, info->tag_len);
+            status = err ? -7 : 0;
+        }
+    }
+
+    /* The session ends whether or not the final segment succeeded */
+    SECURITY_APP_StreamAbort(stream);
+
+    return status;
+}
+
+void SECURITY_APP_StreamAbort(uint8_t stream)
+{
+    if (stream < SECURITY_APP_CRYPTO_STREAMS && stream_table[stream].active) {
+        stream_table[stream].provider->close(stream_table[stream].handle);
+        stream_table[stream].active = 0;
+    }
+}
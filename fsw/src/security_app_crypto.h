@@ -4,13 +4,187 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "security_app_platform_cfg.h"
+
+/*
+** Cipher suites selectable per command
+**
+** CBC is the legacy zero-padded mode. CTR is an unauthenticated stream mode
+** whose output matches the input length. GCM and ChaCha20-Poly1305 are AEAD
+** modes: the output is the input length plus a tag appended to the
+** ciphertext, and decryption fails if the tag does not verify.
+**
+** GMAC and Poly1305 are authenticate-only: the data passes through in the
+** clear with a tag appended, and decryption only checks the tag. They cost
+** one universal-hash pass instead of a cipher pass plus a hash pass.
+*/
+#define SECURITY_APP_SUITE_AES256_CBC          0
+#define SECURITY_APP_SUITE_AES256_CTR          1
+#define SECURITY_APP_SUITE_AES256_GCM          2
+#define SECURITY_APP_SUITE_CHACHA20_POLY1305   3
+#define SECURITY_APP_SUITE_AES256_GMAC         4
+#define SECURITY_APP_SUITE_POLY1305            5
+#define SECURITY_APP_SUITE_COUNT               6
+
+/*
+** Crypto channels
+**
+** Each task that calls SECURITY_APP_Encrypt/Decrypt passes its own channel
+** so that no two tasks share a cipher context. Channel 0 belongs to the main
+** task, channel 1 + n to crypto worker n and the last channel to the file
+** task.
+*/
+#define SECURITY_APP_MAIN_CHANNEL              0
+#define SECURITY_APP_FILE_CHANNEL              (1 + SECURITY_APP_NUM_WORKERS)
+#define SECURITY_APP_CRYPTO_CHANNELS           (2 + SECURITY_APP_NUM_WORKERS)
+
+#define SECURITY_APP_IV_SIZE                   16
+#define SECURITY_APP_TAG_SIZE                  16
+#define SECURITY_APP_KEY_SIZE                  32
+
+/*
+** Crypto providers, as reported in housekeeping
+**
+** SECURITY_APP_InitCrypto gives each suite to the fastest provider built in
+** that this CPU supports and that passes the suite's known-answer self-test.
+** A suite with no provider fails every operation. The self-test failure
+** mask has bit n set if some provider failed suite n.
+*/
+#define SECURITY_APP_PROVIDER_NONE             0
+#define SECURITY_APP_PROVIDER_GCRYPT           1    /* libgcrypt, every suite */
+#define SECURITY_APP_PROVIDER_AESNI            2    /* Built-in AES-NI, AES-256 CBC and CTR */
+#define SECURITY_APP_PROVIDER_VAES             3    /* Built-in VAES/AVX2, AES-256 CBC and CTR */
+
 int32_t SECURITY_APP_InitCrypto(void);
 
-int32_t SECURITY_APP_Encrypt(const uint8_t *plaintext, size_t plaintext_len,
+void SECURITY_APP_CleanupCrypto(void);
+
+/*
+** Keys, by ID (0 .. SECURITY_APP_MAX_KEYS - 1)
+**
+** SECURITY_APP_LoadKey expands the key for every channel and suite into a
+** standby bank while the current key stays in service, then switches the ID
+** over atomically. Operations in flight finish on the key they started
+** with. If some channel is still using the bank that would be reused, LoadKey
+** returns -9 without changing anything and should be retried later. Load and
+** unload must be called from a single task. Encrypt/Decrypt return -8 for an
+** ID with no key loaded.
+*/
+int32_t SECURITY_APP_LoadKey(uint8_t key, const uint8_t *material);
+
+void SECURITY_APP_UnloadKey(uint8_t key);
+
+int SECURITY_APP_KeyLoaded(uint8_t key);
+
+int SECURITY_APP_KeyMatches(uint8_t key, const uint8_t *material);
+
+/*
+** Nonce supply: SECURITY_APP_NonceRefill tops up every channel's IV ring and
+** may run on any single task. The callback is invoked from the hot path when
+** a ring falls to SECURITY_APP_NONCE_LOW_WATER, and must not block.
+*/
+void SECURITY_APP_NonceRefill(void);
+
+void SECURITY_APP_SetNonceLowCallback(void (*callback)(void));
+
+/*
+** Counter nonce store (see SECURITY_APP_COUNTER_NONCES). Called from the
+** task using a channel, with the channel's salt and the highest counter value
+** it will use, before it uses any value above the last one stored. Must save
+** both durably and return 0; a non-zero return drops the store and every
+** channel falls back to random IVs. SECURITY_APP_RestoreNonce hands a stored
+** salt and limit back at startup, after SECURITY_APP_InitCrypto and before
+** the store is set.
+*/
+#define SECURITY_APP_NONCE_SALT_SIZE           5
+
+typedef int (*security_app_nonce_store_t)(uint8_t channel, const uint8_t *salt, uint64_t limit);
+
+void SECURITY_APP_SetNonceStore(security_app_nonce_store_t store);
+
+void SECURITY_APP_RestoreNonce(uint8_t channel, const uint8_t *salt, uint64_t limit);
+
+void SECURITY_APP_GetNonceStats(uint32_t *refills, uint32_t *underflows);
+
+void SECURITY_APP_ResetNonceStats(void);
+
+uint8_t SECURITY_APP_CryptoProvider(uint8_t suite);
+
+const char *SECURITY_APP_CryptoProviderName(uint8_t suite);
+
+uint8_t SECURITY_APP_CryptoSelfTestFailures(void);
+
+size_t SECURITY_APP_CiphertextLength(uint8_t suite, size_t plaintext_len);
+
+int SECURITY_APP_SuiteAuthOnly(uint8_t suite);
+
+/* Whether a suite's tag covers the associated data (the record header); not for CBC and CTR */
+int SECURITY_APP_SuiteTagged(uint8_t suite);
+
+/*
+** Encrypt generates the IV into iv; Decrypt takes the sender's. Every suite
+** uses a 12-byte nonce; the remaining IV bytes are zero. For suites with a
+** tag, aad (which may be NULL when aad_len is 0) is authenticated along with
+** the message but not encrypted or output.
+*/
+int32_t SECURITY_APP_Encrypt(uint8_t channel, uint8_t key, uint8_t suite, const uint8_t *aad, size_t aad_len,
+                            const uint8_t *plaintext, size_t plaintext_len,
                             uint8_t *iv, uint8_t *ciphertext, size_t *ciphertext_len);
 
-int32_t SECURITY_APP_Decrypt(const uint8_t *ciphertext, size_t ciphertext_len,
+/*
+** Multi-buffer encryption
+**
+** Encrypts up to SECURITY_APP_MULTI_BUFFERS independent messages under one
+** key and suite, with the same output and IV order as calling
+** SECURITY_APP_Encrypt for each job in turn, and sets each job's status and
+** ciphertext_len. Where the suite's provider has a multi-buffer kernel the
+** messages' CBC chains are interleaved; otherwise the jobs run one by one.
+** Returns the number of jobs that failed, or -1 for a bad job list.
+*/
+typedef struct {
+    const uint8_t *aad;
+    size_t         aad_len;
+    const uint8_t *plaintext;
+    size_t         plaintext_len;
+    uint8_t       *iv;
+    uint8_t       *ciphertext;
+    size_t         ciphertext_len;
+    int32_t        status;
+} security_app_crypto_job_t;
+
+int32_t SECURITY_APP_EncryptMulti(uint8_t channel, uint8_t key, uint8_t suite,
+                                 security_app_crypto_job_t *jobs, size_t count);
+
+int32_t SECURITY_APP_Decrypt(uint8_t channel, uint8_t key, uint8_t suite, const uint8_t *aad, size_t aad_len,
+                            const uint8_t *ciphertext, size_t ciphertext_len,
                             const uint8_t *iv, uint8_t *plaintext, 
                             size_t *plaintext_len, uint32_t orig_len);
 
-#endif /* SECURITY_APP_CRYPTO_H */
\ No newline at end of file
+/*
+** Stream sessions (counter-based encrypting suites only)
+**
+** Every segment but the last must be a multiple of
+** SECURITY_APP_STREAM_SEGMENT_ALIGN bytes. For encryption StreamBegin
+** generates the IV; for decryption it takes the sender's IV. StreamFinish
+** produces the tag when encrypting and checks it (-7 on mismatch) when
+** decrypting, and always releases the session.
+**
+** Sessions 0 .. SECURITY_APP_MAX_STREAMS - 1 belong to the stream commands
+** and SECURITY_APP_FILE_STREAM to the file task. The channel passed to
+** StreamBegin is the calling task's own.
+*/
+#define SECURITY_APP_STREAM_SEGMENT_ALIGN      64
+#define SECURITY_APP_FILE_STREAM               SECURITY_APP_MAX_STREAMS
+#define SECURITY_APP_CRYPTO_STREAMS            (SECURITY_APP_MAX_STREAMS + 1)
+
+int32_t SECURITY_APP_StreamBegin(uint8_t stream, uint8_t channel, uint8_t key, uint8_t suite, int encrypt,
+                                 uint8_t *iv);
+
+int32_t SECURITY_APP_StreamUpdate(uint8_t stream, const uint8_t *input, size_t len, uint8_t *output);
+
+int32_t SECURITY_APP_StreamFinish(uint8_t stream, const uint8_t *input, size_t len,
+                                  uint8_t *output, uint8_t *tag);
+
+void SECURITY_APP_StreamAbort(uint8_t stream);
+
+#endif /* SECURITY_APP_CRYPTO_H */
@@ -18,5 +18,26 @@
 #define SECURITY_APP_DECRYPT_INF_EID           10 /* Successful decryption */
 #define SECURITY_APP_DECRYPT_ERR_EID           11 /* Decryption error */
 #define SECURITY_APP_INVALID_DATA_ERR_EID      12 /* Invalid data for encryption/decryption */
+#define SECURITY_APP_BATCH_INF_EID             13 /* Batch command summary */
+#define SECURITY_APP_BATCH_ERR_EID             14 /* Malformed batch command */
+#define SECURITY_APP_STREAM_INF_EID            15 /* Stream session opened or closed */
+#define SECURITY_APP_STREAM_ERR_EID            16 /* Stream session error */
+#define SECURITY_APP_WORKER_ERR_EID            17 /* Crypto worker pool error */
+#define SECURITY_APP_TBL_INF_EID               18 /* Inline table (re)loaded */
+#define SECURITY_APP_TBL_ERR_EID               19 /* Inline table error */
+#define SECURITY_APP_NONCE_ERR_EID             20 /* IV refill task or nonce store error */
+#define SECURITY_APP_STATS_INF_EID             21 /* Periodic crypto statistics summary */
+#define SECURITY_APP_KEY_INF_EID               22 /* Key loaded or taken out of service */
+#define SECURITY_APP_KEY_ERR_EID               23 /* Key table error */
+#define SECURITY_APP_VERIFY_ERR_EID            24 /* Signed record failed verification */
+#define SECURITY_APP_REPLAY_ERR_EID            25 /* Record dropped by the anti-replay window */
+#define SECURITY_APP_FILE_INF_EID              26 /* File encrypted or decrypted */
+#define SECURITY_APP_FILE_ERR_EID              27 /* File command or file task error */
+#define SECURITY_APP_ACCT_INF_EID              28 /* Per-stream accounting dump written */
+#define SECURITY_APP_ACCT_ERR_EID              29 /* Per-stream accounting dump error */
+#define SECURITY_APP_CONGESTION_INF_EID        30 /* Data pipe congested or recovered */
+#define SECURITY_APP_PROVIDER_INF_EID          31 /* Crypto provider chosen for each suite */
+#define SECURITY_APP_PROVIDER_ERR_EID          32 /* Crypto provider failed its self-test */
+#define SECURITY_APP_REPLAY_CDS_ERR_EID        33 /* Outgoing sequence numbers could not be saved */
 
 #endif /* SECURITY_APP_EVENTS_H */
\ No newline at end of file
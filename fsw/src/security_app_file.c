@@ -0,0 +1,544 @@
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include "security_app_events.h"
+#include "security_app_perf.h"
+
+#include <string.h>
+
+/*
+** File encryption
+**
+** Files are processed off the main task by two child tasks sharing a pair of
+** buffers: the reader task fills one buffer while the file task encrypts or
+** decrypts the other in place and writes it out, so file reads overlap the
+** cipher and the writes. Empty and full buffers are handed over through two
+** counting semaphores. The reader ends every file with a zero-length buffer
+** (negative on a read error), which the file task waits for even after a
+** failure so that both tasks always finish a job with both buffers free.
+**
+** The file task has its own crypto channel and stream session, so files never
+** contend with packets for cipher contexts or IVs.
+*/
+CompileTimeAssert((SECURITY_APP_FILE_CHUNK_SIZE % SECURITY_APP_STREAM_SEGMENT_ALIGN) == 0,
+                  FileChunkNotSegmentAligned);
+
+typedef struct
+{
+    uint8   Operation;                  /* SECURITY_APP_OP_* */
+    uint8   Suite;
+    uint8   KeyId;
+    char    InputFile[OS_MAX_PATH_LEN];
+    char    OutputFile[OS_MAX_PATH_LEN];
+
+} SECURITY_APP_FileJob_t;
+
+static struct
+{
+    uint32  JobSemId;                   /* Main task -> file task: job posted */
+    uint32  StartSemId;                 /* File task -> reader: input open */
+    uint32  EmptySemId;                 /* Buffers free for the reader */
+    uint32  FullSemId;                  /* Buffers ready for the file task */
+    uint32  TaskId;
+    uint32  ReaderTaskId;
+
+    SECURITY_APP_FileJob_t  Job;
+
+    int32   InFd;
+    uint32  ReadLimit;                  /* Bytes of input the reader delivers */
+    bool    Stop;                       /* File task failed; reader stops early */
+
+    int32   Length[2];
+    uint8   Buffer[2][SECURITY_APP_FILE_CHUNK_SIZE] __attribute__((aligned(64)));
+
+} SECURITY_APP_File;
+
+/* Read until Count bytes, end of file or an error; returns bytes read or the error */
+static int32 SECURITY_APP_FileRead(int32 Fd, uint8 *Buffer, uint32 Count)
+{
+    uint32 Total = 0;
+    int32 Bytes;
+
+    while (Total < Count)
+    {
+        Bytes = OS_read(Fd, Buffer + Total, Count - Total);
+        if (Bytes < 0)
+        {
+            return Bytes;
+        }
+        if (Bytes == 0)
+        {
+            break;
+        }
+        Total += Bytes;
+    }
+
+    return (int32)Total;
+}
+
+static bool SECURITY_APP_FileWrite(int32 Fd, const uint8 *Buffer, uint32 Count)
+{
+    return OS_write(Fd, Buffer, Count) == (int32)Count;
+}
+
+static void SECURITY_APP_FileFail(const SECURITY_APP_FileJob_t *Job, uint8 Category, const char *Reason,
+                                  int32 Status)
+{
+    SECURITY_APP_CountError(Job->Operation, Category);
+    __atomic_store_n(&SECURITY_APP_Data.HkTlm.FileState, SECURITY_APP_FILE_FAILED, __ATOMIC_RELEASE);
+
+    CFE_EVS_SendEvent(SECURITY_APP_FILE_ERR_EID, CFE_EVS_ERROR,
+                     "SECURITY_APP: File %s of %s failed: %s, RC = %d",
+                     (Job->Operation == SECURITY_APP_OP_ENCRYPT) ? "encryption" : "decryption",
+                     Job->InputFile, Reason, (int)Status);
+}
+
+/* Bytes per second for Bytes processed since Start */
+static uint32 SECURITY_APP_FileRate(uint32 Bytes, uint64 Start)
+{
+    uint64 Elapsed = SECURITY_APP_PerfNow() - Start;
+
+    if (Elapsed == 0)
+    {
+        return 0;
+    }
+
+    return (uint32)(((uint64)Bytes * CFE_PSP_GetTimerTicksPerSecond()) / Elapsed);
+}
+
+static void SECURITY_APP_FilePackHeader(uint8 *Header, uint8 Suite, uint8 KeyId, uint32 Length, const uint8 *IV)
+{
+    memset(Header, 0, SECURITY_APP_FILE_HDR_SIZE);
+    memcpy(Header, SECURITY_APP_FILE_MAGIC, 4);
+    Header[4] = SECURITY_APP_FILE_VERSION;
+    Header[5] = (uint8)((Suite << 4) | (KeyId & 0x0F));
+    Header[8] = (uint8)(Length >> 24);
+    Header[9] = (uint8)(Length >> 16);
+    Header[10] = (uint8)(Length >> 8);
+    Header[11] = (uint8)Length;
+    memcpy(&Header[16], IV, SECURITY_APP_WIRE_NONCE_SIZE);
+}
+
+/* Returns FALSE if the header is not one this version wrote */
+static bool SECURITY_APP_FileUnpackHeader(const uint8 *Header, uint8 *Suite, uint8 *KeyId, uint32 *Length,
+                                          uint8 *IV)
+{
+    static const uint8 Zero[4] = { 0 };
+
+    if (memcmp(Header, SECURITY_APP_FILE_MAGIC, 4) != 0 || Header[4] != SECURITY_APP_FILE_VERSION ||
+        memcmp(&Header[6], Zero, 2) != 0 || memcmp(&Header[12], Zero, 4) != 0 ||
+        memcmp(&Header[28], Zero, 4) != 0)
+    {
+        return FALSE;
+    }
+
+    *Suite = Header[5] >> 4;
+    *KeyId = Header[5] & 0x0F;
+    *Length = ((uint32)Header[8] << 24) | ((uint32)Header[9] << 16) | ((uint32)Header[10] << 8) | Header[11];
+    memset(IV, 0, SECURITY_APP_IV_SIZE);
+    memcpy(IV, &Header[16], SECURITY_APP_WIRE_NONCE_SIZE);
+
+    return TRUE;
+}
+
+/*
+** Open the input and the cipher session for a job and create the output.
+** Sets the reader's limit; returns the output descriptor, or a negative
+** value once the failure has been reported.
+*/
+static int32 SECURITY_APP_FileOpen(const SECURITY_APP_FileJob_t *Job, uint8 *Tag, uint32 *TagLength)
+{
+    uint8 Header[SECURITY_APP_FILE_HDR_SIZE];
+    uint8 IV[SECURITY_APP_IV_SIZE];
+    uint8 Suite = Job->Suite;
+    uint8 KeyId = Job->KeyId;
+    uint32 Length;
+    int32 Size;
+    int32 OutFd;
+    int32 status;
+
+    Size = OS_lseek(SECURITY_APP_File.InFd, 0, OS_SEEK_END);
+    if (Size < 0 || OS_lseek(SECURITY_APP_File.InFd, 0, OS_SEEK_SET) != 0)
+    {
+        SECURITY_APP_FileFail(Job, SECURITY_APP_STAT_ERR_IO, "cannot size input", Size);
+        return -1;
+    }
+
+    if (Job->Operation == SECURITY_APP_OP_ENCRYPT)
+    {
+        Length = (uint32)Size;
+        *TagLength = SECURITY_APP_CiphertextLength(Suite, 0);
+        status = SECURITY_APP_StreamBegin(SECURITY_APP_FILE_STREAM, SECURITY_APP_FILE_CHANNEL, KeyId, Suite,
+                                          1, IV);
+    }
+    else
+    {
+        if (SECURITY_APP_FileRead(SECURITY_APP_File.InFd, Header, sizeof(Header)) != sizeof(Header) ||
+            !SECURITY_APP_FileUnpackHeader(Header, &Suite, &KeyId, &Length, IV) ||
+            Suite >= SECURITY_APP_SUITE_COUNT || KeyId >= SECURITY_APP_MAX_KEYS)
+        {
+            SECURITY_APP_FileFail(Job, SECURITY_APP_STAT_ERR_FORMAT, "not an encrypted file", 0);
+            return -1;
+        }
+
+        /* Catch truncated or extended files before writing anything */
+        *TagLength = SECURITY_APP_CiphertextLength(Suite, 0);
+        if (Length > (uint32)Size || (uint32)Size != SECURITY_APP_FILE_HDR_SIZE + Length + *TagLength)
+        {
+            SECURITY_APP_FileFail(Job, SECURITY_APP_STAT_ERR_LENGTH, "file length does not match header", Size);
+            return -1;
+        }
+
+        /* The tag is needed with the last chunk, so fetch it before the reader starts */
+        if (*TagLength > 0 &&
+            (OS_lseek(SECURITY_APP_File.InFd, Size - *TagLength, OS_SEEK_SET) < 0 ||
+             SECURITY_APP_FileRead(SECURITY_APP_File.InFd, Tag, *TagLength) != (int32)*TagLength ||
+             OS_lseek(SECURITY_APP_File.InFd, SECURITY_APP_FILE_HDR_SIZE, OS_SEEK_SET) < 0))
+        {
+            SECURITY_APP_FileFail(Job, SECURITY_APP_STAT_ERR_IO, "cannot read tag", 0);
+            return -1;
+        }
+
+        status = SECURITY_APP_StreamBegin(SECURITY_APP_FILE_STREAM, SECURITY_APP_FILE_CHANNEL, KeyId, Suite,
+                                          0, IV);
+    }
+
+    if (status != 0)
+    {
+        SECURITY_APP_FileFail(Job, (status == -8) ? SECURITY_APP_STAT_ERR_KEY : SECURITY_APP_STAT_ERR_CIPHER,
+                              "cannot start cipher", status);
+        return -1;
+    }
+
+    OutFd = OS_creat(Job->OutputFile, OS_WRITE_ONLY);
+    if (OutFd < 0)
+    {
+        SECURITY_APP_StreamAbort(SECURITY_APP_FILE_STREAM);
+        SECURITY_APP_FileFail(Job, SECURITY_APP_STAT_ERR_IO, "cannot create output", OutFd);
+        return -1;
+    }
+
+    if (Job->Operation == SECURITY_APP_OP_ENCRYPT)
+    {
+        SECURITY_APP_FilePackHeader(Header, Suite, KeyId, Length, IV);
+        if (!SECURITY_APP_FileWrite(OutFd, Header, sizeof(Header)))
+        {
+            SECURITY_APP_StreamAbort(SECURITY_APP_FILE_STREAM);
+            OS_close(OutFd);
+            OS_remove(Job->OutputFile);
+            SECURITY_APP_FileFail(Job, SECURITY_APP_STAT_ERR_IO, "cannot write output", 0);
+            return -1;
+        }
+    }
+
+    SECURITY_APP_File.ReadLimit = Length;
+    __atomic_store_n(&SECURITY_APP_Data.HkTlm.FileBytesTotal, Length, __ATOMIC_RELAXED);
+
+    return OutFd;
+}
+
+/* Process the posted job from start to finish */
+static void SECURITY_APP_FileRun(void)
+{
+    const SECURITY_APP_FileJob_t *Job = &SECURITY_APP_File.Job;
+    uint8 Tag[SECURITY_APP_TAG_SIZE];
+    uint32 TagLength = 0;
+    uint32 Done = 0;
+    uint32 Rate;
+    uint64 Start;
+    bool Finished = FALSE;
+    const char *Reason = NULL;
+    uint8 Category = SECURITY_APP_STAT_ERR_IO;
+    int32 OutFd;
+    int32 Length;
+    int32 status = 0;
+    uint8 Index = 0;
+
+    SECURITY_APP_File.InFd = OS_open(Job->InputFile, OS_READ_ONLY, 0);
+    if (SECURITY_APP_File.InFd < 0)
+    {
+        SECURITY_APP_FileFail(Job, SECURITY_APP_STAT_ERR_IO, "cannot open input", SECURITY_APP_File.InFd);
+        return;
+    }
+
+    OutFd = SECURITY_APP_FileOpen(Job, Tag, &TagLength);
+    if (OutFd < 0)
+    {
+        OS_close(SECURITY_APP_File.InFd);
+        return;
+    }
+
+    Start = SECURITY_APP_PerfNow();
+    __atomic_store_n(&SECURITY_APP_File.Stop, FALSE, __ATOMIC_RELAXED);
+    OS_BinSemGive(SECURITY_APP_File.StartSemId);
+
+    for (;;)
+    {
+        OS_CountSemTake(SECURITY_APP_File.FullSemId);
+        Length = SECURITY_APP_File.Length[Index];
+
+        if (Length <= 0)
+        {
+            if (Length < 0 && Reason == NULL)
+            {
+                Reason = "cannot read input";
+                status = Length;
+            }
+            OS_CountSemGive(SECURITY_APP_File.EmptySemId);
+            break;
+        }
+
+        if (Reason == NULL)
+        {
+            /* Only the last chunk can be short, and it carries the tag */
+            if (Done + Length == SECURITY_APP_File.ReadLimit)
+            {
+                status = SECURITY_APP_StreamFinish(SECURITY_APP_FILE_STREAM, SECURITY_APP_File.Buffer[Index],
+                                                   Length, SECURITY_APP_File.Buffer[Index], Tag);
+                Finished = TRUE;
+            }
+            else
+            {
+                status = SECURITY_APP_StreamUpdate(SECURITY_APP_FILE_STREAM, SECURITY_APP_File.Buffer[Index],
+                                                   Length, SECURITY_APP_File.Buffer[Index]);
+            }
+
+            if (status != 0)
+            {
+                Reason = (status == -7) ? "authentication failed" : "cipher error";
+                Category = (status == -7) ? SECURITY_APP_STAT_ERR_AUTH : SECURITY_APP_STAT_ERR_CIPHER;
+            }
+            else if (!SECURITY_APP_FileWrite(OutFd, SECURITY_APP_File.Buffer[Index], Length))
+            {
+                Reason = "cannot write output";
+            }
+            else
+            {
+                Done += Length;
+                __atomic_store_n(&SECURITY_APP_Data.HkTlm.FileBytesDone, Done, __ATOMIC_RELAXED);
+                __atomic_store_n(&SECURITY_APP_Data.HkTlm.FileRate, SECURITY_APP_FileRate(Done, Start),
+                                 __ATOMIC_RELAXED);
+            }
+
+            if (Reason != NULL)
+            {
+                __atomic_store_n(&SECURITY_APP_File.Stop, TRUE, __ATOMIC_RELAXED);
+            }
+        }
+
+        OS_CountSemGive(SECURITY_APP_File.EmptySemId);
+        Index ^= 1;
+    }
+
+    OS_close(SECURITY_APP_File.InFd);
+
+    if (Reason == NULL && Done != SECURITY_APP_File.ReadLimit)
+    {
+        Reason = "input changed length";
+    }
+
+    /* An empty file has no chunks; its tag covers no data */
+    if (Reason == NULL && !Finished)
+    {
+        status = SECURITY_APP_StreamFinish(SECURITY_APP_FILE_STREAM, NULL, 0, NULL, Tag);
+        if (status != 0)
+        {
+            Reason = (status == -7) ? "authentication failed" : "cipher error";
+            Category = (status == -7) ? SECURITY_APP_STAT_ERR_AUTH : SECURITY_APP_STAT_ERR_CIPHER;
+        }
+    }
+
+    if (Reason == NULL && Job->Operation == SECURITY_APP_OP_ENCRYPT && TagLength > 0 &&
+        !SECURITY_APP_FileWrite(OutFd, Tag, TagLength))
+    {
+        Reason = "cannot write output";
+    }
+
+    OS_close(OutFd);
+
+    if (Reason != NULL)
+    {
+        SECURITY_APP_StreamAbort(SECURITY_APP_FILE_STREAM);
+        OS_remove(Job->OutputFile);
+        SECURITY_APP_FileFail(Job, Category, Reason, status);
+        return;
+    }
+
+    Rate = SECURITY_APP_FileRate(Done, Start);
+    __atomic_store_n(&SECURITY_APP_Data.HkTlm.FileRate, Rate, __ATOMIC_RELAXED);
+    __atomic_store_n(&SECURITY_APP_Data.HkTlm.FileState, SECURITY_APP_FILE_DONE, __ATOMIC_RELEASE);
+    SECURITY_APP_CountSuccess(Job->Operation, Done);
+
+    CFE_EVS_SendEvent(SECURITY_APP_FILE_INF_EID, CFE_EVS_INFORMATION,
+                     "SECURITY_APP: File %s %s -> %s, %u bytes at %u bytes/s",
+                     (Job->Operation == SECURITY_APP_OP_ENCRYPT) ? "encrypted" : "decrypted",
+                     Job->InputFile, Job->OutputFile, (unsigned int)Done, (unsigned int)Rate);
+}
+
+/* File task entry point */
+void SECURITY_APP_FileTaskMain(void)
+{
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    while (OS_BinSemTake(SECURITY_APP_File.JobSemId) == OS_SUCCESS)
+    {
+        SECURITY_APP_FileRun();
+    }
+
+    CFE_ES_ExitChildTask();
+}
+
+/* Reader task entry point: delivers one job's input, then waits for the next */
+void SECURITY_APP_FileReaderMain(void)
+{
+    uint32 Remaining;
+    uint32 Count;
+    int32 Length;
+    uint8 Index;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    while (OS_BinSemTake(SECURITY_APP_File.StartSemId) == OS_SUCCESS)
+    {
+        Remaining = SECURITY_APP_File.ReadLimit;
+        Index = 0;
+
+        do
+        {
+            OS_CountSemTake(SECURITY_APP_File.EmptySemId);
+
+            Count = (Remaining < SECURITY_APP_FILE_CHUNK_SIZE) ? Remaining : SECURITY_APP_FILE_CHUNK_SIZE;
+            Length = 0;
+            if (Count > 0 && !__atomic_load_n(&SECURITY_APP_File.Stop, __ATOMIC_RELAXED))
+            {
+                Length = SECURITY_APP_FileRead(SECURITY_APP_File.InFd, SECURITY_APP_File.Buffer[Index], Count);
+            }
+            if (Length > 0)
+            {
+                Remaining -= Length;
+            }
+
+            SECURITY_APP_File.Length[Index] = Length;
+            OS_CountSemGive(SECURITY_APP_File.FullSemId);
+            Index ^= 1;
+
+        } while (Length > 0);
+    }
+
+    CFE_ES_ExitChildTask();
+}
+
+/* Validate a file command and post it to the file task */
+static int32 SECURITY_APP_ProcessFileCmd(const SECURITY_APP_FileCmd_t *Msg, uint8 Operation)
+{
+    SECURITY_APP_FileJob_t *Job = &SECURITY_APP_File.Job;
+
+    SECURITY_APP_Data.CmdCounter++;
+
+    if (memchr(Msg->InputFile, '\0', sizeof(Msg->InputFile)) == NULL || Msg->InputFile[0] == '\0' ||
+        memchr(Msg->OutputFile, '\0', sizeof(Msg->OutputFile)) == NULL || Msg->OutputFile[0] == '\0')
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_FILE_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: File command has an empty or unterminated path");
+        return CFE_SUCCESS;
+    }
+
+    if (Operation == SECURITY_APP_OP_ENCRYPT &&
+        (Msg->Suite >= SECURITY_APP_SUITE_COUNT || Msg->Suite == SECURITY_APP_SUITE_AES256_CBC ||
+         SECURITY_APP_SuiteAuthOnly(Msg->Suite) || Msg->KeyId >= SECURITY_APP_MAX_KEYS))
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_FILE_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Suite %d, key ID %d cannot be used for files", Msg->Suite, Msg->KeyId);
+        return CFE_SUCCESS;
+    }
+
+    /* Only the main task starts jobs, so the state cannot change to busy behind this check */
+    if (__atomic_load_n(&SECURITY_APP_Data.HkTlm.FileState, __ATOMIC_ACQUIRE) == SECURITY_APP_FILE_BUSY)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_FILE_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: File task busy with %s", Job->InputFile);
+        return CFE_SUCCESS;
+    }
+
+    Job->Operation = Operation;
+    Job->Suite = Msg->Suite;
+    Job->KeyId = Msg->KeyId;
+    strcpy(Job->InputFile, Msg->InputFile);
+    strcpy(Job->OutputFile, Msg->OutputFile);
+
+    SECURITY_APP_Data.HkTlm.FileOperation = Operation;
+    SECURITY_APP_Data.HkTlm.FileBytesDone = 0;
+    SECURITY_APP_Data.HkTlm.FileBytesTotal = 0;
+    SECURITY_APP_Data.HkTlm.FileRate = 0;
+    __atomic_store_n(&SECURITY_APP_Data.HkTlm.FileState, SECURITY_APP_FILE_BUSY, __ATOMIC_RELEASE);
+
+    OS_BinSemGive(SECURITY_APP_File.JobSemId);
+
+    return CFE_SUCCESS;
+}
+
+/* File encrypt command handler */
+int32 SECURITY_APP_FileEncryptCmd(const SECURITY_APP_FileEncryptCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessFileCmd(Msg, SECURITY_APP_OP_ENCRYPT);
+}
+
+/* File decrypt command handler */
+int32 SECURITY_APP_FileDecryptCmd(const SECURITY_APP_FileDecryptCmd_t *Msg)
+{
+    return SECURITY_APP_ProcessFileCmd(Msg, SECURITY_APP_OP_DECRYPT);
+}
+
+/* Create the file task, its reader and the semaphores between them */
+int32 SECURITY_APP_InitFileTask(void)
+{
+    int32 status;
+
+    status = OS_BinSemCreate(&SECURITY_APP_File.JobSemId, "SECAPP_FJOB", 0, 0);
+    if (status == OS_SUCCESS)
+    {
+        status = OS_BinSemCreate(&SECURITY_APP_File.StartSemId, "SECAPP_FSTART", 0, 0);
+    }
+    if (status == OS_SUCCESS)
+    {
+        status = OS_CountSemCreate(&SECURITY_APP_File.EmptySemId, "SECAPP_FEMPTY", 2, 0);
+    }
+    if (status == OS_SUCCESS)
+    {
+        status = OS_CountSemCreate(&SECURITY_APP_File.FullSemId, "SECAPP_FFULL", 0, 0);
+    }
+    if (status != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_FILE_ERR_EID, CFE_EVS_ERROR,
+                         "Error creating file task semaphores, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    status = CFE_ES_CreateChildTask(&SECURITY_APP_File.ReaderTaskId, "SECURITY_FREAD",
+                                    SECURITY_APP_FileReaderMain, NULL, SECURITY_APP_FILE_TASK_STACK_SIZE,
+                                    SECURITY_APP_FILE_TASK_PRIORITY, 0);
+    if (status == CFE_SUCCESS)
+    {
+        status = CFE_ES_CreateChildTask(&SECURITY_APP_File.TaskId, "SECURITY_FILE",
+                                        SECURITY_APP_FileTaskMain, NULL, SECURITY_APP_FILE_TASK_STACK_SIZE,
+                                        SECURITY_APP_FILE_TASK_PRIORITY, 0);
+    }
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_FILE_ERR_EID, CFE_EVS_ERROR,
+                         "Error creating file task, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    return CFE_SUCCESS;
+}
@@ -0,0 +1,168 @@
+#include "security_app_provider.h"
+
+#if (SECURITY_APP_WITH_GCRYPT == 1)
+
+#include <string.h>
+#include <gcrypt.h>
+
+#define AES_BLOCK_SIZE 16
+
+/*
+** libgcrypt provider: every suite
+*/
+typedef struct {
+    int algo;
+    int mode;
+} gcrypt_suite_t;
+
+static const gcrypt_suite_t gcrypt_suites[SECURITY_APP_SUITE_COUNT] = {
+    [SECURITY_APP_SUITE_AES256_CBC]        = { GCRY_CIPHER_AES256,   GCRY_CIPHER_MODE_CBC },
+    [SECURITY_APP_SUITE_AES256_CTR]        = { GCRY_CIPHER_AES256,   GCRY_CIPHER_MODE_CTR },
+    [SECURITY_APP_SUITE_AES256_GCM]        = { GCRY_CIPHER_AES256,   GCRY_CIPHER_MODE_GCM },
+    [SECURITY_APP_SUITE_CHACHA20_POLY1305] = { GCRY_CIPHER_CHACHA20, GCRY_CIPHER_MODE_POLY1305 },
+    /* Authenticate-only: the AEAD modes above with all data fed as associated data */
+    [SECURITY_APP_SUITE_AES256_GMAC]       = { GCRY_CIPHER_AES256,   GCRY_CIPHER_MODE_GCM },
+    [SECURITY_APP_SUITE_POLY1305]          = { GCRY_CIPHER_CHACHA20, GCRY_CIPHER_MODE_POLY1305 },
+};
+
+/* The handle and the mode it was opened with, which start needs */
+typedef struct {
+    gcry_cipher_hd_t handle;
+    int              mode;
+} gcrypt_ctx_t;
+
+static gcrypt_ctx_t gcrypt_ctx[SECURITY_APP_PROVIDER_CONTEXTS];
+static uint8_t      gcrypt_in_use[SECURITY_APP_PROVIDER_CONTEXTS];
+
+static int SECURITY_APP_GcryptAvailable(void)
+{
+    return 1;
+}
+
+static int32_t SECURITY_APP_GcryptInit(void)
+{
+    if (!gcry_check_version(GCRYPT_VERSION)) {
+        return -1;
+    }
+
+    gcry_control(GCRYCTL_DISABLE_SECMEM, 0);
+    gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+
+    return 0;
+}
+
+static int SECURITY_APP_GcryptSupports(uint8_t suite)
+{
+    return suite < SECURITY_APP_SUITE_COUNT;
+}
+
+static void SECURITY_APP_GcryptClose(void *ctx)
+{
+    gcrypt_ctx_t *gctx = ctx;
+
+    gcry_cipher_close(gctx->handle);
+    __atomic_store_n(&gcrypt_in_use[gctx - gcrypt_ctx], 0, __ATOMIC_RELEASE);
+}
+
+static void *SECURITY_APP_GcryptOpen(uint8_t suite, const uint8_t *key)
+{
+    const gcrypt_suite_t *info = &gcrypt_suites[suite];
+    gcrypt_ctx_t *gctx;
+    int index;
+
+    index = SECURITY_APP_ClaimContext(gcrypt_in_use, SECURITY_APP_PROVIDER_CONTEXTS);
+    if (index < 0) {
+        return NULL;
+    }
+    gctx = &gcrypt_ctx[index];
+
+    if (gcry_cipher_open(&gctx->handle, info->algo, info->mode, 0)) {
+        __atomic_store_n(&gcrypt_in_use[index], 0, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    /* Expand the key schedule once; the per-message path only resets the IV */
+    if (gcry_cipher_setkey(gctx->handle, key, SECURITY_APP_KEY_SIZE)) {
+        SECURITY_APP_GcryptClose(gctx);
+        return NULL;
+    }
+
+    gctx->mode = info->mode;
+
+    return gctx;
+}
+
+static int SECURITY_APP_GcryptStart(void *ctx, const uint8_t *iv)
+{
+    gcrypt_ctx_t *gctx = ctx;
+    uint8_t counter[AES_BLOCK_SIZE];
+
+    switch (gctx->mode) {
+        case GCRY_CIPHER_MODE_CBC:
+            /* 96 random bits followed by zeros */
+            return gcry_cipher_setiv(gctx->handle, iv, AES_BLOCK_SIZE) != 0;
+
+        case GCRY_CIPHER_MODE_CTR:
+            /* 96-bit nonce followed by a 32-bit block counter starting at zero */
+            memcpy(counter, iv, 12);
+            memset(counter + 12, 0, AES_BLOCK_SIZE - 12);
+            return gcry_cipher_setctr(gctx->handle, counter, AES_BLOCK_SIZE) != 0;
+
+        default:
+            /* AEAD modes: clear the previous message's tag state, key is kept */
+            gcry_cipher_reset(gctx->handle);
+            return gcry_cipher_setiv(gctx->handle, iv, 12) != 0;
+    }
+}
+
+static int SECURITY_APP_GcryptEncrypt(void *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    return gcry_cipher_encrypt(((gcrypt_ctx_t *)ctx)->handle, out, len, in, len) != 0;
+}
+
+static int SECURITY_APP_GcryptDecrypt(void *ctx, uint8_t *out, const uint8_t *in, size_t len)
+{
+    return gcry_cipher_decrypt(((gcrypt_ctx_t *)ctx)->handle, out, len, in, len) != 0;
+}
+
+static int SECURITY_APP_GcryptAuthenticate(void *ctx, const uint8_t *data, size_t len)
+{
+    return gcry_cipher_authenticate(((gcrypt_ctx_t *)ctx)->handle, data, len) != 0;
+}
+
+static int SECURITY_APP_GcryptGetTag(void *ctx, uint8_t *tag, size_t len)
+{
+    return gcry_cipher_gettag(((gcrypt_ctx_t *)ctx)->handle, tag, len) != 0;
+}
+
+static int SECURITY_APP_GcryptCheckTag(void *ctx, const uint8_t *tag, size_t len)
+{
+    return gcry_cipher_checktag(((gcrypt_ctx_t *)ctx)->handle, tag, len) != 0;
+}
+
+static int SECURITY_APP_GcryptRandom(uint8_t *buf, size_t len)
+{
+    gcry_randomize(buf, len, GCRY_STRONG_RANDOM);
+
+    return 0;
+}
+
+const security_app_provider_t SECURITY_APP_GcryptProvider = {
+    "gcrypt",
+    SECURITY_APP_PROVIDER_GCRYPT,
+    SECURITY_APP_GcryptAvailable,
+    SECURITY_APP_GcryptInit,
+    SECURITY_APP_GcryptSupports,
+    SECURITY_APP_GcryptOpen,
+    SECURITY_APP_GcryptClose,
+    SECURITY_APP_GcryptStart,
+    SECURITY_APP_GcryptEncrypt,
+    SECURITY_APP_GcryptDecrypt,
+    SECURITY_APP_GcryptAuthenticate,
+    SECURITY_APP_GcryptGetTag,
+    SECURITY_APP_GcryptCheckTag,
+    SECURITY_APP_GcryptRandom,
+    NULL,
+};
+
+#endif /* SECURITY_APP_WITH_GCRYPT */
@@ -0,0 +1,161 @@
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include "security_app_events.h"
+#include "security_app_replay.h"
+
+/* Check a candidate key table before cFE TBL accepts it */
+int32 SECURITY_APP_ValidateKeyTbl(void *TblData)
+{
+    const SECURITY_APP_KeyTbl_t *Tbl = (const SECURITY_APP_KeyTbl_t *)TblData;
+    const SECURITY_APP_KeyEntry_t *Entry;
+    uint8 Bits;
+    uint16 i;
+    uint16 j;
+
+    for (i = 0; i < SECURITY_APP_MAX_KEYS; i++)
+    {
+        Entry = &Tbl->Entries[i];
+        if (Entry->Enabled > 1)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_KEY_ERR_EID, CFE_EVS_ERROR,
+                             "Key table entry %d: invalid enabled flag %d", i, Entry->Enabled);
+            return SECURITY_APP_ERROR;
+        }
+
+        if (!Entry->Enabled)
+        {
+            continue;
+        }
+
+        /* An all-zero key is an unfilled entry, not a key */
+        Bits = 0;
+        for (j = 0; j < sizeof(Entry->Key); j++)
+        {
+            Bits |= Entry->Key[j];
+        }
+        if (Bits == 0)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_KEY_ERR_EID, CFE_EVS_ERROR,
+                             "Key table entry %d: enabled with an all-zero key", i);
+            return SECURITY_APP_ERROR;
+        }
+    }
+
+    return CFE_SUCCESS;
+}
+
+/*
+** Bring the crypto layer's keys in line with the table. Only changed
+** entries are reloaded. A key whose previous bank is still in use stays on
+** the current key and is retried on the next housekeeping cycle.
+*/
+static void SECURITY_APP_ApplyKeyTbl(void)
+{
+    SECURITY_APP_KeyTbl_t *Tbl;
+    const SECURITY_APP_KeyEntry_t *Entry;
+    uint8 KeyId;
+    bool Replacing;
+    int32 status;
+
+    SECURITY_APP_Data.KeyRetryPending = FALSE;
+
+    status = CFE_TBL_GetAddress((void **)&Tbl, SECURITY_APP_Data.KeyTblHandle);
+    if (status != CFE_SUCCESS && status != CFE_TBL_INFO_UPDATED)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_KEY_ERR_EID, CFE_EVS_ERROR,
+                         "Error getting key table address, RC = 0x%08X", (unsigned int)status);
+        return;
+    }
+
+    for (KeyId = 0; KeyId < SECURITY_APP_MAX_KEYS; KeyId++)
+    {
+        Entry = &Tbl->Entries[KeyId];
+
+        if (!Entry->Enabled)
+        {
+            if (SECURITY_APP_KeyLoaded(KeyId))
+            {
+                SECURITY_APP_UnloadKey(KeyId);
+                SECURITY_APP_ReplayReset(KeyId);
+                CFE_EVS_SendEvent(SECURITY_APP_KEY_INF_EID, CFE_EVS_INFORMATION,
+                                 "SECURITY_APP: Key ID %d taken out of service", KeyId);
+            }
+            continue;
+        }
+
+        Replacing = SECURITY_APP_KeyLoaded(KeyId);
+        if (Replacing && SECURITY_APP_KeyMatches(KeyId, Entry->Key))
+        {
+            continue;
+        }
+
+        status = SECURITY_APP_LoadKey(KeyId, Entry->Key);
+        if (status == -9)
+        {
+            SECURITY_APP_Data.KeyRetryPending = TRUE;
+        }
+        else if (status != 0)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_KEY_ERR_EID, CFE_EVS_ERROR,
+                             "SECURITY_APP: Loading key ID %d failed with error: %d", KeyId, (int)status);
+        }
+        else
+        {
+            /*
+            ** A new key starts a new sequence space on both sides. A key ID
+            ** with nothing loaded keeps the numbers SECURITY_APP_InitReplay
+            ** restored, which may belong to this same key.
+            */
+            if (Replacing)
+            {
+                SECURITY_APP_ReplayReset(KeyId);
+            }
+            CFE_EVS_SendEvent(SECURITY_APP_KEY_INF_EID, CFE_EVS_INFORMATION,
+                             "SECURITY_APP: Key ID %d loaded", KeyId);
+        }
+    }
+
+    CFE_TBL_ReleaseAddress(SECURITY_APP_Data.KeyTblHandle);
+}
+
+/* Register and load the key table, then put its keys in service */
+int32 SECURITY_APP_InitKeyTbl(void)
+{
+    int32 status;
+
+    SECURITY_APP_Data.KeyRetryPending = FALSE;
+
+    status = CFE_TBL_Register(&SECURITY_APP_Data.KeyTblHandle, SECURITY_APP_KEY_TBL_NAME,
+                              sizeof(SECURITY_APP_KeyTbl_t), CFE_TBL_OPT_DEFAULT,
+                              SECURITY_APP_ValidateKeyTbl);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_KEY_ERR_EID, CFE_EVS_ERROR,
+                         "Error registering key table, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    /* Without keys the app still runs; crypto commands fail until a table is loaded */
+    status = CFE_TBL_Load(SECURITY_APP_Data.KeyTblHandle, CFE_TBL_SRC_FILE, SECURITY_APP_KEY_TBL_FILENAME);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_KEY_ERR_EID, CFE_EVS_ERROR,
+                         "Error loading key table %s, RC = 0x%08X",
+                         SECURITY_APP_KEY_TBL_FILENAME, (unsigned int)status);
+        return CFE_SUCCESS;
+    }
+
+    SECURITY_APP_ApplyKeyTbl();
+
+    return CFE_SUCCESS;
+}
+
+/* Let cFE TBL apply pending loads and rotate changed keys in */
+void SECURITY_APP_ManageKeyTbl(void)
+{
+    if (CFE_TBL_Manage(SECURITY_APP_Data.KeyTblHandle) == CFE_TBL_INFO_UPDATED ||
+        SECURITY_APP_Data.KeyRetryPending)
+    {
+        SECURITY_APP_ApplyKeyTbl();
+    }
+}
@@ -0,0 +1,251 @@
+#include "security_app_load.h"
+#include "security_app_events.h"
+#include "security_app_perf.h"
+
+#include <string.h>
+
+#define SECURITY_APP_LOAD_SOURCES      (1 + SECURITY_APP_INLINE_TBL_MAX_ENTRIES)
+#define SECURITY_APP_LOAD_WATERMARK    ((SECURITY_APP_DATA_PIPE_DEPTH * SECURITY_APP_CONGESTION_WATERMARK) / 100)
+
+CompileTimeAssert(SECURITY_APP_LOAD_WATERMARK > 0 && SECURITY_APP_LOAD_WATERMARK <= SECURITY_APP_DATA_PIPE_DEPTH,
+                  CongestionWatermarkInRange);
+
+typedef struct
+{
+    uint32  Arrivals;
+    uint32  LastArrivals;               /* Arrivals at the previous report */
+    uint32  Deferred;
+    uint32  Shed;
+
+} SECURITY_APP_LoadCount_t;
+
+typedef struct
+{
+    uint8   Msg[SECURITY_APP_DEFER_MSG_SIZE] __attribute__((aligned(16)));
+
+} SECURITY_APP_DeferSlot_t;
+
+static struct
+{
+    bool                      Congested;
+    uint16                    Backlog;
+    uint64                    LastReport;
+
+    SECURITY_APP_LoadCount_t  Sources[SECURITY_APP_LOAD_SOURCES];
+
+    /* Deferral queue: Head and Tail count messages in and out */
+    uint32                    Head;
+    uint32                    Tail;
+    SECURITY_APP_DeferSlot_t  Defer[SECURITY_APP_DEFER_DEPTH];
+
+    SECURITY_APP_LoadTlm_t    Tlm;
+
+} SECURITY_APP_Load;
+
+/* Initialize load tracking: not congested, nothing deferred */
+void SECURITY_APP_InitLoad(void)
+{
+    memset(&SECURITY_APP_Load, 0, sizeof(SECURITY_APP_Load));
+    CFE_SB_InitMsg(&SECURITY_APP_Load.Tlm, SECURITY_APP_LOAD_TLM_MID, sizeof(SECURITY_APP_LoadTlm_t), TRUE);
+    SECURITY_APP_Load.LastReport = SECURITY_APP_PerfNow();
+}
+
+/* Clear the per-source counts; deferred messages and the congestion state are kept */
+void SECURITY_APP_ResetLoad(void)
+{
+    memset(SECURITY_APP_Load.Sources, 0, sizeof(SECURITY_APP_Load.Sources));
+    SECURITY_APP_Data.HkTlm.DeferCount = 0;
+    SECURITY_APP_Data.HkTlm.ShedCount = 0;
+}
+
+/* The inline map changed, so inline source counts start over */
+void SECURITY_APP_LoadRefreshSources(void)
+{
+    memset(&SECURITY_APP_Load.Sources[1], 0, sizeof(SECURITY_APP_Load.Sources) - sizeof(SECURITY_APP_Load.Sources[0]));
+}
+
+/* Count the source of a data pipe message and return its priority, or -1 if it has none */
+static int32 SECURITY_APP_LoadSource(CFE_SB_MsgId_t MsgId, SECURITY_APP_LoadCount_t **Source)
+{
+    const SECURITY_APP_InlineEntry_t *Entry;
+
+    if (MsgId == SECURITY_APP_DATA_CMD_MID)
+    {
+        *Source = &SECURITY_APP_Load.Sources[0];
+        return SECURITY_APP_DATA_CMD_PRIORITY;
+    }
+
+    Entry = SECURITY_APP_FindInlineEntry(MsgId);
+    if (Entry == NULL)
+    {
+        return -1;
+    }
+
+    *Source = &SECURITY_APP_Load.Sources[1 + (Entry - SECURITY_APP_Data.InlineMap)];
+    return Entry->Priority;
+}
+
+static void SECURITY_APP_LoadSetCongested(bool Congested)
+{
+    SECURITY_APP_Load.Congested = Congested;
+    SECURITY_APP_Data.HkTlm.Congested = Congested ? 1 : 0;
+
+    if (Congested)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_CONGESTION_INF_EID, CFE_EVS_INFORMATION,
+                         "SECURITY_APP: Data pipe congested, backlog %d; deferring and dropping lower priority traffic",
+                         SECURITY_APP_Load.Backlog);
+    }
+    else
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_CONGESTION_INF_EID, CFE_EVS_INFORMATION,
+                         "SECURITY_APP: Data pipe recovered, %u deferred and %u dropped so far",
+                         (unsigned int)SECURITY_APP_Data.HkTlm.DeferCount,
+                         (unsigned int)SECURITY_APP_Data.HkTlm.ShedCount);
+    }
+
+    /* Producers throttle on this, so it cannot wait for the next HK request */
+    SECURITY_APP_ReportLoad();
+}
+
+/* Copy a message into the deferral queue; FALSE if it is full or the message too big */
+static bool SECURITY_APP_LoadDefer(CFE_SB_MsgPtr_t Msg)
+{
+    SECURITY_APP_DeferSlot_t *Slot;
+    uint16 Length = CFE_SB_GetTotalMsgLength(Msg);
+
+    if (SECURITY_APP_Load.Head - SECURITY_APP_Load.Tail >= SECURITY_APP_DEFER_DEPTH ||
+        Length > SECURITY_APP_DEFER_MSG_SIZE)
+    {
+        return FALSE;
+    }
+
+    Slot = &SECURITY_APP_Load.Defer[SECURITY_APP_Load.Head % SECURITY_APP_DEFER_DEPTH];
+    memcpy(Slot->Msg, Msg, Length);
+    SECURITY_APP_Load.Head++;
+
+    return TRUE;
+}
+
+/*
+** Decide what to do with a message just taken from the data pipe. Returns
+** TRUE if it should be processed now, FALSE if it was deferred or dropped.
+*/
+bool SECURITY_APP_LoadAdmit(CFE_SB_MsgPtr_t Msg)
+{
+    SECURITY_APP_LoadCount_t *Source = NULL;
+    int32 Priority;
+
+    if (SECURITY_APP_Load.Backlog < 0xFFFF)
+    {
+        SECURITY_APP_Load.Backlog++;
+    }
+    if (!SECURITY_APP_Load.Congested && SECURITY_APP_Load.Backlog >= SECURITY_APP_LOAD_WATERMARK)
+    {
+        SECURITY_APP_LoadSetCongested(TRUE);
+    }
+
+    Priority = SECURITY_APP_LoadSource(CFE_SB_GetMsgId(Msg), &Source);
+    if (Priority < 0)
+    {
+        return TRUE;
+    }
+
+    Source->Arrivals++;
+
+    if (!SECURITY_APP_Load.Congested || Priority == SECURITY_APP_PRIO_CRITICAL)
+    {
+        return TRUE;
+    }
+
+    if (Priority == SECURITY_APP_PRIO_NORMAL && SECURITY_APP_LoadDefer(Msg))
+    {
+        Source->Deferred++;
+        SECURITY_APP_Data.HkTlm.DeferCount++;
+        return FALSE;
+    }
+
+    Source->Shed++;
+    SECURITY_APP_Data.HkTlm.ShedCount++;
+    return FALSE;
+}
+
+/* The data pipe was found empty */
+void SECURITY_APP_LoadPipeEmpty(void)
+{
+    SECURITY_APP_Load.Backlog = 0;
+
+    if (SECURITY_APP_Load.Congested && SECURITY_APP_Load.Head == SECURITY_APP_Load.Tail)
+    {
+        SECURITY_APP_LoadSetCongested(FALSE);
+    }
+}
+
+/* Messages waiting in the deferral queue */
+uint16 SECURITY_APP_LoadDeferred(void)
+{
+    return (uint16)(SECURITY_APP_Load.Head - SECURITY_APP_Load.Tail);
+}
+
+/* Take the oldest deferred message; it stays valid until the next message is deferred */
+bool SECURITY_APP_LoadTakeDeferred(CFE_SB_MsgPtr_t *Msg)
+{
+    if (SECURITY_APP_Load.Head == SECURITY_APP_Load.Tail)
+    {
+        return FALSE;
+    }
+
+    *Msg = (CFE_SB_MsgPtr_t)SECURITY_APP_Load.Defer[SECURITY_APP_Load.Tail % SECURITY_APP_DEFER_DEPTH].Msg;
+    SECURITY_APP_Load.Tail++;
+
+    return TRUE;
+}
+
+/* Send load telemetry, with arrival rates over the time since the last one */
+void SECURITY_APP_ReportLoad(void)
+{
+    SECURITY_APP_LoadTlm_t *Tlm = &SECURITY_APP_Load.Tlm;
+    SECURITY_APP_LoadCount_t *Count;
+    SECURITY_APP_LoadSource_t *Source;
+    uint64 Now = SECURITY_APP_PerfNow();
+    uint64 Elapsed = Now - SECURITY_APP_Load.LastReport;
+    uint16 i;
+
+    Tlm->Congested = SECURITY_APP_Load.Congested ? 1 : 0;
+    Tlm->SourceCount = 1 + SECURITY_APP_Data.InlineCount;
+    Tlm->Backlog = SECURITY_APP_Load.Backlog;
+    Tlm->Watermark = SECURITY_APP_LOAD_WATERMARK;
+    Tlm->DeferQueued = SECURITY_APP_LoadDeferred();
+    Tlm->DeferCount = SECURITY_APP_Data.HkTlm.DeferCount;
+    Tlm->ShedCount = SECURITY_APP_Data.HkTlm.ShedCount;
+
+    for (i = 0; i < Tlm->SourceCount; i++)
+    {
+        Count = &SECURITY_APP_Load.Sources[i];
+        Source = &Tlm->Sources[i];
+
+        if (i == 0)
+        {
+            Source->MsgId = SECURITY_APP_DATA_CMD_MID;
+            Source->Priority = SECURITY_APP_DATA_CMD_PRIORITY;
+        }
+        else
+        {
+            Source->MsgId = SECURITY_APP_Data.InlineMap[i - 1].InputMsgID;
+            Source->Priority = SECURITY_APP_Data.InlineMap[i - 1].Priority;
+        }
+
+        Source->ArrivalRate = (Elapsed != 0) ? (uint32)(((uint64)(Count->Arrivals - Count->LastArrivals) *
+                                                         CFE_PSP_GetTimerTicksPerSecond()) / Elapsed) : 0;
+        Source->Arrivals = Count->Arrivals;
+        Source->Deferred = Count->Deferred;
+        Source->Shed = Count->Shed;
+
+        Count->LastArrivals = Count->Arrivals;
+    }
+
+    SECURITY_APP_Load.LastReport = Now;
+
+    CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)Tlm);
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)Tlm);
+}
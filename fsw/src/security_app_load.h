@@ -0,0 +1,34 @@
+#ifndef SECURITY_APP_LOAD_H
+#define SECURITY_APP_LOAD_H
+
+#include "security_app.h"
+
+/*
+** Data pipe load shedding
+**
+** cFE does not report how full a pipe is, so the backlog is estimated as the
+** number of messages taken from the data pipe since it was last found empty:
+** all of them arrived while the app was still busy. Once that reaches
+** SECURITY_APP_CONGESTION_WATERMARK percent of the pipe depth the pipe is
+** congested, and each arriving message is handled by its source's priority
+** (SECURITY_APP_PRIO_*): critical ones at once, normal ones copied to a
+** deferral queue that is worked off whenever the pipe runs dry, low ones
+** dropped. Normal messages that find the queue full, or do not fit a queue
+** slot, are dropped too. Congestion ends when the pipe is empty and nothing
+** is left deferred, so a normal stream is never reordered.
+**
+** Sources are the data command MID (SECURITY_APP_DATA_CMD_PRIORITY) and the
+** active inline table entries. Every change of congestion state is published
+** at once in a SECURITY_APP_LoadTlm_t so producers can throttle; the packet
+** also goes out with housekeeping. All of this runs on the main task.
+*/
+void SECURITY_APP_InitLoad(void);
+void SECURITY_APP_ResetLoad(void);
+void SECURITY_APP_LoadRefreshSources(void);
+bool SECURITY_APP_LoadAdmit(CFE_SB_MsgPtr_t Msg);
+void SECURITY_APP_LoadPipeEmpty(void);
+uint16 SECURITY_APP_LoadDeferred(void);
+bool SECURITY_APP_LoadTakeDeferred(CFE_SB_MsgPtr_t *Msg);
+void SECURITY_APP_ReportLoad(void);
+
+#endif /* SECURITY_APP_LOAD_H */
@@ -2,6 +2,8 @@
 #define SECURITY_APP_MSG_H
 
 #include "cfe.h"
+#include "security_app_platform_cfg.h"
+#include "security_app_crypto.h"
 
 /*
 ** Security App command codes
@@ -10,6 +12,16 @@
 #define SECURITY_APP_RESET_COUNTERS_CC    1
 #define SECURITY_APP_ENCRYPT_CC           2
 #define SECURITY_APP_DECRYPT_CC           3
+#define SECURITY_APP_ENCRYPT_BATCH_CC     4
+#define SECURITY_APP_DECRYPT_BATCH_CC     5
+#define SECURITY_APP_STREAM_BEGIN_CC      6
+#define SECURITY_APP_STREAM_APPEND_CC     7
+#define SECURITY_APP_STREAM_END_CC        8
+#define SECURITY_APP_SIGN_CC              9
+#define SECURITY_APP_VERIFY_CC            10
+#define SECURITY_APP_FILE_ENCRYPT_CC      11
+#define SECURITY_APP_FILE_DECRYPT_CC      12
+#define SECURITY_APP_ACCT_DUMP_CC         13
 
 /*
 ** Type definition (generic "no arguments" command)
@@ -31,41 +43,287 @@ typedef SECURITY_APP_NoArgsCmd_t SECURITY_APP_NoopCmd_t;
 typedef SECURITY_APP_NoArgsCmd_t SECURITY_APP_ResetCountersCmd_t;
 
 /*
-** Type definition (Encryption command)
+** Ciphertext wire format (version 3)
+**
+** Encrypted data travels as a record: a packed SECURITY_APP_WIRE_HDR_SIZE
+** byte header followed by the payload (ciphertext, then the tag for AEAD
+** suites). The header is, by byte offset:
+**
+**   0       version (high nibble) | flags (low nibble)
+**   1       suite (high nibble) | key ID (low nibble)
+**   2-3     plaintext length, big-endian
+**   4-7     sequence number, big-endian
+**   8-19    nonce (CBC IV is the nonce followed by four zero bytes)
+**
+** Flag 0x1 marks a payload that was compressed (LZ4 block format) before
+** encryption; the length field is then the length after decompression.
+**
+** Sequence numbers count up from 1 for each key ID and restart when the key
+** in that key ID is replaced or taken out of service. Across an app restart
+** they carry on from where they were, possibly skipping some numbers (see
+** security_app_replay.h). For suites with a tag, bytes 0-7 are authenticated with
+** the payload, so the sequence number cannot be altered, and the receiver
+** drops any number it has already accepted or that is too far behind the
+** newest (see SECURITY_APP_REPLAY_WINDOW). CBC and CTR records are not
+** checked, since their sequence numbers could be forged.
+**
+** SECURITY_APP_WirePack and SECURITY_APP_WireUnpack convert between this and
+** SECURITY_APP_WireHdr_t. The packets below place the record so that the
+** payload starts on a 16-byte boundary of the packet, and the body of an
+** encrypted telemetry packet can be sent back as-is in a decrypt command.
 */
-#define SECURITY_APP_MAX_DATA_LENGTH 1024
+#define SECURITY_APP_WIRE_VERSION         3
+#define SECURITY_APP_WIRE_HDR_SIZE        20
+#define SECURITY_APP_WIRE_AAD_SIZE        8      /* Header bytes covered by the tag */
+#define SECURITY_APP_WIRE_NONCE_SIZE      12
+#define SECURITY_APP_MAX_DATA_LENGTH      1024
+#define SECURITY_APP_MAX_PAYLOAD_LENGTH   (SECURITY_APP_MAX_DATA_LENGTH + 16)    /* Largest data plus tag */
+#define SECURITY_APP_MAX_RECORD_LENGTH    (SECURITY_APP_WIRE_HDR_SIZE + SECURITY_APP_MAX_PAYLOAD_LENGTH)
 
+/*
+** Encryption options, per command or per inline table entry
+**
+** SECURITY_APP_OPT_COMPRESS compresses the data before it is encrypted. The
+** data is sent raw instead whenever compressing would not shrink the output.
+** Authenticate-only suites ignore it, since signed data must stay readable.
+*/
+#define SECURITY_APP_OPT_COMPRESS         0x01
+#define SECURITY_APP_OPT_KNOWN            (SECURITY_APP_OPT_COMPRESS)
+
+/*
+** Type definition (Encryption command)
+**
+** Data-carrying commands and telemetry are variable length: the packet ends
+** after the last used byte of Data, so Data must stay the final member.
+*/
 typedef struct
 {
     uint8   CmdHeader[CFE_SB_CMD_HDR_SIZE];
     uint16  DataLength;                             /* Length of data to be encrypted */
-    uint8   Data[SECURITY_APP_MAX_DATA_LENGTH];     /* Data to be encrypted */
     uint16  TargetMsgID;                            /* Message ID to use for encrypted output */
+    uint8   Suite;                                  /* Cipher suite (SECURITY_APP_SUITE_*) */
+    uint8   KeyId;                                  /* Key table entry */
+    uint8   Options;                                /* SECURITY_APP_OPT_* flags */
+    uint8   Spare;
+    uint8   Data[SECURITY_APP_MAX_DATA_LENGTH];     /* Data to be encrypted (16-byte aligned) */
 
 } SECURITY_APP_EncryptCmd_t;
 
 /*
 ** Type definition (Decryption command)
+**
+** Record holds a wire format record exactly as published in the body of a
+** SECURITY_APP_EncryptedTlm_t; suite and key ID come from its header.
 */
 typedef struct
 {
     uint8   CmdHeader[CFE_SB_CMD_HDR_SIZE];
-    uint16  DataLength;                             /* Length of data to be decrypted */
-    uint8   Data[SECURITY_APP_MAX_DATA_LENGTH];     /* Data to be decrypted */
+    uint16  DataLength;                             /* Length of Record, header included */
     uint16  TargetMsgID;                            /* Message ID to use for decrypted output */
+    uint8   Record[SECURITY_APP_MAX_RECORD_LENGTH]; /* Record to be decrypted (payload 16-byte aligned) */
 
 } SECURITY_APP_DecryptCmd_t;
 
+/*
+** Type definition (Sign and verify commands)
+**
+** Same layout as encrypt and decrypt, for the authenticate-only suites
+** (SECURITY_APP_SUITE_AES256_GMAC, SECURITY_APP_SUITE_POLY1305). SIGN
+** publishes a record whose payload is the data in the clear followed by the
+** tag; VERIFY checks a record's tag and publishes the data only if it
+** matches. ENCRYPT and DECRYPT refuse these suites so that data asked to be
+** kept secret is never sent in the clear, and SIGN and VERIFY refuse the
+** others. Signed and verified data is counted with encrypted and decrypted
+** data in housekeeping and statistics.
+*/
+typedef SECURITY_APP_EncryptCmd_t SECURITY_APP_SignCmd_t;
+typedef SECURITY_APP_DecryptCmd_t SECURITY_APP_VerifyCmd_t;
+
+/*
+** Type definition (Batch encryption/decryption command)
+**
+** Records holds RecordCount packed records, each a BatchRecordHdr_t followed
+** immediately by DataLength bytes of data (no padding between records).
+** Decrypt records are wire format records and carry their own suite and key
+** ID; Suite and KeyId only apply to encryption. As with ENCRYPT and
+** DECRYPT, an encrypt batch with an authenticate-only Suite is refused and
+** signed records in a decrypt batch are skipped.
+** The command may be shorter than the full structure; only the bytes up to
+** the packet length are used.
+*/
+#define SECURITY_APP_MAX_BATCH_LENGTH 8192
+
+typedef struct
+{
+    uint16  DataLength;                             /* Length of record data */
+    uint16  TargetMsgID;                            /* Message ID to use for this record's output */
+
+} SECURITY_APP_BatchRecordHdr_t;
+
+typedef struct
+{
+    uint8   CmdHeader[CFE_SB_CMD_HDR_SIZE];
+    uint16  RecordCount;                            /* Number of packed records */
+    uint8   Suite;                                  /* Cipher suite for every record (encrypt only) */
+    uint8   KeyId;                                  /* Key table entry for every record (encrypt only) */
+    uint8   Records[SECURITY_APP_MAX_BATCH_LENGTH]; /* Packed records */
+
+} SECURITY_APP_BatchCmd_t;
+
+typedef SECURITY_APP_BatchCmd_t SECURITY_APP_EncryptBatchCmd_t;
+typedef SECURITY_APP_BatchCmd_t SECURITY_APP_DecryptBatchCmd_t;
+
+/*
+** Type definition (Stream session commands)
+**
+** A stream session carries one large product through the cipher as a
+** sequence of segments that share a single IV and cipher state. BEGIN opens
+** a session and reports its SessionId in a SECURITY_APP_StreamTlm_t with
+** the BEGIN flag set. APPEND and END each carry one segment; segments must
+** arrive in SegmentSeq order starting at 0. END closes the session: when
+** encrypting it reports the tag, when decrypting it checks Tag and reports
+** the result in the END packet's flags.
+**
+** Encrypt sessions publish each segment as it is processed. Decrypt
+** sessions publish nothing before END: the plaintext is held until the tag
+** checks, then released in segments of up to SECURITY_APP_MAX_DATA_LENGTH
+** bytes numbered from 0, the last flagged END and AUTH_OK. A stream that
+** fails authentication yields only an END packet flagged AUTH_FAIL with no
+** data. A decrypt session can carry at most SECURITY_APP_STREAM_HOLD_SIZE
+** bytes; larger products go through the file commands.
+*/
+#define SECURITY_APP_STREAM_ENCRYPT       0
+#define SECURITY_APP_STREAM_DECRYPT       1
+
+typedef struct
+{
+    uint8   CmdHeader[CFE_SB_CMD_HDR_SIZE];
+    uint16  TargetMsgID;                            /* Message ID for this session's output */
+    uint8   Suite;                                  /* Counter-based cipher suite (SECURITY_APP_SUITE_*) */
+    uint8   Direction;                              /* SECURITY_APP_STREAM_ENCRYPT or _DECRYPT */
+    uint8   KeyId;                                  /* Key table entry */
+    uint8   Spare;
+    uint8   IV[16];                                 /* Sender's IV (decrypt sessions only) */
+
+} SECURITY_APP_StreamBeginCmd_t;
+
+typedef struct
+{
+    uint8   CmdHeader[CFE_SB_CMD_HDR_SIZE];
+    uint8   SessionId;                              /* Session from the BEGIN response */
+    uint8   Spare;
+    uint16  SegmentSeq;                             /* Segment sequence number */
+    uint16  DataLength;                             /* Length of segment data */
+    uint16  Spare2;
+    uint8   Tag[16];                                /* Expected tag (decrypt END only) */
+    uint8   Data[SECURITY_APP_MAX_DATA_LENGTH];     /* Segment data */
+
+} SECURITY_APP_StreamDataCmd_t;
+
+typedef SECURITY_APP_StreamDataCmd_t SECURITY_APP_StreamAppendCmd_t;
+typedef SECURITY_APP_StreamDataCmd_t SECURITY_APP_StreamEndCmd_t;
+
+/*
+** Type definition (File encryption/decryption commands)
+**
+** Encrypts or decrypts a whole file on the file task, one file at a time.
+** Progress and throughput are reported in housekeeping and the result in a
+** SECURITY_APP_FILE_INF_EID or SECURITY_APP_FILE_ERR_EID event. Only the
+** counter-based encrypting suites can be used. Suite and KeyId apply to
+** encryption only; decryption takes them from the file header.
+**
+** An encrypted file is a SECURITY_APP_FILE_HDR_SIZE byte header, the
+** ciphertext (as long as the plaintext) and the tag, if the suite has one.
+** The header is, by byte offset:
+**
+**   0-3     magic "SAFE"
+**   4       format version
+**   5       suite (high nibble) | key ID (low nibble)
+**   6-7     reserved, zero
+**   8-11    plaintext length, big-endian
+**   12-15   reserved, zero
+**   16-27   nonce
+**   28-31   reserved, zero
+**
+** Decrypted data is written out before the tag at the end of the file can
+** be checked; the output file is removed if the check fails.
+*/
+#define SECURITY_APP_FILE_MAGIC           "SAFE"
+#define SECURITY_APP_FILE_VERSION         1
+#define SECURITY_APP_FILE_HDR_SIZE        32
+
+typedef struct
+{
+    uint8   CmdHeader[CFE_SB_CMD_HDR_SIZE];
+    char    InputFile[OS_MAX_PATH_LEN];             /* File to read */
+    char    OutputFile[OS_MAX_PATH_LEN];            /* File to create (replaced if it exists) */
+    uint8   Suite;                                  /* Counter-based cipher suite (encrypt only) */
+    uint8   KeyId;                                  /* Key table entry (encrypt only) */
+    uint16  Spare;
+
+} SECURITY_APP_FileCmd_t;
+
+typedef SECURITY_APP_FileCmd_t SECURITY_APP_FileEncryptCmd_t;
+typedef SECURITY_APP_FileCmd_t SECURITY_APP_FileDecryptCmd_t;
+
+/*
+** Type definition (Per-stream accounting dump command)
+**
+** Reports the Count busiest target message IDs by the SortBy measure (both
+** operations added together), or the whole table when Count is 0. With an
+** empty File the entries go out in a SECURITY_APP_AcctTlm_t; otherwise File
+** is written with a cFE file header followed by the body of that packet
+** (everything after its telemetry header).
+*/
+#define SECURITY_APP_ACCT_SORT_OPS        0
+#define SECURITY_APP_ACCT_SORT_BYTES      1
+#define SECURITY_APP_ACCT_SORT_ERRORS     2
+#define SECURITY_APP_ACCT_SORT_TICKS      3
+
+typedef struct
+{
+    uint8   CmdHeader[CFE_SB_CMD_HDR_SIZE];
+    uint16  Count;                                  /* Entries to report, 0 for all */
+    uint8   SortBy;                                 /* SECURITY_APP_ACCT_SORT_* */
+    uint8   Spare;
+    char    File[OS_MAX_PATH_LEN];                  /* Dump file, or empty for telemetry */
+
+} SECURITY_APP_AcctDumpCmd_t;
+
+/*
+** Type definition (Stream segment telemetry)
+*/
+#define SECURITY_APP_STREAM_FLAG_BEGIN      0x01    /* Session opened; IV is valid */
+#define SECURITY_APP_STREAM_FLAG_END        0x02    /* Session closed; Tag is valid when encrypting */
+#define SECURITY_APP_STREAM_FLAG_AUTH_OK    0x04    /* Decrypt session tag verified */
+#define SECURITY_APP_STREAM_FLAG_AUTH_FAIL  0x08    /* Decrypt session tag rejected */
+
+typedef struct
+{
+    uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
+    uint8    SessionId;
+    uint8    Flags;                                  /* SECURITY_APP_STREAM_FLAG_* */
+    uint16   SegmentSeq;
+    uint16   DataLength;                             /* Length of segment data */
+    uint8    Suite;
+    uint8    Direction;
+    uint32   TotalLength;                            /* Bytes processed so far in this session */
+    uint8    IV[16];
+    uint8    Tag[16];
+    uint8    Spare[8];
+    uint8    Data[SECURITY_APP_MAX_DATA_LENGTH];     /* 16-byte aligned */
+
+} SECURITY_APP_StreamTlm_t;
+
 /*
 ** Type definition (Encrypted data telemetry)
+**
+** Record is one wire format record; the packet length gives its size.
 */
 typedef struct
 {
     uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
-    uint32   OriginalDataLength;                     /* Original data length before encryption */
-    uint16   EncryptedDataLength;                    /* Length of encrypted data */
-    uint8    IV[16];                                 /* Initialization Vector */
-    uint8    EncryptedData[SECURITY_APP_MAX_DATA_LENGTH]; /* Encrypted data */
+    uint8    Record[SECURITY_APP_MAX_RECORD_LENGTH]; /* Wire header, then payload (16-byte aligned) */
 
 } SECURITY_APP_EncryptedTlm_t;
 
@@ -76,13 +334,19 @@ typedef struct
 {
     uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
     uint16   DataLength;                             /* Length of decrypted data */
-    uint8    Data[SECURITY_APP_MAX_DATA_LENGTH];     /* Decrypted data */
+    uint16   Spare;
+    uint8    Data[SECURITY_APP_MAX_DATA_LENGTH];     /* Decrypted data (16-byte aligned) */
 
 } SECURITY_APP_DecryptedTlm_t;
 
 /*
 ** Type definition (housekeeping)
 */
+#define SECURITY_APP_FILE_IDLE            0       /* No file processed yet */
+#define SECURITY_APP_FILE_BUSY            1       /* A file is being processed */
+#define SECURITY_APP_FILE_DONE            2       /* Last file completed */
+#define SECURITY_APP_FILE_FAILED          3       /* Last file failed */
+
 typedef struct
 {
     uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
@@ -93,7 +357,183 @@ typedef struct
     uint32   DecryptionCount;
     uint32   EncryptionErrorCount;
     uint32   DecryptionErrorCount;
+    uint32   NonceRefillCount;                       /* IV ring refills */
+    uint32   NonceUnderflowCount;                    /* IVs generated inline because a ring was empty */
+    uint32   VerifyFailCount;                        /* Signed records rejected for a bad tag */
+    uint32   ReplayRejectCount;                      /* Records dropped as replays */
+    uint8    FileState;                              /* SECURITY_APP_FILE_* state of the file task */
+    uint8    FileOperation;                          /* SECURITY_APP_OP_* of the current or last file */
+    uint8    spare2[2];
+    uint32   FileBytesDone;                          /* Bytes of the current or last file processed */
+    uint32   FileBytesTotal;                         /* Length of the current or last file */
+    uint32   FileRate;                               /* Throughput of the current or last file, bytes/s */
+    uint8    Congested;                              /* 1 while the data pipe is congested */
+    uint8    spare3[3];
+    uint32   DeferCount;                             /* Data pipe messages deferred under congestion */
+    uint32   ShedCount;                              /* Data pipe messages dropped under congestion */
+    uint8    CryptoProvider[SECURITY_APP_SUITE_COUNT];  /* SECURITY_APP_PROVIDER_* serving each suite */
+    uint8    SelfTestFailMask;                       /* Bit n set if a provider failed suite n's self-test */
+    uint8    spare4;
 
 } SECURITY_APP_HkTlm_t;
 
+/*
+** Error categories broken out in the statistics packet
+*/
+#define SECURITY_APP_STAT_ERR_LENGTH      0   /* Bad data or command length */
+#define SECURITY_APP_STAT_ERR_SUITE       1   /* Unknown cipher suite */
+#define SECURITY_APP_STAT_ERR_BUFFER      2   /* No SB buffer for the output */
+#define SECURITY_APP_STAT_ERR_CIPHER      3   /* Cipher library failure */
+#define SECURITY_APP_STAT_ERR_AUTH        4   /* Authentication tag mismatch */
+#define SECURITY_APP_STAT_ERR_SESSION     5   /* Unknown stream session or out-of-order segment */
+#define SECURITY_APP_STAT_ERR_KEY         6   /* No key loaded for the key ID */
+#define SECURITY_APP_STAT_ERR_FORMAT      7   /* Unknown wire format version or flags */
+#define SECURITY_APP_STAT_ERR_REPLAY      8   /* Sequence number already seen or too old */
+#define SECURITY_APP_STAT_ERR_IO          9   /* File open, read or write failure */
+#define SECURITY_APP_STAT_ERR_COUNT       10
+
+/*
+** Type definition (crypto statistics)
+**
+** Totals since the previous statistics packet. The first index of each array
+** is the operation: 0 for encrypt, 1 for decrypt.
+*/
+typedef struct
+{
+    uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
+    uint32   Operations[2];                          /* Successful operations */
+    uint32   Bytes[2];                               /* Plaintext bytes processed */
+    uint32   Errors[2][SECURITY_APP_STAT_ERR_COUNT]; /* Failures by category */
+
+} SECURITY_APP_StatsTlm_t;
+
+/*
+** Performance histogram layout
+**
+** Latencies fall in bucket floor(log2(ticks)), with the last bucket
+** collecting everything longer. Payload sizes are classed as up to 64, 256
+** and 1024 bytes, and larger.
+*/
+#define SECURITY_APP_PERF_SIZE_CLASSES    4
+#define SECURITY_APP_PERF_LATENCY_BUCKETS 24
+
+/*
+** Min/max/mean of one timed activity, in timebase ticks
+*/
+typedef struct
+{
+    uint32   Count;
+    uint32   MinTicks;
+    uint32   MaxTicks;
+    uint32   MeanTicks;
+
+} SECURITY_APP_PerfTiming_t;
+
+/*
+** Type definition (performance telemetry)
+**
+** Cumulative since startup or the last reset counters command. The first
+** index of the per-operation arrays is 0 for encrypt, 1 for decrypt; the
+** per-pipe arrays are indexed 0 for the control pipe, 1 for the data pipe.
+** A message's pipe wait is measured from the last time the main loop found
+** that pipe empty, so it is an upper bound on the real queueing time. The
+** cycle fields are only updated in scheduler-driven mode.
+*/
+typedef struct
+{
+    uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
+    uint32   TicksPerSecond;                         /* Timebase rate */
+    uint16   PipeHighWater[2];                       /* Most messages taken from each pipe before it ran empty */
+    uint16   PipeDepth[2];                           /* Configured depth of each pipe */
+    SECURITY_APP_PerfTiming_t  PipeWait[2];          /* Bound on time a message sat in each pipe */
+    SECURITY_APP_PerfTiming_t  Command;              /* Whole command handling */
+    SECURITY_APP_PerfTiming_t  Cycle;                /* Time spent per scheduler wakeup */
+    uint16   CycleOpBudget;                          /* Configured messages per wakeup */
+    uint16   CycleLastOps;                           /* Messages handled on the last wakeup */
+    uint16   CycleMaxOps;                            /* Most messages handled on one wakeup */
+    uint16   spare;
+    uint32   CycleByteBudget;                        /* Configured message bytes per wakeup */
+    uint32   CycleLastBytes;                         /* Message bytes handled on the last wakeup */
+    uint32   CycleMaxBytes;                          /* Most message bytes handled on one wakeup */
+    uint32   CycleBudgetHits;                        /* Wakeups that stopped on the budget */
+    SECURITY_APP_PerfTiming_t  Crypto[2];            /* Cipher calls only */
+    uint32   Bytes[2];                               /* Plaintext bytes through the cipher */
+    SECURITY_APP_PerfTiming_t  Compress;             /* Compression attempts, raw fallbacks included */
+    SECURITY_APP_PerfTiming_t  Decompress;           /* Decompression of received payloads */
+    uint32   CompressBytesIn;                        /* Bytes offered to the compressor */
+    uint32   CompressBytesOut;                       /* Bytes encrypted in their place */
+    uint32   CompressRawCount;                       /* Attempts sent raw because compressing did not help */
+    uint32   CompressRatio;                          /* CompressBytesOut per 1000 CompressBytesIn */
+    uint32   Histogram[2][SECURITY_APP_PERF_SIZE_CLASSES][SECURITY_APP_PERF_LATENCY_BUCKETS];
+
+} SECURITY_APP_PerfTlm_t;
+
+/*
+** Type definition (data pipe load telemetry)
+**
+** Sent whenever the data pipe becomes congested or recovers, and with every
+** housekeeping packet. Source 0 is the data command MID; the rest are the
+** active inline table entries in table order. Counts are cumulative since
+** startup or the last reset counters command (or, for inline sources, the
+** last inline table load).
+*/
+typedef struct
+{
+    uint16   MsgId;                                  /* Input message ID */
+    uint8    Priority;                               /* SECURITY_APP_PRIO_* */
+    uint8    Spare;
+    uint32   ArrivalRate;                            /* Messages per second since the last report */
+    uint32   Arrivals;
+    uint32   Deferred;
+    uint32   Shed;
+
+} SECURITY_APP_LoadSource_t;
+
+typedef struct
+{
+    uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
+    uint8    Congested;                              /* 1 while the data pipe is congested */
+    uint8    SourceCount;                            /* Valid entries in Sources */
+    uint16   Backlog;                                /* Estimated data pipe backlog */
+    uint16   Watermark;                              /* Backlog at which congestion starts */
+    uint16   DeferQueued;                            /* Messages waiting in the deferral queue */
+    uint32   DeferCount;                             /* Messages deferred */
+    uint32   ShedCount;                              /* Messages dropped */
+    SECURITY_APP_LoadSource_t  Sources[1 + SECURITY_APP_INLINE_TBL_MAX_ENTRIES];
+
+} SECURITY_APP_LoadTlm_t;
+
+/*
+** Type definition (per-stream accounting telemetry)
+**
+** Totals for one target message ID since it was first seen or the last reset
+** counters command, indexed 0 for encrypt (and sign), 1 for decrypt (and
+** verify). Ticks is the timebase time spent on the stream's records from
+** validation to the finished output packet, split into two words.
+*/
+typedef struct
+{
+    uint16   MsgId;
+    uint16   Spare;
+    uint32   Ops[2];                                 /* Records processed successfully */
+    uint32   Bytes[2];                               /* Plaintext bytes of those records */
+    uint32   Errors[2];                              /* Records rejected or failed */
+    uint32   TicksHigh;                              /* Cumulative processing time, upper 32 bits */
+    uint32   TicksLow;                               /* Cumulative processing time, lower 32 bits */
+
+} SECURITY_APP_AcctEntry_t;
+
+/*
+** The packet ends after the last entry reported
+*/
+typedef struct
+{
+    uint8    TlmHeader[CFE_SB_TLM_HDR_SIZE];
+    uint16   EntryCount;                             /* Entries in this packet */
+    uint16   TrackedCount;                           /* Message IDs in the table */
+    uint32   UntrackedCount;                         /* Records whose message ID found the table full */
+    SECURITY_APP_AcctEntry_t  Entries[SECURITY_APP_ACCT_TBL_SIZE];
+
+} SECURITY_APP_AcctTlm_t;
+
 #endif /* SECURITY_APP_MSG_H */
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include "security_app_events.h"
+
+/*
+** IV refill task
+**
+** Runs at low priority and tops up the crypto layer's IV rings whenever a
+** ring reaches its low-water mark, and periodically otherwise, so the
+** strong-random generator stays off the encrypt path.
+*/
+static uint32 SECURITY_APP_NonceSemId;
+static uint32 SECURITY_APP_NonceTaskId;
+
+/*
+** Counter nonce store
+**
+** Keeps each crypto channel's nonce salt and reserved counter limit in a
+** critical data store block, so that a restarted app resumes every channel
+** past anything it may have used under the same keys. The block is written
+** whole; the semaphore keeps channels saving at once from interleaving.
+*/
+typedef struct
+{
+    uint8   Salt[SECURITY_APP_NONCE_SALT_SIZE];
+    uint8   Spare[3];
+    uint64  Limit;                          /* Highest counter value that may have been used, 0 = none */
+
+} SECURITY_APP_NonceCdsEntry_t;
+
+static struct
+{
+    SECURITY_APP_NonceCdsEntry_t  Cds[SECURITY_APP_CRYPTO_CHANNELS];
+    CFE_ES_CDSHandle_t            CdsHandle;
+    uint32                        CdsSemId;
+
+} SECURITY_APP_NonceStore;
+
+/* Called from the crypto hot path; only wakes the refill task */
+static void SECURITY_APP_NonceLow(void)
+{
+    OS_BinSemGive(SECURITY_APP_NonceSemId);
+}
+
+/* IV refill task entry point */
+void SECURITY_APP_NonceTaskMain(void)
+{
+    int32 status;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    for (;;)
+    {
+        status = OS_BinSemTimedWait(SECURITY_APP_NonceSemId, SECURITY_APP_NONCE_REFILL_PERIOD_MS);
+        if (status != OS_SUCCESS && status != OS_SEM_TIMEOUT)
+        {
+            break;
+        }
+
+        SECURITY_APP_NonceRefill();
+    }
+
+    CFE_ES_ExitChildTask();
+}
+
+/* Save one channel's salt and limit; called by the crypto layer before the limit is used */
+static int SECURITY_APP_SaveNonce(uint8_t Channel, const uint8_t *Salt, uint64_t Limit)
+{
+    int32 status;
+
+    OS_BinSemTake(SECURITY_APP_NonceStore.CdsSemId);
+    memcpy(SECURITY_APP_NonceStore.Cds[Channel].Salt, Salt, SECURITY_APP_NONCE_SALT_SIZE);
+    SECURITY_APP_NonceStore.Cds[Channel].Limit = Limit;
+    status = CFE_ES_CopyToCDS(SECURITY_APP_NonceStore.CdsHandle, SECURITY_APP_NonceStore.Cds);
+    OS_BinSemGive(SECURITY_APP_NonceStore.CdsSemId);
+
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_NONCE_ERR_EID, CFE_EVS_ERROR,
+                         "Error saving counter nonces, RC = 0x%08X; using random IVs", (unsigned int)status);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+** Restore the counter nonces from the CDS and hand the crypto layer the
+** store. Without a CDS no store is set and the counter-based suites take
+** random IVs.
+*/
+static void SECURITY_APP_InitNonceStore(void)
+{
+    int32 status;
+    uint8 Channel;
+
+#if (SECURITY_APP_COUNTER_NONCES == 1)
+    memset(&SECURITY_APP_NonceStore, 0, sizeof(SECURITY_APP_NonceStore));
+
+    status = OS_BinSemCreate(&SECURITY_APP_NonceStore.CdsSemId, "SECAPP_NONCE_CDS", 1, 0);
+    if (status == OS_SUCCESS)
+    {
+        status = CFE_ES_RegisterCDS(&SECURITY_APP_NonceStore.CdsHandle, sizeof(SECURITY_APP_NonceStore.Cds),
+                                    SECURITY_APP_NONCE_CDS_NAME);
+    }
+
+    if (status == CFE_ES_CDS_ALREADY_EXISTS)
+    {
+        status = CFE_ES_RestoreFromCDS(SECURITY_APP_NonceStore.Cds, SECURITY_APP_NonceStore.CdsHandle);
+        for (Channel = 0; status == CFE_SUCCESS && Channel < SECURITY_APP_CRYPTO_CHANNELS; Channel++)
+        {
+            if (SECURITY_APP_NonceStore.Cds[Channel].Limit != 0)
+            {
+                SECURITY_APP_RestoreNonce(Channel, SECURITY_APP_NonceStore.Cds[Channel].Salt,
+                                          SECURITY_APP_NonceStore.Cds[Channel].Limit);
+            }
+        }
+    }
+    else if (status == CFE_SUCCESS)
+    {
+        status = CFE_ES_CopyToCDS(SECURITY_APP_NonceStore.CdsHandle, SECURITY_APP_NonceStore.Cds);
+    }
+
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_NONCE_ERR_EID, CFE_EVS_ERROR,
+                         "No critical data store for counter nonces, RC = 0x%08X; using random IVs",
+                         (unsigned int)status);
+        return;
+    }
+
+    SECURITY_APP_SetNonceStore(SECURITY_APP_SaveNonce);
+#else
+    (void)status;
+    (void)Channel;
+#endif
+}
+
+/* Create the refill task, hook it to the crypto layer's low-water signal and set up the nonce store */
+int32 SECURITY_APP_InitNonceTask(void)
+{
+    int32 status;
+
+    status = OS_BinSemCreate(&SECURITY_APP_NonceSemId, "SECAPP_NONCE", 0, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_NONCE_ERR_EID, CFE_EVS_ERROR,
+                         "Error creating IV refill semaphore, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    status = CFE_ES_CreateChildTask(&SECURITY_APP_NonceTaskId, "SECURITY_NONCE",
+                                    SECURITY_APP_NonceTaskMain, NULL, SECURITY_APP_NONCE_TASK_STACK_SIZE,
+                                    SECURITY_APP_NONCE_TASK_PRIORITY, 0);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_NONCE_ERR_EID, CFE_EVS_ERROR,
+                         "Error creating IV refill task, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    SECURITY_APP_SetNonceLowCallback(SECURITY_APP_NonceLow);
+    SECURITY_APP_InitNonceStore();
+
+    return CFE_SUCCESS;
+}
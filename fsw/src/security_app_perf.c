@@ -0,0 +1,350 @@
+#include "security_app_perf.h"
+#include "security_app_crypto.h"
+
+/*
+** Running totals behind one SECURITY_APP_PerfTiming_t
+*/
+typedef struct
+{
+    uint32  Count;
+    uint32  MinTicks;
+    uint32  MaxTicks;
+    uint64  TotalTicks;
+
+} SECURITY_APP_PerfAccum_t;
+
+/*
+** Crypto counters owned by one channel. Epoch lags the global epoch until the
+** owning task clears them after a reset, so a reset never writes into another
+** task's counters.
+*/
+typedef struct
+{
+    uint32                    Epoch;
+    SECURITY_APP_PerfAccum_t  Crypto[2];
+    uint32                    Bytes[2];
+    uint32                    Histogram[2][SECURITY_APP_PERF_SIZE_CLASSES][SECURITY_APP_PERF_LATENCY_BUCKETS];
+    SECURITY_APP_PerfAccum_t  Compress;
+    SECURITY_APP_PerfAccum_t  Decompress;
+    uint32                    CompressBytesIn;
+    uint32                    CompressBytesOut;
+    uint32                    CompressRawCount;
+
+} SECURITY_APP_PerfChannel_t;
+
+/*
+** Queueing counters for one SB pipe (main task only). Run counts messages
+** taken since the pipe was last found empty at LastEmpty.
+*/
+typedef struct
+{
+    uint64                    LastEmpty;
+    uint16                    Run;
+    uint16                    HighWater;
+    SECURITY_APP_PerfAccum_t  Wait;
+
+} SECURITY_APP_PerfPipe_t;
+
+static struct
+{
+    uint32                      Epoch;
+    SECURITY_APP_PerfChannel_t  Channels[SECURITY_APP_CRYPTO_CHANNELS];
+    SECURITY_APP_PerfAccum_t    Command;
+    SECURITY_APP_PerfPipe_t     Pipes[SECURITY_APP_PIPE_COUNT];
+    SECURITY_APP_PerfAccum_t    Cycle;
+    uint16                      CycleLastOps;
+    uint16                      CycleMaxOps;
+    uint32                      CycleLastBytes;
+    uint32                      CycleMaxBytes;
+    uint32                      CycleBudgetHits;
+    SECURITY_APP_PerfTlm_t      Tlm;
+
+} SECURITY_APP_Perf;
+
+/* Add one sample to a running total */
+static void SECURITY_APP_PerfAccumulate(SECURITY_APP_PerfAccum_t *Accum, uint32 Ticks)
+{
+    if (Accum->Count == 0 || Ticks < Accum->MinTicks)
+    {
+        Accum->MinTicks = Ticks;
+    }
+    if (Ticks > Accum->MaxTicks)
+    {
+        Accum->MaxTicks = Ticks;
+    }
+    Accum->TotalTicks += Ticks;
+    Accum->Count++;
+}
+
+/* Fold a running total into its telemetry form */
+static void SECURITY_APP_PerfSummarize(SECURITY_APP_PerfTiming_t *Timing, const SECURITY_APP_PerfAccum_t *Accum)
+{
+    Timing->Count = Accum->Count;
+    Timing->MinTicks = Accum->MinTicks;
+    Timing->MaxTicks = Accum->MaxTicks;
+    Timing->MeanTicks = (Accum->Count != 0) ? (uint32)(Accum->TotalTicks / Accum->Count) : 0;
+}
+
+/* Merge one channel's total into the combined one */
+static void SECURITY_APP_PerfMerge(SECURITY_APP_PerfAccum_t *Into, const SECURITY_APP_PerfAccum_t *From)
+{
+    if (From->Count == 0)
+    {
+        return;
+    }
+    if (Into->Count == 0 || From->MinTicks < Into->MinTicks)
+    {
+        Into->MinTicks = From->MinTicks;
+    }
+    if (From->MaxTicks > Into->MaxTicks)
+    {
+        Into->MaxTicks = From->MaxTicks;
+    }
+    Into->TotalTicks += From->TotalTicks;
+    Into->Count += From->Count;
+}
+
+/* Ticks elapsed since Start, saturated to 32 bits */
+static uint32 SECURITY_APP_PerfElapsed(uint64 Start)
+{
+    uint64 Ticks = SECURITY_APP_PerfNow() - Start;
+
+    return (Ticks > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)Ticks;
+}
+
+/* Initialize performance telemetry */
+void SECURITY_APP_InitPerf(void)
+{
+    memset(&SECURITY_APP_Perf, 0, sizeof(SECURITY_APP_Perf));
+    CFE_SB_InitMsg(&SECURITY_APP_Perf.Tlm, SECURITY_APP_PERF_TLM_MID, sizeof(SECURITY_APP_PerfTlm_t), TRUE);
+    SECURITY_APP_Perf.Pipes[SECURITY_APP_PIPE_CONTROL].LastEmpty = SECURITY_APP_PerfNow();
+    SECURITY_APP_Perf.Pipes[SECURITY_APP_PIPE_DATA].LastEmpty = SECURITY_APP_PerfNow();
+}
+
+/* Start new totals; each channel clears its own counters on its next sample */
+void SECURITY_APP_ResetPerf(void)
+{
+    uint8 Pipe;
+
+    memset(&SECURITY_APP_Perf.Command, 0, sizeof(SECURITY_APP_Perf.Command));
+    memset(&SECURITY_APP_Perf.Cycle, 0, sizeof(SECURITY_APP_Perf.Cycle));
+    SECURITY_APP_Perf.CycleMaxOps = 0;
+    SECURITY_APP_Perf.CycleMaxBytes = 0;
+    SECURITY_APP_Perf.CycleBudgetHits = 0;
+    for (Pipe = 0; Pipe < SECURITY_APP_PIPE_COUNT; Pipe++)
+    {
+        SECURITY_APP_Perf.Pipes[Pipe].HighWater = 0;
+        memset(&SECURITY_APP_Perf.Pipes[Pipe].Wait, 0, sizeof(SECURITY_APP_Perf.Pipes[Pipe].Wait));
+    }
+    __atomic_add_fetch(&SECURITY_APP_Perf.Epoch, 1, __ATOMIC_RELEASE);
+}
+
+/* Get Channel's counters, clearing them first if a reset happened since the last sample */
+static SECURITY_APP_PerfChannel_t *SECURITY_APP_PerfChannel(uint8 Channel)
+{
+    SECURITY_APP_PerfChannel_t *Perf = &SECURITY_APP_Perf.Channels[Channel];
+    uint32 Epoch = __atomic_load_n(&SECURITY_APP_Perf.Epoch, __ATOMIC_ACQUIRE);
+
+    if (Perf->Epoch != Epoch)
+    {
+        memset(Perf, 0, sizeof(*Perf));
+        Perf->Epoch = Epoch;
+    }
+
+    return Perf;
+}
+
+/* Record one cipher call made on Channel */
+void SECURITY_APP_PerfRecordCrypto(uint8 Channel, uint8 Operation, uint32 Bytes, uint64 Start)
+{
+    SECURITY_APP_PerfRecordCryptoTicks(Channel, Operation, Bytes, SECURITY_APP_PerfNow() - Start);
+}
+
+/* Record Bytes of cipher work on Channel that took CryptoTicks, e.g. a record's share of a group call */
+void SECURITY_APP_PerfRecordCryptoTicks(uint8 Channel, uint8 Operation, uint32 Bytes, uint64 CryptoTicks)
+{
+    SECURITY_APP_PerfChannel_t *Perf = SECURITY_APP_PerfChannel(Channel);
+    uint32 Ticks = (CryptoTicks > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)CryptoTicks;
+    uint8 SizeClass;
+    uint8 Bucket = 0;
+
+    SECURITY_APP_PerfAccumulate(&Perf->Crypto[Operation], Ticks);
+    Perf->Bytes[Operation] += Bytes;
+
+    if (Bytes <= 64)
+    {
+        SizeClass = 0;
+    }
+    else if (Bytes <= 256)
+    {
+        SizeClass = 1;
+    }
+    else if (Bytes <= 1024)
+    {
+        SizeClass = 2;
+    }
+    else
+    {
+        SizeClass = 3;
+    }
+
+    if (Ticks != 0)
+    {
+        Bucket = 31 - __builtin_clz(Ticks);
+        if (Bucket >= SECURITY_APP_PERF_LATENCY_BUCKETS)
+        {
+            Bucket = SECURITY_APP_PERF_LATENCY_BUCKETS - 1;
+        }
+    }
+    Perf->Histogram[Operation][SizeClass][Bucket]++;
+}
+
+/* Record one compression attempt on Channel; BytesOut equals BytesIn when the data went raw */
+void SECURITY_APP_PerfRecordCompress(uint8 Channel, uint32 BytesIn, uint32 BytesOut, uint64 Start)
+{
+    SECURITY_APP_PerfChannel_t *Perf = SECURITY_APP_PerfChannel(Channel);
+
+    SECURITY_APP_PerfAccumulate(&Perf->Compress, SECURITY_APP_PerfElapsed(Start));
+    Perf->CompressBytesIn += BytesIn;
+    Perf->CompressBytesOut += BytesOut;
+    if (BytesOut == BytesIn)
+    {
+        Perf->CompressRawCount++;
+    }
+}
+
+/* Record one payload decompressed on Channel */
+void SECURITY_APP_PerfRecordDecompress(uint8 Channel, uint64 Start)
+{
+    SECURITY_APP_PerfChannel_t *Perf = SECURITY_APP_PerfChannel(Channel);
+
+    SECURITY_APP_PerfAccumulate(&Perf->Decompress, SECURITY_APP_PerfElapsed(Start));
+}
+
+/* Record handling of one command packet (main task only) */
+void SECURITY_APP_PerfRecordCommand(uint64 Start)
+{
+    SECURITY_APP_PerfAccumulate(&SECURITY_APP_Perf.Command, SECURITY_APP_PerfElapsed(Start));
+}
+
+/* Record the work done on one scheduler wakeup (main task only) */
+void SECURITY_APP_PerfRecordCycle(uint16 Ops, uint32 Bytes, bool BudgetHit, uint64 Start)
+{
+    SECURITY_APP_PerfAccumulate(&SECURITY_APP_Perf.Cycle, SECURITY_APP_PerfElapsed(Start));
+
+    SECURITY_APP_Perf.CycleLastOps = Ops;
+    SECURITY_APP_Perf.CycleLastBytes = Bytes;
+    if (Ops > SECURITY_APP_Perf.CycleMaxOps)
+    {
+        SECURITY_APP_Perf.CycleMaxOps = Ops;
+    }
+    if (Bytes > SECURITY_APP_Perf.CycleMaxBytes)
+    {
+        SECURITY_APP_Perf.CycleMaxBytes = Bytes;
+    }
+    if (BudgetHit)
+    {
+        SECURITY_APP_Perf.CycleBudgetHits++;
+    }
+}
+
+/* Record one message taken from Pipe (main task only) */
+void SECURITY_APP_PerfRecordPipeMsg(uint8 Pipe)
+{
+    SECURITY_APP_PerfPipe_t *Perf = &SECURITY_APP_Perf.Pipes[Pipe];
+
+    Perf->Run++;
+    SECURITY_APP_PerfAccumulate(&Perf->Wait, SECURITY_APP_PerfElapsed(Perf->LastEmpty));
+}
+
+/* Record finding Pipe empty, which ends a back-to-back run (main task only) */
+void SECURITY_APP_PerfRecordPipeEmpty(uint8 Pipe)
+{
+    SECURITY_APP_PerfPipe_t *Perf = &SECURITY_APP_Perf.Pipes[Pipe];
+
+    if (Perf->Run > Perf->HighWater)
+    {
+        Perf->HighWater = Perf->Run;
+    }
+    Perf->Run = 0;
+    Perf->LastEmpty = SECURITY_APP_PerfNow();
+}
+
+/* Sum the channel counters and send the performance packet */
+void SECURITY_APP_ReportPerf(void)
+{
+    SECURITY_APP_PerfTlm_t *Tlm = &SECURITY_APP_Perf.Tlm;
+    SECURITY_APP_PerfAccum_t Crypto[2];
+    SECURITY_APP_PerfAccum_t Compress;
+    SECURITY_APP_PerfAccum_t Decompress;
+    uint32 Epoch = __atomic_load_n(&SECURITY_APP_Perf.Epoch, __ATOMIC_ACQUIRE);
+    uint8 Channel;
+    uint8 Op;
+    uint8 i;
+    uint8 j;
+
+    memset(Crypto, 0, sizeof(Crypto));
+    memset(&Compress, 0, sizeof(Compress));
+    memset(&Decompress, 0, sizeof(Decompress));
+    Tlm->CompressBytesIn = 0;
+    Tlm->CompressBytesOut = 0;
+    Tlm->CompressRawCount = 0;
+    memset(Tlm->Bytes, 0, sizeof(Tlm->Bytes));
+    memset(Tlm->Histogram, 0, sizeof(Tlm->Histogram));
+
+    /* Other tasks may be mid-update; telemetry tolerates a sample of skew */
+    for (Channel = 0; Channel < SECURITY_APP_CRYPTO_CHANNELS; Channel++)
+    {
+        const SECURITY_APP_PerfChannel_t *Perf = &SECURITY_APP_Perf.Channels[Channel];
+
+        if (Perf->Epoch != Epoch)
+        {
+            continue;
+        }
+
+        for (Op = SECURITY_APP_OP_ENCRYPT; Op <= SECURITY_APP_OP_DECRYPT; Op++)
+        {
+            SECURITY_APP_PerfMerge(&Crypto[Op], &Perf->Crypto[Op]);
+            Tlm->Bytes[Op] += Perf->Bytes[Op];
+            for (i = 0; i < SECURITY_APP_PERF_SIZE_CLASSES; i++)
+            {
+                for (j = 0; j < SECURITY_APP_PERF_LATENCY_BUCKETS; j++)
+                {
+                    Tlm->Histogram[Op][i][j] += Perf->Histogram[Op][i][j];
+                }
+            }
+        }
+
+        SECURITY_APP_PerfMerge(&Compress, &Perf->Compress);
+        SECURITY_APP_PerfMerge(&Decompress, &Perf->Decompress);
+        Tlm->CompressBytesIn += Perf->CompressBytesIn;
+        Tlm->CompressBytesOut += Perf->CompressBytesOut;
+        Tlm->CompressRawCount += Perf->CompressRawCount;
+    }
+
+    Tlm->TicksPerSecond = CFE_PSP_GetTimerTicksPerSecond();
+    for (i = 0; i < SECURITY_APP_PIPE_COUNT; i++)
+    {
+        Tlm->PipeHighWater[i] = SECURITY_APP_Perf.Pipes[i].HighWater;
+        Tlm->PipeDepth[i] = SECURITY_APP_Data.PipeDepth[i];
+        SECURITY_APP_PerfSummarize(&Tlm->PipeWait[i], &SECURITY_APP_Perf.Pipes[i].Wait);
+    }
+    SECURITY_APP_PerfSummarize(&Tlm->Command, &SECURITY_APP_Perf.Command);
+    SECURITY_APP_PerfSummarize(&Tlm->Cycle, &SECURITY_APP_Perf.Cycle);
+    Tlm->CycleOpBudget = SECURITY_APP_CYCLE_OP_BUDGET;
+    Tlm->CycleLastOps = SECURITY_APP_Perf.CycleLastOps;
+    Tlm->CycleMaxOps = SECURITY_APP_Perf.CycleMaxOps;
+    Tlm->CycleByteBudget = SECURITY_APP_CYCLE_BYTE_BUDGET;
+    Tlm->CycleLastBytes = SECURITY_APP_Perf.CycleLastBytes;
+    Tlm->CycleMaxBytes = SECURITY_APP_Perf.CycleMaxBytes;
+    Tlm->CycleBudgetHits = SECURITY_APP_Perf.CycleBudgetHits;
+    SECURITY_APP_PerfSummarize(&Tlm->Crypto[SECURITY_APP_OP_ENCRYPT], &Crypto[SECURITY_APP_OP_ENCRYPT]);
+    SECURITY_APP_PerfSummarize(&Tlm->Crypto[SECURITY_APP_OP_DECRYPT], &Crypto[SECURITY_APP_OP_DECRYPT]);
+    SECURITY_APP_PerfSummarize(&Tlm->Compress, &Compress);
+    SECURITY_APP_PerfSummarize(&Tlm->Decompress, &Decompress);
+    Tlm->CompressRatio = (Tlm->CompressBytesIn != 0) ?
+                         (uint32)(((uint64)Tlm->CompressBytesOut * 1000) / Tlm->CompressBytesIn) : 0;
+
+    CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)Tlm);
+    CFE_SB_SendMsg((CFE_SB_MsgPtr_t)Tlm);
+}
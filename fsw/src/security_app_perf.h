@@ -0,0 +1,38 @@
+#ifndef SECURITY_APP_PERF_H
+#define SECURITY_APP_PERF_H
+
+#include "security_app.h"
+
+/*
+** Performance telemetry
+**
+** Crypto timings are accumulated per crypto channel so that the main task
+** and each worker only ever write their own counters. Command handling and
+** pipe queueing are measured on the main task. All times are raw PSP timebase
+** ticks; the packet carries the tick rate for conversion on the ground.
+*/
+
+/* Read the free-running PSP timebase */
+static inline uint64 SECURITY_APP_PerfNow(void)
+{
+    uint32 Upper;
+    uint32 Lower;
+
+    CFE_PSP_Get_Timebase(&Upper, &Lower);
+
+    return ((uint64)Upper << 32) | Lower;
+}
+
+void SECURITY_APP_InitPerf(void);
+void SECURITY_APP_ResetPerf(void);
+void SECURITY_APP_ReportPerf(void);
+void SECURITY_APP_PerfRecordCrypto(uint8 Channel, uint8 Operation, uint32 Bytes, uint64 Start);
+void SECURITY_APP_PerfRecordCryptoTicks(uint8 Channel, uint8 Operation, uint32 Bytes, uint64 CryptoTicks);
+void SECURITY_APP_PerfRecordCompress(uint8 Channel, uint32 BytesIn, uint32 BytesOut, uint64 Start);
+void SECURITY_APP_PerfRecordDecompress(uint8 Channel, uint64 Start);
+void SECURITY_APP_PerfRecordCommand(uint64 Start);
+void SECURITY_APP_PerfRecordCycle(uint16 Ops, uint32 Bytes, bool BudgetHit, uint64 Start);
+void SECURITY_APP_PerfRecordPipeMsg(uint8 Pipe);
+void SECURITY_APP_PerfRecordPipeEmpty(uint8 Pipe);
+
+#endif /* SECURITY_APP_PERF_H */
@@ -0,0 +1,365 @@
+#include "security_app_provider.h"
+#include <string.h>
+
+/*
+** Providers built in, fastest first. The built-in kernels only cover the
+** AES suites, so libgcrypt, when built in, serves the rest.
+*/
+static const security_app_provider_t *const provider_list[] = {
+#if (SECURITY_APP_HAVE_AESNI == 1)
+    &SECURITY_APP_VaesProvider,
+    &SECURITY_APP_AesniProvider,
+#endif
+#if (SECURITY_APP_WITH_GCRYPT == 1)
+    &SECURITY_APP_GcryptProvider,
+#endif
+};
+
+#define PROVIDER_COUNT  (sizeof(provider_list) / sizeof(provider_list[0]))
+
+/* Random generators in order of preference: libgcrypt's pool ahead of bare RDRAND */
+static const security_app_provider_t *const random_list[] = {
+#if (SECURITY_APP_WITH_GCRYPT == 1)
+    &SECURITY_APP_GcryptProvider,
+#endif
+#if (SECURITY_APP_HAVE_AESNI == 1)
+    &SECURITY_APP_AesniProvider,
+#endif
+};
+
+#define RANDOM_COUNT    (sizeof(random_list) / sizeof(random_list[0]))
+
+static const security_app_provider_t *suite_provider[SECURITY_APP_SUITE_COUNT];
+static const security_app_provider_t *random_provider;
+static uint8_t self_test_failures;
+
+/*
+** Known answers
+**
+** The key and plaintext are the AES-256 example of NIST SP 800-38A, and the
+** CBC answer is its F.2.5 ciphertext. The other suites use the app's nonce
+** layout (12-byte nonce, zero counter) and record header sized associated
+** data; their answers were produced with libgcrypt and the CTR one checked
+** against OpenSSL.
+*/
+#define AES_BLOCK_SIZE  16
+#define KAT_DATA_SIZE   48
+#define KAT_BULK_SIZE   320     /* Long enough for every parallel kernel plus a tail */
+#define KAT_CHUNK_SIZE  64
+
+static const uint8_t kat_key[SECURITY_APP_KEY_SIZE] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+};
+
+static const uint8_t kat_plaintext[KAT_DATA_SIZE] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef
+};
+
+static const uint8_t kat_cbc_iv[SECURITY_APP_IV_SIZE] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static const uint8_t kat_nonce[SECURITY_APP_IV_SIZE] = {
+    0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88, 0x00, 0x00, 0x00, 0x00
+};
+
+static const uint8_t kat_aad[8] = { 0x30, 0x20, 0x00, 0x40, 0x00, 0x00, 0x00, 0x01 };
+
+static const uint8_t kat_cbc[48] = {
+    0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba, 0x77, 0x9e, 0xab, 0xfb, 0x5f, 0x7b, 0xfb, 0xd6,
+    0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb, 0x80, 0x8d, 0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d,
+    0x39, 0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf, 0xa5, 0x30, 0xe2, 0x63, 0x04, 0x23, 0x14, 0x61
+};
+
+static const uint8_t kat_ctr[40] = {
+    0xce, 0x7f, 0x32, 0xf5, 0x1c, 0x2f, 0x56, 0x3f, 0x43, 0x63, 0x48, 0xeb, 0x6c, 0xba, 0x33, 0x29,
+    0x14, 0xd4, 0xf5, 0x56, 0x95, 0x0a, 0xde, 0x9e, 0x05, 0x46, 0x34, 0xed, 0xd0, 0xc8, 0xa7, 0x92,
+    0x97, 0xef, 0xf4, 0x36, 0x4c, 0x1a, 0x35, 0x6a
+};
+
+static const uint8_t kat_gcm[56] = {
+    0xcc, 0xe6, 0x56, 0x92, 0xc1, 0x06, 0x4e, 0xed, 0x7f, 0xa3, 0x04, 0x6a, 0xa4, 0x6b, 0xd8, 0xea,
+    0xa9, 0xc7, 0xaa, 0x99, 0x0b, 0x4f, 0x96, 0x8b, 0xae, 0x83, 0xca, 0xe7, 0x28, 0xc0, 0x4f, 0x8c,
+    0x05, 0xa1, 0x8f, 0x4f, 0x2d, 0xd6, 0xe1, 0x17,
+    0x3e, 0x95, 0xb3, 0x4e, 0xd5, 0xe5, 0xe7, 0x29, 0x6f, 0x9b, 0x0d, 0x8f, 0x03, 0x81, 0x79, 0x54
+};
+
+static const uint8_t kat_chacha20_poly1305[56] = {
+    0xc3, 0x77, 0xbe, 0x7c, 0x29, 0x1e, 0x80, 0x85, 0x2d, 0xce, 0x20, 0xaa, 0xba, 0x4e, 0xb1, 0x21,
+    0x14, 0xff, 0xf2, 0x39, 0xcb, 0x67, 0x5d, 0x92, 0x95, 0xa2, 0x23, 0x07, 0x04, 0xfb, 0x35, 0x3c,
+    0x07, 0x95, 0x83, 0xd2, 0x96, 0xbf, 0x7f, 0xd9,
+    0x77, 0xfe, 0xe4, 0xc1, 0xe2, 0xb7, 0x25, 0xa4, 0x2b, 0xa5, 0x05, 0x03, 0x04, 0xa5, 0x21, 0xe4
+};
+
+static const uint8_t kat_gmac[16] = {
+    0xdb, 0x29, 0x27, 0x4d, 0x9b, 0x56, 0xc8, 0x14, 0xd1, 0x6e, 0xa1, 0xc3, 0xac, 0x28, 0x64, 0xb3
+};
+
+static const uint8_t kat_poly1305[16] = {
+    0x30, 0x33, 0xe3, 0x47, 0x8a, 0x36, 0x42, 0x5d, 0xcc, 0xf7, 0xe2, 0x7e, 0x0e, 0xc7, 0x89, 0xd9
+};
+
+typedef struct {
+    const uint8_t *iv;
+    const uint8_t *expected;    /* Output data, then the tag */
+    size_t         data_len;    /* Bytes of kat_plaintext */
+    size_t         tag_len;
+    int            auth_only;
+} kat_vector_t;
+
+static const kat_vector_t kat_vectors[SECURITY_APP_SUITE_COUNT] = {
+    [SECURITY_APP_SUITE_AES256_CBC]        = { kat_cbc_iv, kat_cbc,               48, 0,  0 },
+    [SECURITY_APP_SUITE_AES256_CTR]        = { kat_nonce,  kat_ctr,               40, 0,  0 },
+    [SECURITY_APP_SUITE_AES256_GCM]        = { kat_nonce,  kat_gcm,               40, 16, 0 },
+    [SECURITY_APP_SUITE_CHACHA20_POLY1305] = { kat_nonce,  kat_chacha20_poly1305, 40, 16, 0 },
+    [SECURITY_APP_SUITE_AES256_GMAC]       = { kat_nonce,  kat_gmac,              40, 16, 1 },
+    [SECURITY_APP_SUITE_POLY1305]          = { kat_nonce,  kat_poly1305,          40, 16, 1 },
+};
+
+/* Start a message and feed the associated data, if the suite has a tag */
+static int SECURITY_APP_KatStart(const security_app_provider_t *p, void *ctx, const kat_vector_t *kat)
+{
+    if (p->start(ctx, kat->iv) != 0) {
+        return -1;
+    }
+
+    return (kat->tag_len > 0) ? p->authenticate(ctx, kat_aad, sizeof(kat_aad)) : 0;
+}
+
+/* Encrypt a whole buffer in one call, or in KAT_CHUNK_SIZE calls */
+static int SECURITY_APP_KatEncrypt(const security_app_provider_t *p, void *ctx, const kat_vector_t *kat,
+                                   uint8_t *out, const uint8_t *in, size_t len, size_t chunk)
+{
+    size_t done;
+
+    if (SECURITY_APP_KatStart(p, ctx, kat) != 0) {
+        return -1;
+    }
+
+    for (done = 0; done < len; done += chunk) {
+        if (p->encrypt(ctx, out + done, in + done, (len - done < chunk) ? len - done : chunk) != 0) {
+            return -1;
+        }
+    }
+
+    return (kat->tag_len > 0) ? p->gettag(ctx, out + len, kat->tag_len) : 0;
+}
+
+/* Three CBC lanes in one multi-buffer call, into multi_out */
+static uint8_t multi_out[3][KAT_BULK_SIZE];
+
+static int SECURITY_APP_KatMulti(const security_app_provider_t *p, void *ctx, const kat_vector_t *kat,
+                                 const uint8_t *bulk_in)
+{
+    security_app_lane_t lanes[3] = {
+        { kat->iv, kat_plaintext, KAT_DATA_SIZE / AES_BLOCK_SIZE, NULL,                         multi_out[0] },
+        { kat->iv, bulk_in,       KAT_BULK_SIZE / AES_BLOCK_SIZE, NULL,                         multi_out[1] },
+        { kat->iv, bulk_in,       7,                              bulk_in + 7 * AES_BLOCK_SIZE, multi_out[2] },
+    };
+
+    return p->encrypt_multi(ctx, lanes, 3);
+}
+
+static int SECURITY_APP_KatSuite(const security_app_provider_t *p, void *ctx, uint8_t suite)
+{
+    const kat_vector_t *kat = &kat_vectors[suite];
+    static uint8_t bulk_in[KAT_BULK_SIZE];
+    static uint8_t bulk_out[2][KAT_BULK_SIZE + SECURITY_APP_TAG_SIZE];
+    uint8_t out[KAT_DATA_SIZE + SECURITY_APP_TAG_SIZE];
+    uint8_t bad_tag[SECURITY_APP_TAG_SIZE];
+    size_t i;
+
+    if (kat->auth_only) {
+        /* The tag alone, then verification of the right and a wrong tag */
+        if (SECURITY_APP_KatStart(p, ctx, kat) != 0 ||
+            p->authenticate(ctx, kat_plaintext, kat->data_len) != 0 ||
+            p->gettag(ctx, out, kat->tag_len) != 0 ||
+            memcmp(out, kat->expected, kat->tag_len) != 0) {
+            return -1;
+        }
+
+        memcpy(bad_tag, kat->expected, kat->tag_len);
+        bad_tag[0] ^= 0x01;
+        if (SECURITY_APP_KatStart(p, ctx, kat) != 0 ||
+            p->authenticate(ctx, kat_plaintext, kat->data_len) != 0 ||
+            p->checktag(ctx, kat->expected, kat->tag_len) != 0 ||
+            SECURITY_APP_KatStart(p, ctx, kat) != 0 ||
+            p->authenticate(ctx, kat_plaintext, kat->data_len) != 0 ||
+            p->checktag(ctx, bad_tag, kat->tag_len) == 0) {
+            return -1;
+        }
+
+        return 0;
+    }
+
+    /* Known answer in both directions */
+    if (SECURITY_APP_KatEncrypt(p, ctx, kat, out, kat_plaintext, kat->data_len, kat->data_len) != 0 ||
+        memcmp(out, kat->expected, kat->data_len + kat->tag_len) != 0) {
+        return -1;
+    }
+
+    if (SECURITY_APP_KatStart(p, ctx, kat) != 0 ||
+        p->decrypt(ctx, out, kat->expected, kat->data_len) != 0 ||
+        memcmp(out, kat_plaintext, kat->data_len) != 0 ||
+        (kat->tag_len > 0 && p->checktag(ctx, kat->expected + kat->data_len, kat->tag_len) != 0)) {
+        return -1;
+    }
+
+    if (kat->tag_len > 0) {
+        memcpy(bad_tag, kat->expected + kat->data_len, kat->tag_len);
+        bad_tag[0] ^= 0x01;
+        if (SECURITY_APP_KatStart(p, ctx, kat) != 0 ||
+            p->decrypt(ctx, out, kat->expected, kat->data_len) != 0 ||
+            p->checktag(ctx, bad_tag, kat->tag_len) == 0) {
+            return -1;
+        }
+    }
+
+    /*
+    ** The known answers only reach the one-block paths; the parallel kernels
+    ** must give the same result for a long message in one call as in
+    ** segments, and decrypt it back
+    */
+    for (i = 0; i < KAT_BULK_SIZE; i++) {
+        bulk_in[i] = (uint8_t)(i * 7 + 1);
+    }
+
+    if (SECURITY_APP_KatEncrypt(p, ctx, kat, bulk_out[0], bulk_in, KAT_BULK_SIZE, KAT_BULK_SIZE) != 0 ||
+        SECURITY_APP_KatEncrypt(p, ctx, kat, bulk_out[1], bulk_in, KAT_BULK_SIZE, KAT_CHUNK_SIZE) != 0 ||
+        memcmp(bulk_out[0], bulk_out[1], KAT_BULK_SIZE + kat->tag_len) != 0) {
+        return -1;
+    }
+
+    if (SECURITY_APP_KatStart(p, ctx, kat) != 0 ||
+        p->decrypt(ctx, bulk_out[1], bulk_out[0], KAT_BULK_SIZE) != 0 ||
+        memcmp(bulk_out[1], bulk_in, KAT_BULK_SIZE) != 0 ||
+        (kat->tag_len > 0 && p->checktag(ctx, bulk_out[0] + KAT_BULK_SIZE, kat->tag_len) != 0)) {
+        return -1;
+    }
+
+    /*
+    ** A multi-buffer kernel runs lanes of different lengths side by side:
+    ** the known answer, the long message, and its first eight blocks with
+    ** the eighth passed as the padded last block
+    */
+    if (p->encrypt_multi != NULL && suite == SECURITY_APP_SUITE_AES256_CBC) {
+        if (SECURITY_APP_KatEncrypt(p, ctx, kat, bulk_out[0], bulk_in, KAT_BULK_SIZE, KAT_BULK_SIZE) != 0 ||
+            SECURITY_APP_KatMulti(p, ctx, kat, bulk_in) != 0 ||
+            memcmp(multi_out[0], kat->expected, kat->data_len) != 0 ||
+            memcmp(multi_out[1], bulk_out[0], KAT_BULK_SIZE) != 0 ||
+            memcmp(multi_out[2], bulk_out[0], 8 * AES_BLOCK_SIZE) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int SECURITY_APP_SelfTest(const security_app_provider_t *p, uint8_t suite)
+{
+    void *ctx;
+    int status;
+
+    ctx = p->open(suite, kat_key);
+    if (ctx == NULL) {
+        return -1;
+    }
+
+    status = SECURITY_APP_KatSuite(p, ctx, suite);
+
+    p->close(ctx);
+
+    return status;
+}
+
+int32_t SECURITY_APP_InitProviders(void)
+{
+    uint8_t ready[PROVIDER_COUNT];
+    uint8_t probe[SECURITY_APP_IV_SIZE];
+    uint8_t suite;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < PROVIDER_COUNT; i++) {
+        ready[i] = provider_list[i]->available() && provider_list[i]->init() == 0;
+    }
+
+    random_provider = NULL;
+    for (i = 0; i < RANDOM_COUNT && random_provider == NULL; i++) {
+        for (j = 0; j < PROVIDER_COUNT; j++) {
+            if (provider_list[j] == random_list[i] && ready[j] &&
+                random_list[i]->random(probe, sizeof(probe)) == 0) {
+                random_provider = random_list[i];
+            }
+        }
+    }
+    if (random_provider == NULL) {
+        return -1;
+    }
+
+    self_test_failures = 0;
+    for (suite = 0; suite < SECURITY_APP_SUITE_COUNT; suite++) {
+        suite_provider[suite] = NULL;
+
+        for (i = 0; i < PROVIDER_COUNT && suite_provider[suite] == NULL; i++) {
+            if (!ready[i] || !provider_list[i]->supports(suite)) {
+                continue;
+            }
+
+            if (SECURITY_APP_SelfTest(provider_list[i], suite) == 0) {
+                suite_provider[suite] = provider_list[i];
+            } else {
+                self_test_failures |= (uint8_t)(1 << suite);
+            }
+        }
+    }
+
+    return 0;
+}
+
+const security_app_provider_t *SECURITY_APP_SuiteProvider(uint8_t suite)
+{
+    return suite < SECURITY_APP_SUITE_COUNT ? suite_provider[suite] : NULL;
+}
+
+int SECURITY_APP_Random(uint8_t *buf, size_t len)
+{
+    return random_provider != NULL ? random_provider->random(buf, len) : -1;
+}
+
+int SECURITY_APP_ClaimContext(uint8_t *in_use, size_t count)
+{
+    size_t i;
+
+    /* Opened by the key loader and by any task recovering a failed context */
+    for (i = 0; i < count; i++) {
+        if (__atomic_load_n(&in_use[i], __ATOMIC_RELAXED) == 0 &&
+            __atomic_exchange_n(&in_use[i], 1, __ATOMIC_ACQUIRE) == 0) {
+            return (int)i;
+        }
+    }
+
+    return -1;
+}
+
+uint8_t SECURITY_APP_CryptoProvider(uint8_t suite)
+{
+    const security_app_provider_t *p = SECURITY_APP_SuiteProvider(suite);
+
+    return p != NULL ? p->id : SECURITY_APP_PROVIDER_NONE;
+}
+
+const char *SECURITY_APP_CryptoProviderName(uint8_t suite)
+{
+    const security_app_provider_t *p = SECURITY_APP_SuiteProvider(suite);
+
+    return p != NULL ? p->name : "none";
+}
+
+uint8_t SECURITY_APP_CryptoSelfTestFailures(void)
+{
+    return self_test_failures;
+}
@@ -0,0 +1,106 @@
+#ifndef SECURITY_APP_PROVIDER_H
+#define SECURITY_APP_PROVIDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "security_app_crypto.h"
+
+/*
+** Crypto providers
+**
+** A provider implements some or all of the cipher suites behind one table
+** of functions. Which providers are built in is set at build time with
+** SECURITY_APP_WITH_*; at startup each suite is given to the first provider,
+** fastest first, that is usable on this CPU and passes the suite's
+** known-answer self-test. IVs and counter nonces come from the first
+** provider with a working random generator, preferring libgcrypt's.
+**
+** A provider context holds one suite's key schedule. start loads a message's
+** IV field (the whole 16 bytes for CBC, a 12-byte nonce with a 32-bit block
+** counter from zero for CTR, a 12-byte nonce for the AEAD suites) and clears
+** any chaining or MAC state. For the tagged suites authenticate takes the
+** associated data, then the message data of the authenticate-only suites.
+** Every encrypt or decrypt call but the last of a message must be a whole
+** number of blocks; CBC calls always are. Functions returning int return 0
+** on success. A context is only ever used by one task at a time.
+**
+** encrypt_multi, which may be NULL, CBC-encrypts up to
+** SECURITY_APP_MULTI_BUFFERS independent messages under the context's key
+** in one call, each from its own IV and into its own output, with the same
+** result as encrypting them one after the other.
+*/
+#if (SECURITY_APP_WITH_AESNI == 1) && (defined(__x86_64__) || defined(__i386__))
+#define SECURITY_APP_HAVE_AESNI         1
+#else
+#define SECURITY_APP_HAVE_AESNI         0
+#endif
+
+#if (SECURITY_APP_MULTI_BUFFERS < 1) || (SECURITY_APP_MULTI_BUFFERS > 8)
+#error "SECURITY_APP_MULTI_BUFFERS must be 1 to 8"
+#endif
+
+#if (SECURITY_APP_WITH_GCRYPT != 1) && (SECURITY_APP_HAVE_AESNI != 1)
+#error "No crypto provider is built in: enable SECURITY_APP_WITH_GCRYPT or SECURITY_APP_WITH_AESNI"
+#endif
+
+/* One message of a multi-buffer call: whole blocks at in, then an optional zero-padded last block */
+typedef struct {
+    const uint8_t *iv;
+    const uint8_t *in;
+    size_t         blocks;
+    const uint8_t *last;        /* NULL if the message is whole blocks */
+    uint8_t       *out;
+} security_app_lane_t;
+
+typedef struct {
+    const char *name;
+    uint8_t     id;
+    int       (*available)(void);                     /* CPU features and libraries present */
+    int32_t   (*init)(void);
+    int       (*supports)(uint8_t suite);
+    void     *(*open)(uint8_t suite, const uint8_t *key);   /* NULL on failure */
+    void      (*close)(void *ctx);
+    int       (*start)(void *ctx, const uint8_t *iv);
+    int       (*encrypt)(void *ctx, uint8_t *out, const uint8_t *in, size_t len);
+    int       (*decrypt)(void *ctx, uint8_t *out, const uint8_t *in, size_t len);
+    int       (*authenticate)(void *ctx, const uint8_t *data, size_t len);
+    int       (*gettag)(void *ctx, uint8_t *tag, size_t len);
+    int       (*checktag)(void *ctx, const uint8_t *tag, size_t len);
+    int       (*random)(uint8_t *buf, size_t len);
+    int       (*encrypt_multi)(void *ctx, const security_app_lane_t *lanes, size_t count);
+} security_app_provider_t;
+
+/*
+** Contexts a provider may have open at once: an encrypt and a decrypt
+** context for every channel, key bank and suite, one per stream session and
+** one for the self-test
+*/
+#define SECURITY_APP_PROVIDER_CONTEXTS \
+    (SECURITY_APP_CRYPTO_CHANNELS * SECURITY_APP_MAX_KEYS * 2 * SECURITY_APP_SUITE_COUNT * 2 + \
+     SECURITY_APP_CRYPTO_STREAMS + 1)
+
+#if (SECURITY_APP_WITH_GCRYPT == 1)
+extern const security_app_provider_t SECURITY_APP_GcryptProvider;
+#endif
+#if (SECURITY_APP_HAVE_AESNI == 1)
+extern const security_app_provider_t SECURITY_APP_AesniProvider;
+extern const security_app_provider_t SECURITY_APP_VaesProvider;
+#endif
+
+/*
+** Select a provider for every suite. Returns -1 if no random generator
+** works; suites no provider passed are left without one.
+*/
+int32_t SECURITY_APP_InitProviders(void);
+
+/* The provider serving a suite, or NULL if there is none */
+const security_app_provider_t *SECURITY_APP_SuiteProvider(uint8_t suite);
+
+/* Fill buf from the selected random generator */
+int SECURITY_APP_Random(uint8_t *buf, size_t len);
+
+/* Claim a free entry of a provider's context pool; returns its index or -1 */
+int SECURITY_APP_ClaimContext(uint8_t *in_use, size_t count);
+
+#endif /* SECURITY_APP_PROVIDER_H */
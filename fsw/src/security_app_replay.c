@@ -0,0 +1,230 @@
+#include "security_app_replay.h"
+#include "security_app_events.h"
+
+CompileTimeAssert(SECURITY_APP_REPLAY_WINDOW >= 32 && SECURITY_APP_REPLAY_WINDOW % 32 == 0,
+                  ReplayWindowWholeWords);
+
+/*
+** The window is a ring of bitmap words indexed by sequence number (RFC 6479):
+** bit Seq % 32 of word (Seq / 32) % SECURITY_APP_REPLAY_WORDS is set once Seq
+** is accepted. One word more than the window needs is kept so that advancing
+** Top only ever clears whole words ahead of it, never shifts the bitmap.
+*/
+#define SECURITY_APP_REPLAY_WORDS   (SECURITY_APP_REPLAY_WINDOW / 32 + 1)
+
+typedef struct
+{
+    uint32  Top;                                    /* Newest sequence number accepted, 0 = none */
+    uint32  Bitmap[SECURITY_APP_REPLAY_WORDS];
+
+} SECURITY_APP_ReplayWindow_t;
+
+/*
+** Outgoing numbers are handed out below a per-key limit held in the critical
+** data store. The first number past the limit moves it up by
+** SECURITY_APP_TX_SEQ_RESERVE and waits for the CDS write before it is used,
+** so every number sent is covered by the saved limit and a restarted app can
+** resume after it. CdsLimit is the image written to the CDS; TxLimit is only
+** raised once that write is done. Without a CDS TxLimit is 0xFFFFFFFF and
+** numbers restart with the app.
+*/
+static struct
+{
+    uint32                       TxSeq[SECURITY_APP_MAX_KEYS];
+    uint32                       TxLimit[SECURITY_APP_MAX_KEYS];
+    uint32                       CdsLimit[SECURITY_APP_MAX_KEYS];
+    SECURITY_APP_ReplayWindow_t  Rx[SECURITY_APP_MAX_KEYS];
+    bool                         CdsValid;
+    CFE_ES_CDSHandle_t           CdsHandle;
+    uint32                       CdsSemId;
+
+} SECURITY_APP_Replay;
+
+/* Set one key's limit in the CDS image and write it out; caller holds CdsSemId */
+static void SECURITY_APP_ReplaySave(uint8 KeyId, uint32 Limit)
+{
+    int32 status;
+
+    SECURITY_APP_Replay.CdsLimit[KeyId] = Limit;
+    status = CFE_ES_CopyToCDS(SECURITY_APP_Replay.CdsHandle, SECURITY_APP_Replay.CdsLimit);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_REPLAY_CDS_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Saving sequence numbers for key ID %d failed, RC = 0x%08X",
+                         KeyId, (unsigned int)status);
+    }
+
+    __atomic_store_n(&SECURITY_APP_Replay.TxLimit[KeyId], Limit, __ATOMIC_RELEASE);
+}
+
+/*
+** Restore each key's outgoing sequence numbers from the CDS, or start them
+** from scratch when there is nothing to restore. Receive windows always start
+** empty.
+*/
+void SECURITY_APP_InitReplay(void)
+{
+    int32 status;
+    uint8 KeyId;
+
+    memset(&SECURITY_APP_Replay, 0, sizeof(SECURITY_APP_Replay));
+
+    status = OS_BinSemCreate(&SECURITY_APP_Replay.CdsSemId, "SecAppTxSeq", 1, 0);
+    if (status == OS_SUCCESS)
+    {
+        status = CFE_ES_RegisterCDS(&SECURITY_APP_Replay.CdsHandle, sizeof(SECURITY_APP_Replay.CdsLimit),
+                                    SECURITY_APP_REPLAY_CDS_NAME);
+    }
+
+    if (status == CFE_ES_CDS_ALREADY_EXISTS)
+    {
+        /* Anything up to a saved limit may already have been sent */
+        status = CFE_ES_RestoreFromCDS(SECURITY_APP_Replay.CdsLimit, SECURITY_APP_Replay.CdsHandle);
+        if (status == CFE_SUCCESS)
+        {
+            memcpy(SECURITY_APP_Replay.TxSeq, SECURITY_APP_Replay.CdsLimit, sizeof(SECURITY_APP_Replay.TxSeq));
+            memcpy(SECURITY_APP_Replay.TxLimit, SECURITY_APP_Replay.CdsLimit, sizeof(SECURITY_APP_Replay.TxLimit));
+        }
+    }
+    else if (status == CFE_SUCCESS)
+    {
+        status = CFE_ES_CopyToCDS(SECURITY_APP_Replay.CdsHandle, SECURITY_APP_Replay.CdsLimit);
+    }
+
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_REPLAY_CDS_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: No critical data store for sequence numbers, RC = 0x%08X; "
+                         "load new keys after every restart", (unsigned int)status);
+        memset(SECURITY_APP_Replay.TxSeq, 0, sizeof(SECURITY_APP_Replay.TxSeq));
+        for (KeyId = 0; KeyId < SECURITY_APP_MAX_KEYS; KeyId++)
+        {
+            SECURITY_APP_Replay.TxLimit[KeyId] = 0xFFFFFFFF;
+        }
+        return;
+    }
+
+    SECURITY_APP_Replay.CdsValid = TRUE;
+}
+
+/* Restart one key's sequence numbers and window, when a new key is loaded or a key unloaded */
+void SECURITY_APP_ReplayReset(uint8 KeyId)
+{
+    if (KeyId >= SECURITY_APP_MAX_KEYS)
+    {
+        return;
+    }
+
+    __atomic_store_n(&SECURITY_APP_Replay.TxSeq[KeyId], 0, __ATOMIC_RELAXED);
+    memset(&SECURITY_APP_Replay.Rx[KeyId], 0, sizeof(SECURITY_APP_Replay.Rx[KeyId]));
+
+    if (SECURITY_APP_Replay.CdsValid)
+    {
+        OS_BinSemTake(SECURITY_APP_Replay.CdsSemId);
+        SECURITY_APP_ReplaySave(KeyId, 0);
+        OS_BinSemGive(SECURITY_APP_Replay.CdsSemId);
+    }
+}
+
+/* Save a reservation covering Seq before it is used; other tasks past the old limit wait here */
+static void SECURITY_APP_ReplayReserve(uint8 KeyId, uint32 Seq)
+{
+    OS_BinSemTake(SECURITY_APP_Replay.CdsSemId);
+    if (Seq > SECURITY_APP_Replay.TxLimit[KeyId])
+    {
+        SECURITY_APP_ReplaySave(KeyId, (Seq > 0xFFFFFFFF - SECURITY_APP_TX_SEQ_RESERVE) ?
+                                       0xFFFFFFFF : Seq + SECURITY_APP_TX_SEQ_RESERVE);
+    }
+    OS_BinSemGive(SECURITY_APP_Replay.CdsSemId);
+}
+
+/* Take the next outgoing sequence number for a key, or 0 once they are used up */
+uint32 SECURITY_APP_ReplayNextSeq(uint8 KeyId)
+{
+    uint32 Seq;
+
+    if (KeyId >= SECURITY_APP_MAX_KEYS)
+    {
+        return 0;
+    }
+
+    /* Stick at the end rather than wrap back into numbers the receiver has seen */
+    Seq = __atomic_add_fetch(&SECURITY_APP_Replay.TxSeq[KeyId], 1, __ATOMIC_RELAXED);
+    if (Seq == 0)
+    {
+        __atomic_store_n(&SECURITY_APP_Replay.TxSeq[KeyId], 0xFFFFFFFF, __ATOMIC_RELAXED);
+    }
+    else if (Seq > __atomic_load_n(&SECURITY_APP_Replay.TxLimit[KeyId], __ATOMIC_ACQUIRE))
+    {
+        SECURITY_APP_ReplayReserve(KeyId, Seq);
+    }
+
+    return Seq;
+}
+
+/* Accept Seq if it is new and inside the window; records nothing */
+int32 SECURITY_APP_ReplayCheck(uint8 KeyId, uint32 Seq)
+{
+    const SECURITY_APP_ReplayWindow_t *Window;
+    uint32 Top;
+    uint32 Word;
+
+    if (KeyId >= SECURITY_APP_MAX_KEYS || Seq == 0)
+    {
+        return SECURITY_APP_ERROR;
+    }
+
+    /* May race with a commit; the commit repeats the check */
+    Window = &SECURITY_APP_Replay.Rx[KeyId];
+    Top = __atomic_load_n(&Window->Top, __ATOMIC_ACQUIRE);
+
+    if (Seq > Top)
+    {
+        return SECURITY_APP_SUCCESS;
+    }
+
+    if (Top - Seq >= SECURITY_APP_REPLAY_WINDOW)
+    {
+        return SECURITY_APP_ERROR;
+    }
+
+    Word = __atomic_load_n(&Window->Bitmap[(Seq / 32) % SECURITY_APP_REPLAY_WORDS], __ATOMIC_RELAXED);
+
+    return (Word & (1U << (Seq % 32))) ? SECURITY_APP_ERROR : SECURITY_APP_SUCCESS;
+}
+
+/* Record an authenticated sequence number; fails if it was a replay after all */
+int32 SECURITY_APP_ReplayCommit(uint8 KeyId, uint32 Seq)
+{
+    SECURITY_APP_ReplayWindow_t *Window;
+    uint32 Blocks;
+    uint32 i;
+
+    if (SECURITY_APP_ReplayCheck(KeyId, Seq) != SECURITY_APP_SUCCESS)
+    {
+        return SECURITY_APP_ERROR;
+    }
+
+    Window = &SECURITY_APP_Replay.Rx[KeyId];
+
+    if (Seq > Window->Top)
+    {
+        /* Clear the words Top moves across; a jump past the whole ring clears them all */
+        Blocks = Seq / 32 - Window->Top / 32;
+        if (Blocks > SECURITY_APP_REPLAY_WORDS)
+        {
+            Blocks = SECURITY_APP_REPLAY_WORDS;
+        }
+        for (i = 1; i <= Blocks; i++)
+        {
+            __atomic_store_n(&Window->Bitmap[(Window->Top / 32 + i) % SECURITY_APP_REPLAY_WORDS], 0,
+                             __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&Window->Top, Seq, __ATOMIC_RELEASE);
+    }
+
+    __atomic_fetch_or(&Window->Bitmap[(Seq / 32) % SECURITY_APP_REPLAY_WORDS], 1U << (Seq % 32),
+                      __ATOMIC_RELAXED);
+
+    return SECURITY_APP_SUCCESS;
+}
@@ -0,0 +1,46 @@
+#ifndef SECURITY_APP_REPLAY_H
+#define SECURITY_APP_REPLAY_H
+
+#include "security_app.h"
+
+/*
+** Anti-replay
+**
+** Every record carries a per-key sequence number. Outgoing numbers come from
+** SECURITY_APP_ReplayNextSeq, which any task may call. Incoming numbers are
+** checked against a fixed-size sliding window per key ID in two steps:
+** SECURITY_APP_ReplayCheck before any decryption work, so duplicates cost
+** nothing, and SECURITY_APP_ReplayCommit once the record has authenticated,
+** so a forged record cannot move the window. Commits are only made by the
+** task that publishes decrypt results (the output task when the worker pool
+** is in use, otherwise the main task). Both steps are constant time.
+**
+** Only the tagged suites (GCM, ChaCha20-Poly1305, GMAC, Poly1305)
+** authenticate the header, and with it the sequence number. CBC and CTR
+** records still carry a number but are neither checked nor committed: a
+** forged one could otherwise push the window forward and get every genuine
+** record on the key dropped as stale. Those suites have no replay
+** protection.
+**
+** Outgoing numbers survive an app restart or processor reset through a
+** critical data store block (SECURITY_APP_REPLAY_CDS_NAME), since the peer
+** keeps the window it built for a key until that key is replaced. Numbers
+** are reserved SECURITY_APP_TX_SEQ_RESERVE at a time and each reservation is
+** saved before any number in it is sent; SECURITY_APP_InitReplay resumes
+** every key after its saved reservation. A key loaded into an empty key ID
+** carries on from there, whatever the key table holds: resuming a new key at
+** a high number is harmless, restarting an old one at 1 is not. Only
+** replacing or unloading a key (SECURITY_APP_ReplayReset) starts its key ID
+** again from 1. The
+** CDS does not survive a power-on reset, and when it cannot be used the
+** numbers restart with the app; new keys must then be loaded on both sides
+** before the peer will accept anything. Receive windows are not saved and
+** start empty after a restart.
+*/
+void SECURITY_APP_InitReplay(void);
+void SECURITY_APP_ReplayReset(uint8 KeyId);
+uint32 SECURITY_APP_ReplayNextSeq(uint8 KeyId);
+int32 SECURITY_APP_ReplayCheck(uint8 KeyId, uint32 Seq);
+int32 SECURITY_APP_ReplayCommit(uint8 KeyId, uint32 Seq);
+
+#endif /* SECURITY_APP_REPLAY_H */
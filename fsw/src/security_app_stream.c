@@ -0,0 +1,384 @@
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include "security_app_events.h"
+
+#include <stddef.h>
+
+/* Validate a segment command against its session, returning the session or NULL */
+static SECURITY_APP_StreamSession_t *SECURITY_APP_GetStreamSession(const SECURITY_APP_StreamDataCmd_t *Msg)
+{
+    SECURITY_APP_StreamSession_t *Session;
+
+    if (Msg->SessionId >= SECURITY_APP_MAX_STREAMS || !SECURITY_APP_Data.Streams[Msg->SessionId].InUse)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Stream session %d is not open", Msg->SessionId);
+        return NULL;
+    }
+
+    Session = &SECURITY_APP_Data.Streams[Msg->SessionId];
+
+    /* Data may be shorter than the full array, but must be present in the packet */
+    if (Msg->DataLength > SECURITY_APP_MAX_DATA_LENGTH ||
+        Msg->DataLength > CFE_SB_GetTotalMsgLength((CFE_SB_MsgPtr_t)Msg) - offsetof(SECURITY_APP_StreamDataCmd_t, Data))
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Invalid stream segment length: %d", Msg->DataLength);
+        return NULL;
+    }
+
+    /* Reassembly is strictly in order; a gap or repeat is an error */
+    if (Msg->SegmentSeq != Session->NextSeq)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Stream %d segment %d out of order, expected %d",
+                         Msg->SessionId, Msg->SegmentSeq, Session->NextSeq);
+        return NULL;
+    }
+
+    return Session;
+}
+
+/* Count a failed stream operation against the session's direction */
+static void SECURITY_APP_StreamError(const SECURITY_APP_StreamSession_t *Session, uint8 Category)
+{
+    if (Session != NULL && Session->Direction == SECURITY_APP_STREAM_DECRYPT)
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_DECRYPT, Category);
+    }
+    else
+    {
+        SECURITY_APP_CountError(SECURITY_APP_OP_ENCRYPT, Category);
+    }
+}
+
+/* Close a session after an unrecoverable segment error */
+static void SECURITY_APP_CloseStream(uint8 SessionId)
+{
+    SECURITY_APP_StreamAbort(SessionId);
+    SECURITY_APP_Data.Streams[SessionId].InUse = FALSE;
+}
+
+/*
+** Decrypt sessions hold their plaintext here until END has checked the tag,
+** so no unauthenticated byte is ever published
+*/
+static uint8 SECURITY_APP_StreamHold[SECURITY_APP_MAX_STREAMS][SECURITY_APP_STREAM_HOLD_SIZE]
+    __attribute__((aligned(16)));
+
+CompileTimeAssert(SECURITY_APP_STREAM_HOLD_SIZE % SECURITY_APP_STREAM_SEGMENT_ALIGN == 0, StreamHoldAligned);
+
+/* Wipe and close a decrypt session that will never be released */
+static void SECURITY_APP_DropHold(uint8 SessionId)
+{
+    memset(SECURITY_APP_StreamHold[SessionId], 0, SECURITY_APP_Data.Streams[SessionId].HeldLength);
+    SECURITY_APP_Data.Streams[SessionId].HeldLength = 0;
+    SECURITY_APP_CloseStream(SessionId);
+}
+
+/*
+** Publish a verified decrypt session: the held plaintext in segments of up to
+** SECURITY_APP_MAX_DATA_LENGTH bytes numbered from 0, the last one flagged
+** END and AUTH_OK. A session with no data still gets its END packet.
+*/
+static void SECURITY_APP_ReleaseHold(uint8 SessionId, SECURITY_APP_StreamSession_t *Session)
+{
+    SECURITY_APP_OutputBuf_t OutputBuf;
+    SECURITY_APP_StreamTlm_t *StreamTlm;
+    uint32 Offset = 0;
+    uint16 Length;
+    uint16 Seq = 0;
+
+    do
+    {
+        Length = (Session->HeldLength - Offset > SECURITY_APP_MAX_DATA_LENGTH) ?
+                 SECURITY_APP_MAX_DATA_LENGTH : (uint16)(Session->HeldLength - Offset);
+
+        StreamTlm = (SECURITY_APP_StreamTlm_t *)SECURITY_APP_AcquireOutput(&OutputBuf, Session->TargetMsgID,
+                                        offsetof(SECURITY_APP_StreamTlm_t, Data) + Length);
+        if (StreamTlm == NULL)
+        {
+            SECURITY_APP_StreamError(Session, SECURITY_APP_STAT_ERR_BUFFER);
+            CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                             "SECURITY_APP: Unable to get SB buffer for stream %d, %u of %u bytes published",
+                             SessionId, (unsigned int)Offset, (unsigned int)Session->HeldLength);
+            break;
+        }
+
+        memcpy(StreamTlm->Data, &SECURITY_APP_StreamHold[SessionId][Offset], Length);
+        Offset += Length;
+
+        StreamTlm->SessionId = SessionId;
+        StreamTlm->SegmentSeq = Seq++;
+        StreamTlm->DataLength = Length;
+        StreamTlm->Suite = Session->Suite;
+        StreamTlm->Direction = Session->Direction;
+        StreamTlm->TotalLength = Offset;
+        if (Offset == Session->HeldLength)
+        {
+            StreamTlm->Flags = SECURITY_APP_STREAM_FLAG_END | SECURITY_APP_STREAM_FLAG_AUTH_OK;
+        }
+
+        SECURITY_APP_SendOutput(&OutputBuf);
+    } while (Offset < Session->HeldLength);
+
+    memset(SECURITY_APP_StreamHold[SessionId], 0, Session->HeldLength);
+}
+
+/* Run one decrypt segment into the session's hold buffer; END checks the tag and releases it */
+static int32 SECURITY_APP_StreamDecryptSegment(const SECURITY_APP_StreamDataCmd_t *Msg,
+                                               SECURITY_APP_StreamSession_t *Session, bool Final)
+{
+    SECURITY_APP_OutputBuf_t OutputBuf;
+    SECURITY_APP_StreamTlm_t *StreamTlm;
+    uint8 *Hold = &SECURITY_APP_StreamHold[Msg->SessionId][Session->HeldLength];
+    uint8 Tag[sizeof(Msg->Tag)];
+    int32_t status;
+
+    if (Msg->DataLength > SECURITY_APP_STREAM_HOLD_SIZE - Session->HeldLength)
+    {
+        SECURITY_APP_DropHold(Msg->SessionId);
+        SECURITY_APP_StreamError(Session, SECURITY_APP_STAT_ERR_LENGTH);
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Stream %d exceeds the %d byte decrypt hold, use the file commands",
+                         Msg->SessionId, SECURITY_APP_STREAM_HOLD_SIZE);
+        return CFE_SUCCESS;
+    }
+
+    if (Final)
+    {
+        memcpy(Tag, Msg->Tag, sizeof(Tag));
+        status = SECURITY_APP_StreamFinish(Msg->SessionId, Msg->Data, Msg->DataLength, Hold, Tag);
+    }
+    else
+    {
+        status = SECURITY_APP_StreamUpdate(Msg->SessionId, Msg->Data, Msg->DataLength, Hold);
+    }
+
+    if (status != 0 && !(Final && status == -7))
+    {
+        SECURITY_APP_DropHold(Msg->SessionId);
+        SECURITY_APP_StreamError(Session, SECURITY_APP_STAT_ERR_CIPHER);
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Stream %d segment %d failed with error: %d",
+                         Msg->SessionId, Msg->SegmentSeq, (int)status);
+        return CFE_SUCCESS;
+    }
+
+    Session->HeldLength += Msg->DataLength;
+    Session->TotalLength += Msg->DataLength;
+    Session->NextSeq++;
+
+    if (!Final)
+    {
+        return CFE_SUCCESS;
+    }
+
+    if (status == 0)
+    {
+        SECURITY_APP_ReleaseHold(Msg->SessionId, Session);
+        SECURITY_APP_CountSuccess(SECURITY_APP_OP_DECRYPT, Session->TotalLength);
+        Session->HeldLength = 0;
+        Session->InUse = FALSE;
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_INF_EID, CFE_EVS_INFORMATION,
+                         "SECURITY_APP: Stream %d closed after %d segments, %u bytes",
+                         Msg->SessionId, Session->NextSeq, (unsigned int)Session->TotalLength);
+        return CFE_SUCCESS;
+    }
+
+    /* A forged or truncated stream releases nothing but the verdict */
+    SECURITY_APP_DropHold(Msg->SessionId);
+    SECURITY_APP_StreamError(Session, SECURITY_APP_STAT_ERR_AUTH);
+    CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                     "SECURITY_APP: Stream %d failed authentication after %u bytes",
+                     Msg->SessionId, (unsigned int)Session->TotalLength);
+
+    StreamTlm = (SECURITY_APP_StreamTlm_t *)SECURITY_APP_AcquireOutput(&OutputBuf, Session->TargetMsgID,
+                                                                      offsetof(SECURITY_APP_StreamTlm_t, Data));
+    if (StreamTlm != NULL)
+    {
+        StreamTlm->SessionId = Msg->SessionId;
+        StreamTlm->Flags = SECURITY_APP_STREAM_FLAG_END | SECURITY_APP_STREAM_FLAG_AUTH_FAIL;
+        StreamTlm->Suite = Session->Suite;
+        StreamTlm->Direction = Session->Direction;
+        SECURITY_APP_SendOutput(&OutputBuf);
+    }
+
+    return CFE_SUCCESS;
+}
+
+/* Run one segment through the session cipher; encrypt segments are published as they go */
+static int32 SECURITY_APP_StreamSegment(const SECURITY_APP_StreamDataCmd_t *Msg, bool Final)
+{
+    SECURITY_APP_StreamSession_t *Session;
+    SECURITY_APP_OutputBuf_t OutputBuf;
+    SECURITY_APP_StreamTlm_t *StreamTlm;
+    int32_t status;
+
+    SECURITY_APP_Data.CmdCounter++;
+
+    Session = SECURITY_APP_GetStreamSession(Msg);
+    if (Session == NULL)
+    {
+        SECURITY_APP_StreamError(NULL, SECURITY_APP_STAT_ERR_SESSION);
+        return CFE_SUCCESS;
+    }
+
+    if (Session->Direction == SECURITY_APP_STREAM_DECRYPT)
+    {
+        return SECURITY_APP_StreamDecryptSegment(Msg, Session, Final);
+    }
+
+    StreamTlm = (SECURITY_APP_StreamTlm_t *)SECURITY_APP_AcquireOutput(&OutputBuf, Session->TargetMsgID,
+                                    offsetof(SECURITY_APP_StreamTlm_t, Data) + Msg->DataLength);
+    if (StreamTlm == NULL)
+    {
+        /* The segment was not consumed, so the sender may retry it */
+        SECURITY_APP_StreamError(Session, SECURITY_APP_STAT_ERR_BUFFER);
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Unable to get SB buffer for stream %d", Msg->SessionId);
+        return CFE_SUCCESS;
+    }
+
+    if (Final)
+    {
+        status = SECURITY_APP_StreamFinish(Msg->SessionId, Msg->Data, Msg->DataLength,
+                                           StreamTlm->Data, StreamTlm->Tag);
+        Session->InUse = FALSE;
+    }
+    else
+    {
+        status = SECURITY_APP_StreamUpdate(Msg->SessionId, Msg->Data, Msg->DataLength, StreamTlm->Data);
+    }
+
+    if (status != 0)
+    {
+        SECURITY_APP_ReleaseOutput(&OutputBuf);
+        SECURITY_APP_CloseStream(Msg->SessionId);
+        SECURITY_APP_StreamError(Session, SECURITY_APP_STAT_ERR_CIPHER);
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Stream %d segment %d failed with error: %d",
+                         Msg->SessionId, Msg->SegmentSeq, (int)status);
+        return CFE_SUCCESS;
+    }
+
+    Session->TotalLength += Msg->DataLength;
+
+    StreamTlm->SessionId = Msg->SessionId;
+    StreamTlm->SegmentSeq = Msg->SegmentSeq;
+    StreamTlm->DataLength = Msg->DataLength;
+    StreamTlm->Suite = Session->Suite;
+    StreamTlm->Direction = Session->Direction;
+    StreamTlm->TotalLength = Session->TotalLength;
+    if (Final)
+    {
+        StreamTlm->Flags = SECURITY_APP_STREAM_FLAG_END;
+    }
+
+    SECURITY_APP_SendOutput(&OutputBuf);
+
+    Session->NextSeq++;
+    SECURITY_APP_CountSuccess(SECURITY_APP_OP_ENCRYPT, Msg->DataLength);
+
+    if (Final)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_INF_EID, CFE_EVS_INFORMATION,
+                         "SECURITY_APP: Stream %d closed after %d segments, %u bytes",
+                         Msg->SessionId, Session->NextSeq, (unsigned int)Session->TotalLength);
+    }
+
+    return CFE_SUCCESS;
+}
+
+/* Stream begin command handler */
+int32 SECURITY_APP_StreamBeginCmd(const SECURITY_APP_StreamBeginCmd_t *Msg)
+{
+    SECURITY_APP_StreamSession_t *Session = NULL;
+    SECURITY_APP_OutputBuf_t OutputBuf;
+    SECURITY_APP_StreamTlm_t *StreamTlm;
+    uint8 SessionId;
+    int32_t status;
+
+    SECURITY_APP_Data.CmdCounter++;
+
+    for (SessionId = 0; SessionId < SECURITY_APP_MAX_STREAMS; SessionId++)
+    {
+        if (!SECURITY_APP_Data.Streams[SessionId].InUse)
+        {
+            Session = &SECURITY_APP_Data.Streams[SessionId];
+            break;
+        }
+    }
+
+    if (Session == NULL)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: No free stream sessions (max %d)", SECURITY_APP_MAX_STREAMS);
+        return CFE_SUCCESS;
+    }
+
+    if (Msg->Direction != SECURITY_APP_STREAM_ENCRYPT && Msg->Direction != SECURITY_APP_STREAM_DECRYPT)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Invalid stream direction: %d", Msg->Direction);
+        return CFE_SUCCESS;
+    }
+
+    StreamTlm = (SECURITY_APP_StreamTlm_t *)SECURITY_APP_AcquireOutput(&OutputBuf, Msg->TargetMsgID,
+                                                                      offsetof(SECURITY_APP_StreamTlm_t, Data));
+    if (StreamTlm == NULL)
+    {
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Unable to get SB buffer for stream begin");
+        return CFE_SUCCESS;
+    }
+
+    memcpy(StreamTlm->IV, Msg->IV, sizeof(StreamTlm->IV));
+    status = SECURITY_APP_StreamBegin(SessionId, SECURITY_APP_MAIN_CHANNEL, Msg->KeyId, Msg->Suite,
+                                      Msg->Direction == SECURITY_APP_STREAM_ENCRYPT, StreamTlm->IV);
+    if (status != 0)
+    {
+        SECURITY_APP_ReleaseOutput(&OutputBuf);
+        SECURITY_APP_Data.ErrCounter++;
+        CFE_EVS_SendEvent(SECURITY_APP_STREAM_ERR_EID, CFE_EVS_ERROR,
+                         "SECURITY_APP: Stream begin failed for suite %d, key ID %d with error: %d",
+                         Msg->Suite, Msg->KeyId, (int)status);
+        return CFE_SUCCESS;
+    }
+
+    Session->InUse = TRUE;
+    Session->Suite = Msg->Suite;
+    Session->Direction = Msg->Direction;
+    Session->TargetMsgID = Msg->TargetMsgID;
+    Session->NextSeq = 0;
+    Session->TotalLength = 0;
+    Session->HeldLength = 0;
+
+    StreamTlm->SessionId = SessionId;
+    StreamTlm->Flags = SECURITY_APP_STREAM_FLAG_BEGIN;
+    StreamTlm->Suite = Session->Suite;
+    StreamTlm->Direction = Session->Direction;
+
+    SECURITY_APP_SendOutput(&OutputBuf);
+
+    CFE_EVS_SendEvent(SECURITY_APP_STREAM_INF_EID, CFE_EVS_INFORMATION,
+                     "SECURITY_APP: Stream %d opened, suite %d, output MID 0x%04X",
+                     SessionId, Session->Suite, Session->TargetMsgID);
+
+    return CFE_SUCCESS;
+}
+
+/* Stream append command handler */
+int32 SECURITY_APP_StreamAppendCmd(const SECURITY_APP_StreamAppendCmd_t *Msg)
+{
+    return SECURITY_APP_StreamSegment(Msg, FALSE);
+}
+
+/* Stream end command handler */
+int32 SECURITY_APP_StreamEndCmd(const SECURITY_APP_StreamEndCmd_t *Msg)
+{
+    return SECURITY_APP_StreamSegment(Msg, TRUE);
+}
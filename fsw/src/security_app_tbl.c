@@ -0,0 +1,197 @@
+#include "security_app.h"
+#include "security_app_crypto.h"
+#include "security_app_events.h"
+#include "security_app_load.h"
+
+/* Check a candidate inline table before cFE TBL accepts it */
+int32 SECURITY_APP_ValidateInlineTbl(void *TblData)
+{
+    const SECURITY_APP_InlineTbl_t *Tbl = (const SECURITY_APP_InlineTbl_t *)TblData;
+    const SECURITY_APP_InlineEntry_t *Entry;
+    uint16 i;
+    uint16 j;
+
+    for (i = 0; i < SECURITY_APP_INLINE_TBL_MAX_ENTRIES; i++)
+    {
+        Entry = &Tbl->Entries[i];
+        if (!Entry->Enabled)
+        {
+            continue;
+        }
+
+        /* Intercepted packets are encrypted, never sent on in the clear with a tag */
+        if (Entry->Suite >= SECURITY_APP_SUITE_COUNT || SECURITY_APP_SuiteAuthOnly(Entry->Suite))
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                             "Inline table entry %d: invalid suite %d", i, Entry->Suite);
+            return SECURITY_APP_ERROR;
+        }
+
+        if (Entry->KeyId >= SECURITY_APP_MAX_KEYS)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                             "Inline table entry %d: invalid key ID %d", i, Entry->KeyId);
+            return SECURITY_APP_ERROR;
+        }
+
+        if ((Entry->Options & ~SECURITY_APP_OPT_KNOWN) != 0)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                             "Inline table entry %d: unknown options 0x%02X", i, Entry->Options);
+            return SECURITY_APP_ERROR;
+        }
+
+        if (Entry->Priority > SECURITY_APP_PRIO_LOW)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                             "Inline table entry %d: invalid priority %d", i, Entry->Priority);
+            return SECURITY_APP_ERROR;
+        }
+
+        /* The app's own traffic can never be intercepted */
+        if (Entry->InputMsgID == SECURITY_APP_CMD_MID || Entry->InputMsgID == SECURITY_APP_DATA_CMD_MID ||
+            Entry->InputMsgID == SECURITY_APP_SEND_HK_MID || Entry->InputMsgID == SECURITY_APP_SEND_PERF_MID ||
+            Entry->InputMsgID == SECURITY_APP_WAKEUP_MID || Entry->InputMsgID == SECURITY_APP_HK_TLM_MID)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                             "Inline table entry %d: input MID 0x%04X is reserved", i, Entry->InputMsgID);
+            return SECURITY_APP_ERROR;
+        }
+
+        /* Duplicates would subscribe twice, and output-as-input would loop */
+        for (j = 0; j < SECURITY_APP_INLINE_TBL_MAX_ENTRIES; j++)
+        {
+            if (!Tbl->Entries[j].Enabled)
+            {
+                continue;
+            }
+
+            if ((j != i && Tbl->Entries[j].InputMsgID == Entry->InputMsgID) ||
+                Tbl->Entries[j].OutputMsgID == Entry->InputMsgID)
+            {
+                CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                                 "Inline table entry %d: input MID 0x%04X conflicts with entry %d",
+                                 i, Entry->InputMsgID, j);
+                return SECURITY_APP_ERROR;
+            }
+        }
+    }
+
+    return CFE_SUCCESS;
+}
+
+/*
+** Copy the enabled entries out of the table and move the pipe subscriptions
+** over to them. The working copy means the per-packet lookup never touches
+** the table itself.
+*/
+static void SECURITY_APP_RefreshInlineMap(void)
+{
+    SECURITY_APP_InlineTbl_t *Tbl;
+    uint16 i;
+    int32 status;
+
+    for (i = 0; i < SECURITY_APP_Data.InlineCount; i++)
+    {
+        CFE_SB_Unsubscribe(SECURITY_APP_Data.InlineMap[i].InputMsgID, SECURITY_APP_Data.DataPipe);
+    }
+    SECURITY_APP_Data.InlineCount = 0;
+
+    status = CFE_TBL_GetAddress((void **)&Tbl, SECURITY_APP_Data.InlineTblHandle);
+    if (status != CFE_SUCCESS && status != CFE_TBL_INFO_UPDATED)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                         "Error getting inline table address, RC = 0x%08X", (unsigned int)status);
+        return;
+    }
+
+    for (i = 0; i < SECURITY_APP_INLINE_TBL_MAX_ENTRIES; i++)
+    {
+        if (!Tbl->Entries[i].Enabled)
+        {
+            continue;
+        }
+
+        status = CFE_SB_Subscribe(Tbl->Entries[i].InputMsgID, SECURITY_APP_Data.DataPipe);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                             "Error subscribing to inline MID 0x%04X, RC = 0x%08X",
+                             Tbl->Entries[i].InputMsgID, (unsigned int)status);
+            continue;
+        }
+
+        SECURITY_APP_Data.InlineMap[SECURITY_APP_Data.InlineCount++] = Tbl->Entries[i];
+    }
+
+    CFE_TBL_ReleaseAddress(SECURITY_APP_Data.InlineTblHandle);
+
+    SECURITY_APP_LoadRefreshSources();
+
+    CFE_EVS_SendEvent(SECURITY_APP_TBL_INF_EID, CFE_EVS_INFORMATION,
+                     "SECURITY_APP: Inline table active with %d entries", SECURITY_APP_Data.InlineCount);
+}
+
+/* Register and load the inline table, then subscribe to its input MIDs */
+int32 SECURITY_APP_InitInlineTbl(void)
+{
+    int32 status;
+
+    SECURITY_APP_Data.InlineCount = 0;
+
+    status = CFE_TBL_Register(&SECURITY_APP_Data.InlineTblHandle, SECURITY_APP_INLINE_TBL_NAME,
+                              sizeof(SECURITY_APP_InlineTbl_t), CFE_TBL_OPT_DEFAULT,
+                              SECURITY_APP_ValidateInlineTbl);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                         "Error registering inline table, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    /* Without a table the app still serves commands; a later load enables inline mode */
+    status = CFE_TBL_Load(SECURITY_APP_Data.InlineTblHandle, CFE_TBL_SRC_FILE, SECURITY_APP_INLINE_TBL_FILENAME);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_TBL_ERR_EID, CFE_EVS_ERROR,
+                         "Error loading inline table %s, RC = 0x%08X",
+                         SECURITY_APP_INLINE_TBL_FILENAME, (unsigned int)status);
+        return CFE_SUCCESS;
+    }
+
+    SECURITY_APP_RefreshInlineMap();
+
+    return CFE_SUCCESS;
+}
+
+/* Let cFE TBL apply pending loads; pick up a new table without a restart */
+void SECURITY_APP_ManageInlineTbl(void)
+{
+    if (CFE_TBL_Manage(SECURITY_APP_Data.InlineTblHandle) == CFE_TBL_INFO_UPDATED)
+    {
+        SECURITY_APP_RefreshInlineMap();
+    }
+}
+
+/* Find the active inline entry for a message ID, or NULL */
+const SECURITY_APP_InlineEntry_t *SECURITY_APP_FindInlineEntry(CFE_SB_MsgId_t MsgId)
+{
+    uint16 i;
+
+    for (i = 0; i < SECURITY_APP_Data.InlineCount; i++)
+    {
+        if (SECURITY_APP_Data.InlineMap[i].InputMsgID == MsgId)
+        {
+            return &SECURITY_APP_Data.InlineMap[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Encrypt an intercepted packet, header included, straight from the SB buffer */
+int32 SECURITY_APP_InlineEncrypt(CFE_SB_MsgPtr_t Msg, const SECURITY_APP_InlineEntry_t *Entry)
+{
+    return SECURITY_APP_EncryptRecord((const uint8 *)Msg, CFE_SB_GetTotalMsgLength(Msg),
+                                      Entry->OutputMsgID, Entry->Suite, Entry->KeyId, Entry->Options, FALSE);
+}
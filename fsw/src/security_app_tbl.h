@@ -0,0 +1,64 @@
+#ifndef SECURITY_APP_TBL_H
+#define SECURITY_APP_TBL_H
+
+#include "common_types.h"
+#include "security_app_platform_cfg.h"
+
+/*
+** Inline encryption table
+**
+** Each enabled entry makes the app subscribe to InputMsgID and encrypt every
+** matching packet, header included, straight from the SB buffer. The result
+** is published as a SECURITY_APP_EncryptedTlm_t on OutputMsgID. Unused
+** entries have Enabled set to 0.
+**
+** Priority decides what happens to the stream while the data pipe is
+** congested: critical streams are always encrypted, normal ones are set
+** aside until the pipe drains, and low ones are dropped.
+*/
+#define SECURITY_APP_PRIO_CRITICAL      0
+#define SECURITY_APP_PRIO_NORMAL        1
+#define SECURITY_APP_PRIO_LOW           2
+
+typedef struct
+{
+    uint16  InputMsgID;                 /* Message ID to intercept */
+    uint16  OutputMsgID;                /* Message ID for the encrypted packet */
+    uint8   Suite;                      /* Encrypting cipher suite; GMAC and Poly1305 are refused */
+    uint8   Enabled;                    /* 1 = active, 0 = unused entry */
+    uint8   KeyId;                      /* Key table entry */
+    uint8   Options;                    /* SECURITY_APP_OPT_* flags */
+    uint8   Priority;                   /* SECURITY_APP_PRIO_* under congestion */
+    uint8   Spare;
+
+} SECURITY_APP_InlineEntry_t;
+
+typedef struct
+{
+    SECURITY_APP_InlineEntry_t  Entries[SECURITY_APP_INLINE_TBL_MAX_ENTRIES];
+
+} SECURITY_APP_InlineTbl_t;
+
+/*
+** Key table
+**
+** Entry n holds key ID n. When a new table is loaded, every enabled entry
+** whose key differs from the one in service is expanded and swapped in
+** without interrupting traffic; disabled entries take their key out of
+** service. Operations naming a key ID without an enabled entry fail.
+*/
+typedef struct
+{
+    uint8   Enabled;                    /* 1 = key in service, 0 = no key */
+    uint8   Spare[3];
+    uint8   Key[32];                    /* AES-256 / ChaCha20 key */
+
+} SECURITY_APP_KeyEntry_t;
+
+typedef struct
+{
+    SECURITY_APP_KeyEntry_t  Entries[SECURITY_APP_MAX_KEYS];
+
+} SECURITY_APP_KeyTbl_t;
+
+#endif /* SECURITY_APP_TBL_H */
@@ -0,0 +1,57 @@
+#include "security_app_wire.h"
+#include "security_app_crypto.h"
+
+#include <stddef.h>
+
+/*
+** Suite and key ID share one header byte, and the payload of every packet
+** that carries a record must start on a 16-byte boundary
+*/
+CompileTimeAssert(SECURITY_APP_SUITE_COUNT <= 16, WireSuiteFitsNibble);
+CompileTimeAssert(SECURITY_APP_MAX_KEYS <= 16, WireKeyIdFitsNibble);
+CompileTimeAssert(SECURITY_APP_WIRE_AAD_SIZE + SECURITY_APP_WIRE_NONCE_SIZE == SECURITY_APP_WIRE_HDR_SIZE,
+                  WireHeaderLayout);
+CompileTimeAssert(SECURITY_APP_MAX_PAYLOAD_LENGTH >= SECURITY_APP_MAX_DATA_LENGTH + SECURITY_APP_TAG_SIZE,
+                  WirePayloadHoldsTag);
+CompileTimeAssert((offsetof(SECURITY_APP_EncryptedTlm_t, Record) + SECURITY_APP_WIRE_HDR_SIZE) % 16 == 0,
+                  WireEncryptedTlmPayloadAligned);
+CompileTimeAssert((offsetof(SECURITY_APP_DecryptCmd_t, Record) + SECURITY_APP_WIRE_HDR_SIZE) % 16 == 0,
+                  WireDecryptCmdPayloadAligned);
+CompileTimeAssert(offsetof(SECURITY_APP_EncryptCmd_t, Data) % 16 == 0, WireEncryptCmdDataAligned);
+CompileTimeAssert(offsetof(SECURITY_APP_DecryptedTlm_t, Data) % 16 == 0, WireDecryptedTlmDataAligned);
+CompileTimeAssert(offsetof(SECURITY_APP_StreamDataCmd_t, Data) % 16 == 0, WireStreamCmdDataAligned);
+CompileTimeAssert(offsetof(SECURITY_APP_StreamTlm_t, Data) % 16 == 0, WireStreamTlmDataAligned);
+
+/* Write a header to the first SECURITY_APP_WIRE_HDR_SIZE bytes of a record */
+void SECURITY_APP_WirePack(uint8 *Record, const SECURITY_APP_WireHdr_t *Hdr)
+{
+    Record[0] = (uint8)((Hdr->Version << 4) | (Hdr->Flags & 0x0F));
+    Record[1] = (uint8)((Hdr->Suite << 4) | (Hdr->KeyId & 0x0F));
+    Record[2] = (uint8)(Hdr->DataLength >> 8);
+    Record[3] = (uint8)(Hdr->DataLength);
+    Record[4] = (uint8)(Hdr->Sequence >> 24);
+    Record[5] = (uint8)(Hdr->Sequence >> 16);
+    Record[6] = (uint8)(Hdr->Sequence >> 8);
+    Record[7] = (uint8)(Hdr->Sequence);
+    memcpy(&Record[8], Hdr->Nonce, SECURITY_APP_WIRE_NONCE_SIZE);
+}
+
+/* Read a record's header; fails on a version or flags this build does not know */
+int32 SECURITY_APP_WireUnpack(SECURITY_APP_WireHdr_t *Hdr, const uint8 *Record)
+{
+    Hdr->Version = Record[0] >> 4;
+    Hdr->Flags = Record[0] & 0x0F;
+    Hdr->Suite = Record[1] >> 4;
+    Hdr->KeyId = Record[1] & 0x0F;
+    Hdr->DataLength = (uint16)((Record[2] << 8) | Record[3]);
+    Hdr->Sequence = ((uint32)Record[4] << 24) | ((uint32)Record[5] << 16) | ((uint32)Record[6] << 8) | Record[7];
+    memcpy(Hdr->Nonce, &Record[8], SECURITY_APP_WIRE_NONCE_SIZE);
+    memset(&Hdr->Nonce[SECURITY_APP_WIRE_NONCE_SIZE], 0, sizeof(Hdr->Nonce) - SECURITY_APP_WIRE_NONCE_SIZE);
+
+    if (Hdr->Version != SECURITY_APP_WIRE_VERSION || (Hdr->Flags & ~SECURITY_APP_WIRE_FLAGS_KNOWN) != 0)
+    {
+        return SECURITY_APP_ERROR;
+    }
+
+    return SECURITY_APP_SUCCESS;
+}
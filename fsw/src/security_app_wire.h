@@ -0,0 +1,35 @@
+#ifndef SECURITY_APP_WIRE_H
+#define SECURITY_APP_WIRE_H
+
+#include "security_app.h"
+
+/*
+** Ciphertext wire format header (see security_app_msg.h for the byte
+** layout). Records can sit at any byte offset, so the header is only ever
+** read and written a byte at a time through these helpers.
+*/
+typedef struct
+{
+    uint8   Version;                    /* SECURITY_APP_WIRE_VERSION */
+    uint8   Flags;                      /* SECURITY_APP_WIRE_FLAG_* */
+    uint8   Suite;                      /* Cipher suite (SECURITY_APP_SUITE_*) */
+    uint8   KeyId;                      /* Key table entry */
+    uint16  DataLength;                 /* Plaintext length */
+    uint32  Sequence;                   /* Per-key sequence number */
+    uint8   Nonce[16];                  /* Full IV: the wire nonce, then zeros */
+
+} SECURITY_APP_WireHdr_t;
+
+/* Flag bits */
+#define SECURITY_APP_WIRE_FLAG_COMPRESSED   0x01    /* Payload compressed before encryption */
+
+/* Flag bits this version understands; a record with any other bit set is rejected */
+#define SECURITY_APP_WIRE_FLAGS_KNOWN   (SECURITY_APP_WIRE_FLAG_COMPRESSED)
+
+/* Start of the payload in a record */
+#define SECURITY_APP_WIRE_PAYLOAD(Record)   ((Record) + SECURITY_APP_WIRE_HDR_SIZE)
+
+void SECURITY_APP_WirePack(uint8 *Record, const SECURITY_APP_WireHdr_t *Hdr);
+int32 SECURITY_APP_WireUnpack(SECURITY_APP_WireHdr_t *Hdr, const uint8 *Record);
+
+#endif /* SECURITY_APP_WIRE_H */
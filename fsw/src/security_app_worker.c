@@ -0,0 +1,263 @@
+#include "security_app.h"
+#include "security_app_acct.h"
+#include "security_app_crypto.h"
+#include "security_app_events.h"
+#include "security_app_perf.h"
+#include "security_app_worker.h"
+
+#include <stdio.h>
+
+#if (SECURITY_APP_NUM_WORKERS > 0)
+
+/*
+** One in-flight job. The main task fills the request half, the worker fills
+** the result half, and the output task publishes it.
+*/
+typedef struct
+{
+    uint8                     Operation;
+    uint8                     Suite;
+    uint8                     KeyId;
+    uint8                     Options;
+    bool                      Notify;
+    uint16                    DataLength;
+    CFE_SB_MsgId_t            TargetMsgID;
+    uint8                     Data[SECURITY_APP_MAX_RECORD_LENGTH];
+
+    int32                     Status;
+    uint16                    ResultLength;
+    SECURITY_APP_OutputBuf_t  OutputBuf;
+
+} SECURITY_APP_WorkerSlot_t;
+
+/*
+** Ring indices only ever increase; each is written by one task and kept on
+** its own cache line.
+*/
+typedef struct
+{
+    uint32  Head __attribute__((aligned(64)));     /* Next slot to fill (main task) */
+    uint32  Done __attribute__((aligned(64)));     /* Next slot to process (worker) */
+    uint32  Tail __attribute__((aligned(64)));     /* Next slot to publish (output task) */
+    uint32  JobSemId;
+    uint32  FreeSemId;                             /* Free slots, given by the output task */
+    uint32  TaskId;
+
+    SECURITY_APP_WorkerSlot_t  Slots[SECURITY_APP_WORKER_QUEUE_DEPTH];
+
+} SECURITY_APP_WorkerRing_t;
+
+typedef struct
+{
+    SECURITY_APP_WorkerRing_t  Rings[SECURITY_APP_NUM_WORKERS];
+
+    uint32  NextSubmit;         /* Sequence of the next job (main task) */
+    uint32  NextPublish;        /* Sequence of the next result (output task) */
+    uint32  NextWorkerIndex;    /* Ring assignment at worker startup */
+    uint32  DoneSemId;
+    uint32  OutputTaskId;
+
+} SECURITY_APP_WorkerPool_t;
+
+static SECURITY_APP_WorkerPool_t SECURITY_APP_Pool;
+
+/* Create the ring semaphores, the output task and the worker tasks */
+int32 SECURITY_APP_InitWorkers(void)
+{
+    char   Name[20];
+    uint32 i;
+    int32  status;
+
+    memset(&SECURITY_APP_Pool, 0, sizeof(SECURITY_APP_Pool));
+
+    status = OS_CountSemCreate(&SECURITY_APP_Pool.DoneSemId, "SECAPP_DONE", 0, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_WORKER_ERR_EID, CFE_EVS_ERROR,
+                         "Error creating worker done semaphore, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    for (i = 0; i < SECURITY_APP_NUM_WORKERS; i++)
+    {
+        snprintf(Name, sizeof(Name), "SECAPP_JOB%u", (unsigned int)i);
+        status = OS_CountSemCreate(&SECURITY_APP_Pool.Rings[i].JobSemId, Name, 0, 0);
+        if (status != OS_SUCCESS)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_WORKER_ERR_EID, CFE_EVS_ERROR,
+                             "Error creating worker %u job semaphore, RC = 0x%08X",
+                             (unsigned int)i, (unsigned int)status);
+            return status;
+        }
+
+        snprintf(Name, sizeof(Name), "SECAPP_FREE%u", (unsigned int)i);
+        status = OS_CountSemCreate(&SECURITY_APP_Pool.Rings[i].FreeSemId, Name,
+                                   SECURITY_APP_WORKER_QUEUE_DEPTH, 0);
+        if (status != OS_SUCCESS)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_WORKER_ERR_EID, CFE_EVS_ERROR,
+                             "Error creating worker %u free slot semaphore, RC = 0x%08X",
+                             (unsigned int)i, (unsigned int)status);
+            return status;
+        }
+    }
+
+    status = CFE_ES_CreateChildTask(&SECURITY_APP_Pool.OutputTaskId, "SECURITY_OUT",
+                                    SECURITY_APP_OutputMain, NULL, SECURITY_APP_WORKER_STACK_SIZE,
+                                    SECURITY_APP_OUTPUT_PRIORITY, 0);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(SECURITY_APP_WORKER_ERR_EID, CFE_EVS_ERROR,
+                         "Error creating output task, RC = 0x%08X", (unsigned int)status);
+        return status;
+    }
+
+    for (i = 0; i < SECURITY_APP_NUM_WORKERS; i++)
+    {
+        snprintf(Name, sizeof(Name), "SECURITY_WKR%u", (unsigned int)i);
+        status = CFE_ES_CreateChildTask(&SECURITY_APP_Pool.Rings[i].TaskId, Name,
+                                        SECURITY_APP_WorkerMain, NULL, SECURITY_APP_WORKER_STACK_SIZE,
+                                        SECURITY_APP_WORKER_PRIORITY, 0);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(SECURITY_APP_WORKER_ERR_EID, CFE_EVS_ERROR,
+                             "Error creating worker task %u, RC = 0x%08X",
+                             (unsigned int)i, (unsigned int)status);
+            return status;
+        }
+    }
+
+    return CFE_SUCCESS;
+}
+
+/* Queue one job on the next worker in round-robin order (main task only) */
+int32 SECURITY_APP_SubmitJob(uint8 Operation, const uint8 *Data, uint16 DataLength,
+                             CFE_SB_MsgId_t TargetMsgID, uint8 Suite, uint8 KeyId, uint8 Options, bool Notify)
+{
+    SECURITY_APP_WorkerRing_t *Ring;
+    SECURITY_APP_WorkerSlot_t *Slot;
+    uint32 Head;
+
+    Ring = &SECURITY_APP_Pool.Rings[SECURITY_APP_Pool.NextSubmit % SECURITY_APP_NUM_WORKERS];
+    Head = Ring->Head;
+
+    /* Block until the output task frees a slot rather than reorder or drop */
+    if (OS_CountSemTake(Ring->FreeSemId) != OS_SUCCESS)
+    {
+        return SECURITY_APP_ERROR;
+    }
+
+    Slot = &Ring->Slots[Head % SECURITY_APP_WORKER_QUEUE_DEPTH];
+    Slot->Operation = Operation;
+    Slot->Suite = Suite;
+    Slot->KeyId = KeyId;
+    Slot->Options = Options;
+    Slot->Notify = Notify;
+    Slot->TargetMsgID = TargetMsgID;
+
+    /* Oversized lengths are passed through so the worker reports them */
+    Slot->DataLength = DataLength;
+    memcpy(Slot->Data, Data, DataLength < SECURITY_APP_MAX_RECORD_LENGTH ? DataLength : SECURITY_APP_MAX_RECORD_LENGTH);
+
+    __atomic_store_n(&Ring->Head, Head + 1, __ATOMIC_RELEASE);
+    OS_CountSemGive(Ring->JobSemId);
+
+    SECURITY_APP_Pool.NextSubmit++;
+
+    return SECURITY_APP_SUCCESS;
+}
+
+/* Worker task: process jobs from this worker's ring on its own crypto channel */
+void SECURITY_APP_WorkerMain(void)
+{
+    SECURITY_APP_WorkerRing_t *Ring;
+    SECURITY_APP_WorkerSlot_t *Slot;
+    uint32 Index;
+    uint32 Done;
+    uint64 Start;
+    uint8  Channel;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    Index = __atomic_fetch_add(&SECURITY_APP_Pool.NextWorkerIndex, 1, __ATOMIC_RELAXED);
+    Ring = &SECURITY_APP_Pool.Rings[Index];
+    Channel = SECURITY_APP_MAIN_CHANNEL + 1 + Index;
+
+    while (OS_CountSemTake(Ring->JobSemId) == OS_SUCCESS)
+    {
+        Done = Ring->Done;
+        if (Done == __atomic_load_n(&Ring->Head, __ATOMIC_ACQUIRE))
+        {
+            continue;
+        }
+
+        Slot = &Ring->Slots[Done % SECURITY_APP_WORKER_QUEUE_DEPTH];
+        Start = SECURITY_APP_PerfNow();
+
+        if (Slot->Operation == SECURITY_APP_OP_ENCRYPT)
+        {
+            Slot->Status = SECURITY_APP_EncryptPayload(Channel, Slot->Data, Slot->DataLength, Slot->TargetMsgID,
+                                                       Slot->Suite, Slot->KeyId, Slot->Options, &Slot->OutputBuf);
+            Slot->ResultLength = Slot->DataLength;
+        }
+        else
+        {
+            Slot->Status = SECURITY_APP_DecryptPayload(Channel, Slot->Data, Slot->DataLength, Slot->TargetMsgID,
+                                                       &Slot->OutputBuf, &Slot->ResultLength);
+        }
+
+        SECURITY_APP_AcctRecord(Slot->TargetMsgID, Slot->Operation, Slot->ResultLength,
+                                Slot->Status == SECURITY_APP_SUCCESS, Start);
+
+        __atomic_store_n(&Ring->Done, Done + 1, __ATOMIC_RELEASE);
+        OS_CountSemGive(SECURITY_APP_Pool.DoneSemId);
+    }
+
+    CFE_ES_ExitChildTask();
+}
+
+/* Output task: publish finished jobs in submission order */
+void SECURITY_APP_OutputMain(void)
+{
+    SECURITY_APP_WorkerRing_t *Ring;
+    SECURITY_APP_WorkerSlot_t *Slot;
+    uint32 Tail;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    while (OS_CountSemTake(SECURITY_APP_Pool.DoneSemId) == OS_SUCCESS)
+    {
+        /* Stop at the first job in sequence that is still being processed */
+        for (;;)
+        {
+            Ring = &SECURITY_APP_Pool.Rings[SECURITY_APP_Pool.NextPublish % SECURITY_APP_NUM_WORKERS];
+            Tail = Ring->Tail;
+            if (Tail == __atomic_load_n(&Ring->Done, __ATOMIC_ACQUIRE))
+            {
+                break;
+            }
+
+            Slot = &Ring->Slots[Tail % SECURITY_APP_WORKER_QUEUE_DEPTH];
+            if (Slot->Status == SECURITY_APP_SUCCESS)
+            {
+                SECURITY_APP_PublishResult(Slot->Operation, &Slot->OutputBuf, Slot->ResultLength, Slot->Notify);
+            }
+
+            __atomic_store_n(&Ring->Tail, Tail + 1, __ATOMIC_RELEASE);
+            OS_CountSemGive(Ring->FreeSemId);
+            SECURITY_APP_Pool.NextPublish++;
+        }
+    }
+
+    CFE_ES_ExitChildTask();
+}
+
+#endif /* SECURITY_APP_NUM_WORKERS > 0 */
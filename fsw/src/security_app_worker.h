@@ -0,0 +1,29 @@
+#ifndef SECURITY_APP_WORKER_H
+#define SECURITY_APP_WORKER_H
+
+#include "security_app.h"
+
+/*
+** Crypto worker pool
+**
+** The main task copies each encrypt/decrypt job into the ring of the next
+** worker in round-robin order. Each ring has one producer (main task), one
+** processor (its worker) and one consumer (the output task), and each index
+** is written by exactly one of them, so no locks are needed; a full ring
+** blocks the main task on a counting semaphore of free slots, which the
+** output task gives as it publishes each result. The output task
+** visits the rings in the same round-robin order, which publishes results in
+** the order the jobs were submitted. Stream sessions stay on the main task
+** and are not re-sequenced against pool output.
+*/
+#if (SECURITY_APP_NUM_WORKERS > 0)
+
+int32 SECURITY_APP_InitWorkers(void);
+int32 SECURITY_APP_SubmitJob(uint8 Operation, const uint8 *Data, uint16 DataLength,
+                             CFE_SB_MsgId_t TargetMsgID, uint8 Suite, uint8 KeyId, uint8 Options, bool Notify);
+void SECURITY_APP_WorkerMain(void);
+void SECURITY_APP_OutputMain(void);
+
+#endif
+
+#endif /* SECURITY_APP_WORKER_H */
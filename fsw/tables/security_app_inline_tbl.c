@@ -0,0 +1,18 @@
+#include "cfe_tbl_filedef.h"
+#include "security_app_tbl.h"
+#include "security_app_crypto.h"
+
+/*
+** Default inline encryption table: no streams are intercepted until the
+** mission loads a table with enabled entries.
+*/
+SECURITY_APP_InlineTbl_t SECURITY_APP_InlineTbl =
+{
+    .Entries =
+    {
+        /* InputMsgID, OutputMsgID, Suite, Enabled, KeyId, Options, Priority, Spare */
+        { 0x0000, 0x0000, SECURITY_APP_SUITE_AES256_GCM, 0, 0, 0, SECURITY_APP_PRIO_CRITICAL, 0 },
+    }
+};
+
+CFE_TBL_FILEDEF(SECURITY_APP_InlineTbl, SECURITY_APP.InlineTbl, Security App inline encryption table, security_app_inline_tbl.tbl)
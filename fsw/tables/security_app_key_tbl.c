@@ -0,0 +1,21 @@
+#include "cfe_tbl_filedef.h"
+#include "security_app_tbl.h"
+
+/*
+** Default key table: key ID 0 holds the development key the app has always
+** used, so existing ground setups keep working. Replace it before flight.
+*/
+SECURITY_APP_KeyTbl_t SECURITY_APP_KeyTbl =
+{
+    .Entries =
+    {
+        /* Enabled, Spare, Key */
+        { 1, { 0, 0, 0 },
+          { 0x4d, 0x79, 0x53, 0x65, 0x63, 0x72, 0x65, 0x74,
+            0x41, 0x45, 0x53, 0x32, 0x35, 0x36, 0x45, 0x6e,
+            0x63, 0x72, 0x79, 0x70, 0x74, 0x69, 0x6f, 0x6e,
+            0x4b, 0x65, 0x79, 0x32, 0x30, 0x32, 0x35, 0x21 } },
+    }
+};
+
+CFE_TBL_FILEDEF(SECURITY_APP_KeyTbl, SECURITY_APP.KeyTbl, Security App key table, security_app_key_tbl.tbl)